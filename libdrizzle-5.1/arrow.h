@@ -0,0 +1,103 @@
+/* vim:expandtab:shiftwidth=2:tabstop=2:smarttab:
+ *
+ * Drizzle Client & Protocol Library
+ *
+ * Copyright (C) 2012-2013 Drizzle Developer Group
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following disclaimer
+ * in the documentation and/or other materials provided with the
+ * distribution.
+ *
+ *     * The names of its contributors may not be used to endorse or
+ * promote products derived from this software without specific prior
+ * written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+/**
+ * @file
+ * @brief Arrow IPC Export Declarations
+ */
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @addtogroup drizzle_arrow Arrow IPC Export Declarations
+ * @ingroup drizzle_client_interface
+ *
+ * These functions read the rows of a result and write them as an Apache
+ * Arrow IPC stream: a schema message, one record batch message per
+ * batch_rows rows and an end of stream marker. Rows are read into the
+ * column vectors of drizzle_result_buffer_columnar(), which are reused for
+ * every batch, so memory use follows the batch size and not the size of the
+ * result.
+ *
+ * Every field is nullable. The fixed width columns of binary rows become
+ * Int or FloatingPoint fields, binary string columns LargeBinary fields and
+ * every other column a LargeUtf8 field. Columns of text results are always
+ * strings, prepared statements give typed numbers. TIME, DATE, DATETIME and
+ * TIMESTAMP columns of binary rows are written in the text form the server
+ * uses.
+ * @{
+ */
+
+/**
+ * Write the rows of a result to a file descriptor as an Arrow IPC stream.
+ *
+ * @param[in,out] result A result object whose rows have not been read yet
+ * @param[in] fd The file descriptor to write to
+ * @param[in] batch_rows The maximum number of rows per record batch, 0 for
+ *                       DRIZZLE_DEFAULT_ARROW_BATCH_ROWS
+ * @return Standard drizzle return value. DRIZZLE_RETURN_ERRNO if a write
+ *         failed.
+ */
+DRIZZLE_API
+drizzle_return_t drizzle_result_arrow_fd(drizzle_result_st *result, int fd,
+                                         uint64_t batch_rows);
+
+/**
+ * Write the rows of a result to memory as an Arrow IPC stream.
+ *
+ * @param[in,out] result A result object whose rows have not been read yet
+ * @param[in] batch_rows The maximum number of rows per record batch, 0 for
+ *                       DRIZZLE_DEFAULT_ARROW_BATCH_ROWS
+ * @param[out] data The stream, to be freed by the caller with free()
+ * @param[out] size The size of the stream in bytes
+ * @return Standard drizzle return value.
+ */
+DRIZZLE_API
+drizzle_return_t drizzle_result_arrow_memory(drizzle_result_st *result,
+                                             uint64_t batch_rows,
+                                             void **data, size_t *size);
+
+/** @} */
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,166 @@
+/* vim:expandtab:shiftwidth=2:tabstop=2:smarttab:
+ *
+ * Drizzle Client & Protocol Library
+ *
+ * Copyright (C) 2012-2013 Drizzle Developer Group
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following disclaimer
+ * in the documentation and/or other materials provided with the
+ * distribution.
+ *
+ *     * The names of its contributors may not be used to endorse or
+ * promote products derived from this software without specific prior
+ * written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/**
+ * @file
+ * @brief Columnar Result Declarations
+ */
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @addtogroup drizzle_columnar Columnar Result Declarations
+ * @ingroup drizzle_client_interface
+ *
+ * drizzle_result_buffer_columnar() buffers a result by column instead of by
+ * row, so a scan over one column reads a single array. Each column is kept
+ * as:
+ *
+ * - an array of drizzle_result_column_width() bytes per row for the fixed
+ *   width types of binary rows: TINY, SHORT, YEAR, INT24, LONG, LONGLONG,
+ *   FLOAT and DOUBLE. Integers are stored as unsigned or signed integers of
+ *   that width and floating point values as float or double, in host byte
+ *   order. INT24 values take 4 bytes.
+ * - the values of all rows one after the other, with drizzle_result_row_count()
+ *   + 1 offsets where value i starts at offsets[i] and ends at
+ *   offsets[i + 1], for every other column and for all columns of text
+ *   results.
+ *
+ * A validity bitmap holds one bit per row, least significant bit first, set
+ * when the value is not NULL. NULL values are zeroed or empty. The arrays are
+ * owned by the result and freed with it. A result buffered by column has no
+ * rows for drizzle_row_next() or drizzle_stmt_fetch().
+ * @{
+ */
+
+/**
+ * Buffer a result set by column.
+ *
+ * @param[in,out] result A result object whose rows have not been read yet
+ * @return Standard drizzle return value.
+ */
+DRIZZLE_API
+drizzle_return_t drizzle_result_buffer_columnar(drizzle_result_st *result);
+
+/**
+ * Buffer the result set of an executed prepared statement by column. The
+ * columns are read from drizzle_stmt_result().
+ *
+ * @param[in,out] stmt A prepared statement object
+ * @return Standard drizzle return value.
+ */
+DRIZZLE_API
+drizzle_return_t drizzle_stmt_buffer_columnar(drizzle_stmt_st *stmt);
+
+/**
+ * Get the size of the values of a column buffered by column.
+ *
+ * @param[in] result A result buffered by column
+ * @param[in] column The column number
+ * @return Bytes per value, or 0 if the column has variable length values.
+ */
+DRIZZLE_API
+size_t drizzle_result_column_width(const drizzle_result_st *result,
+                                   uint16_t column);
+
+/**
+ * Get the fixed width values of a column buffered by column.
+ *
+ * @param[in] result A result buffered by column
+ * @param[in] column The column number
+ * @return drizzle_result_column_width() bytes per row, or NULL if the column
+ *  has variable length values.
+ */
+DRIZZLE_API
+const void *drizzle_result_column_values(const drizzle_result_st *result,
+                                         uint16_t column);
+
+/**
+ * Get the offsets of the values of a variable length column.
+ *
+ * @param[in] result A result buffered by column
+ * @param[in] column The column number
+ * @return drizzle_result_row_count() + 1 offsets into
+ *  drizzle_result_column_data(), or NULL for fixed width columns.
+ */
+DRIZZLE_API
+const uint64_t *drizzle_result_column_offsets(const drizzle_result_st *result,
+                                              uint16_t column);
+
+/**
+ * Get the bytes of the values of a variable length column.
+ *
+ * @param[in] result A result buffered by column
+ * @param[in] column The column number
+ * @return The values one after the other, not NUL terminated, or NULL for
+ *  fixed width columns and columns without any bytes.
+ */
+DRIZZLE_API
+const char *drizzle_result_column_data(const drizzle_result_st *result,
+                                       uint16_t column);
+
+/**
+ * Get the validity bitmap of a column buffered by column.
+ *
+ * @param[in] result A result buffered by column
+ * @param[in] column The column number
+ * @return One bit per row, set if the value is not NULL.
+ */
+DRIZZLE_API
+const uint8_t *drizzle_result_column_validity(const drizzle_result_st *result,
+                                              uint16_t column);
+
+/**
+ * Get the number of NULL values in a column buffered by column.
+ *
+ * @param[in] result A result buffered by column
+ * @param[in] column The column number
+ * @return The number of rows where the column is NULL.
+ */
+DRIZZLE_API
+uint64_t drizzle_result_column_null_count(const drizzle_result_st *result,
+                                          uint16_t column);
+
+/** @} */
+
+#ifdef __cplusplus
+}
+#endif
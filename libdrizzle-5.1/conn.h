@@ -313,6 +313,117 @@ void drizzle_options_set_socket_owner(drizzle_options_st *options,
 DRIZZLE_API
 drizzle_socket_owner drizzle_options_get_socket_owner(drizzle_options_st *options);
 
+/**
+ * Sets/unsets low footprint mode. Connections created with this option only
+ * allocate their I/O buffer when connecting, start with
+ * DRIZZLE_LOW_FOOTPRINT_BUFFER_SIZE bytes instead of
+ * DRIZZLE_DEFAULT_BUFFER_SIZE, grow the buffer for large packets and shrink
+ * it back at the end of the result or after a run of smaller reads, and
+ * release it when the connection is closed. Meant for applications holding
+ * many mostly idle connections.
+ *
+ * @param[in,out] options The options object to modify
+ * @param[in] state Set to true/false
+ */
+DRIZZLE_API
+void drizzle_options_set_low_footprint(drizzle_options_st *options, bool state);
+
+/**
+ * Gets the low footprint option
+ *
+ * @param[in] options The options object to get the value from
+ * @return The state of the low footprint option
+ */
+DRIZZLE_API
+bool drizzle_options_get_low_footprint(drizzle_options_st *options);
+
+/**
+ * Sets/unsets the io_uring I/O backend. Blocking connections created with
+ * this option submit their socket reads and writes to a private io_uring,
+ * waiting for each with a single system call, and read into the connection
+ * buffer registered as a fixed buffer where the memory lock limit allows.
+ * Non-blocking connections registered with a reactor queue their reads on a
+ * ring shared by the reactor, see drizzle_reactor_wait(). The option has no
+ * effect on other non-blocking connections and on SSL and compressed
+ * connections, and the regular socket calls are used when the kernel does
+ * not support io_uring.
+ *
+ * @param[in,out] options The options object to modify
+ * @param[in] state Set to true/false
+ */
+DRIZZLE_API
+void drizzle_options_set_io_uring(drizzle_options_st *options, bool state);
+
+/**
+ * Gets the io_uring option
+ *
+ * @param[in] options The options object to get the value from
+ * @return The state of the io_uring option
+ */
+DRIZZLE_API
+bool drizzle_options_get_io_uring(drizzle_options_st *options);
+
+/**
+ * Sets the compression algorithm for the client/server protocol. It is
+ * used if the server supports it; DRIZZLE_COMPRESSION_ZSTD falls back to
+ * DRIZZLE_COMPRESSION_ZLIB for servers without zstd, or when the library
+ * was built without it.
+ *
+ * @param[in,out] options The options object to modify
+ * @param[in] compression The algorithm, DRIZZLE_COMPRESSION_NONE to disable
+ */
+DRIZZLE_API
+void drizzle_options_set_compression(drizzle_options_st *options,
+                                     drizzle_compression_t compression);
+
+/**
+ * Gets the compression algorithm for the client/server protocol
+ *
+ * @param[in] options The options object to get the value from
+ * @return The compression algorithm
+ */
+DRIZZLE_API
+drizzle_compression_t drizzle_options_get_compression(drizzle_options_st *options);
+
+/**
+ * Sets the compression level, 1-9 for zlib and 1-22 for zstd. The default,
+ * 0, selects the default level of the algorithm.
+ *
+ * @param[in,out] options The options object to modify
+ * @param[in] level The compression level
+ */
+DRIZZLE_API
+void drizzle_options_set_compression_level(drizzle_options_st *options, int level);
+
+/**
+ * Gets the compression level
+ *
+ * @param[in] options The options object to get the value from
+ * @return The compression level
+ */
+DRIZZLE_API
+int drizzle_options_get_compression_level(drizzle_options_st *options);
+
+/**
+ * Sets the size below which packets are sent uncompressed. Defaults to
+ * DRIZZLE_DEFAULT_COMPRESSION_THRESHOLD bytes.
+ *
+ * @param[in,out] options The options object to modify
+ * @param[in] threshold The minimum size in bytes for compression
+ */
+DRIZZLE_API
+void drizzle_options_set_compression_threshold(drizzle_options_st *options,
+                                               size_t threshold);
+
+/**
+ * Gets the size below which packets are sent uncompressed
+ *
+ * @param[in] options The options object to get the value from
+ * @return The compression threshold in bytes
+ */
+DRIZZLE_API
+size_t drizzle_options_get_compression_threshold(drizzle_options_st *options);
+
 /**
  * Get TCP host for a connection.
  *
@@ -413,6 +524,18 @@ uint32_t drizzle_server_version_number(const drizzle_st *con);
 DRIZZLE_API
 uint32_t drizzle_thread_id(const drizzle_st *con);
 
+/**
+ * Get the number of bytes of memory currently held by a connection: the
+ * connection structure itself, its I/O buffer, the error message storage
+ * and the queues of its private io_uring. Result sets, and the ring a
+ * reactor shares between its connections, are not included.
+ *
+ * @param[in] con Connection structure previously initialized with drizzle_create().
+ * @return Memory used by the connection in bytes.
+ */
+DRIZZLE_API
+size_t drizzle_memory_usage(const drizzle_st *con);
+
 /**
  * Get scramble buffer for a connection.
  *
@@ -81,12 +81,16 @@ extern "C" {
 #define DRIZZLE_MAX_PACKET_SIZE          UINT32_MAX
 #define DRIZZLE_MAX_BUFFER_SIZE          1024*1024*1024
 #define DRIZZLE_DEFAULT_BUFFER_SIZE      1024*1024
+#define DRIZZLE_LOW_FOOTPRINT_BUFFER_SIZE 16*1024
 #define DRIZZLE_BUFFER_COPY_THRESHOLD    8192
+#define DRIZZLE_DEFAULT_COMPRESSION_THRESHOLD 50
 #define DRIZZLE_MAX_SERVER_VERSION_SIZE  32
 #define DRIZZLE_MAX_SERVER_EXTRA_SIZE    32
 #define DRIZZLE_MAX_SCRAMBLE_SIZE        20
-#define DRIZZLE_STATE_STACK_SIZE         8
+#define DRIZZLE_STATE_STACK_SIZE         16
 #define DRIZZLE_ROW_GROW_SIZE            8192
+#define DRIZZLE_DEFAULT_ARROW_BATCH_ROWS 65536
+#define DRIZZLE_DEFAULT_ROW_BATCH_ROWS   256
 #define DRIZZLE_DEFAULT_SOCKET_TIMEOUT   10
 #define DRIZZLE_DEFAULT_SOCKET_SEND_SIZE DRIZZLE_DEFAULT_BUFFER_SIZE
 #define DRIZZLE_DEFAULT_SOCKET_RECV_SIZE DRIZZLE_DEFAULT_BUFFER_SIZE
@@ -153,6 +157,9 @@ enum drizzle_capabilities_t
   DRIZZLE_CAPABILITIES_MULTI_RESULTS=          (1 << 17),
   DRIZZLE_CAPABILITIES_PS_MULTI_RESULTS=       (1 << 18),
   DRIZZLE_CAPABILITIES_PLUGIN_AUTH=            (1 << 19),
+  DRIZZLE_CAPABILITIES_DEPRECATE_EOF=          (1 << 24),
+  DRIZZLE_CAPABILITIES_OPTIONAL_RESULTSET_METADATA= (1 << 25),
+  DRIZZLE_CAPABILITIES_ZSTD_COMPRESSION_ALGORITHM= (1 << 26),
   DRIZZLE_CAPABILITIES_SSL_VERIFY_SERVER_CERT= (1 << 30),
   DRIZZLE_CAPABILITIES_REMEMBER_OPTIONS=       (1 << 31),
   DRIZZLE_CAPABILITIES_CLIENT= (DRIZZLE_CAPABILITIES_LONG_PASSWORD |
@@ -181,7 +188,9 @@ enum drizzle_result_options_t
   DRIZZLE_RESULT_BUFFER_ROW=    (1 << 3),
   DRIZZLE_RESULT_EOF_PACKET=    (1 << 4),
   DRIZZLE_RESULT_ROW_BREAK=     (1 << 5),
-  DRIZZLE_RESULT_BINARY_ROWS=   (1 << 6)
+  DRIZZLE_RESULT_BINARY_ROWS=   (1 << 6),
+  DRIZZLE_RESULT_MORE_RESULTS=  (1 << 7),
+  DRIZZLE_RESULT_BUFFER_COLUMNAR= (1 << 8)
 };
 
 #ifndef __cplusplus
@@ -291,6 +300,17 @@ typedef enum
   DRIZZLE_SOCKET_OWNER_CLIENT
 } drizzle_socket_owner;
 
+/**
+ * @ingroup drizzle_con
+ * Compression algorithms for the compressed client/server protocol
+ */
+typedef enum
+{
+  DRIZZLE_COMPRESSION_NONE= 0,
+  DRIZZLE_COMPRESSION_ZLIB,
+  DRIZZLE_COMPRESSION_ZSTD
+} drizzle_compression_t;
+
 /**
  * @ingroup drizzle_con
  * Available options to set for the socket connection
@@ -589,6 +609,7 @@ typedef struct drizzle_binlog_st drizzle_binlog_st;
 typedef struct drizzle_binlog_event_st drizzle_binlog_event_st;
 typedef struct drizzle_stmt_st drizzle_stmt_st;
 typedef struct drizzle_bind_st drizzle_bind_st;
+typedef struct drizzle_reactor_st drizzle_reactor_st;
 typedef char *drizzle_field_t;
 typedef drizzle_field_t *drizzle_row_t;
 
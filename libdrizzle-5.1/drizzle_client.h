@@ -65,6 +65,10 @@
 #include <libdrizzle-5.1/ssl.h>
 #include <libdrizzle-5.1/binlog.h>
 #include <libdrizzle-5.1/statement.h>
+#include <libdrizzle-5.1/reactor.h>
+#include <libdrizzle-5.1/pipeline.h>
+#include <libdrizzle-5.1/columnar.h>
+#include <libdrizzle-5.1/arrow.h>
 #include <libdrizzle-5.1/version.h>
 
 #ifdef __cplusplus
@@ -0,0 +1,141 @@
+/* vim:expandtab:shiftwidth=2:tabstop=2:smarttab:
+ *
+ * Drizzle Client & Protocol Library
+ *
+ * Copyright (C) 2012-2013 Drizzle Developer Group
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following disclaimer
+ * in the documentation and/or other materials provided with the
+ * distribution.
+ *
+ *     * The names of its contributors may not be used to endorse or
+ * promote products derived from this software without specific prior
+ * written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/**
+ * @file
+ * @brief Pipeline Declarations
+ */
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @addtogroup drizzle_pipeline Pipeline Declarations
+ * @ingroup drizzle_client_interface
+ *
+ * Pipelining sends several commands before reading any of their results, so
+ * a batch of queries costs one round trip instead of one per query.
+ * Commands are queued with drizzle_pipeline_query() or
+ * drizzle_pipeline_stmt_execute() and sent in batches by
+ * drizzle_pipeline_flush(). drizzle_pipeline_result() then returns the
+ * results in the order the commands were queued, sending the next batch
+ * once the results of the previous one have been read.
+ *
+ * A result must be read completely, rows included, before the next one is
+ * requested. Commands queued while results of an earlier batch are still
+ * unread go out once those results have been read. Other commands can not
+ * be sent on the connection until every pipelined result has been read.
+ * The further result sets of a multi-statement query are read with
+ * drizzle_result_next() before the next pipelined result. Pipelining is
+ * not available on compressed connections.
+ * @{
+ */
+
+/**
+ * Queue a query to be sent with the next drizzle_pipeline_flush(). The
+ * query is copied, so the caller may reuse its buffer right away.
+ *
+ * @param[in] con Connection to queue the query on.
+ * @param[in] query Query string.
+ * @param[in] size Length of query, or 0 to use strlen().
+ * @return Standard drizzle return value.
+ */
+DRIZZLE_API
+drizzle_return_t drizzle_pipeline_query(drizzle_st *con, const char *query,
+                                        size_t size);
+
+/**
+ * Queue the execution of a prepared statement with its current parameters.
+ * Once read with drizzle_pipeline_result(), the result becomes the current
+ * result of the statement as if drizzle_stmt_execute() had been called, and
+ * belongs to the statement. The statement must not be closed while
+ * executions of it are queued.
+ *
+ * @param[in] stmt A prepared statement object
+ * @return Standard drizzle return value.
+ */
+DRIZZLE_API
+drizzle_return_t drizzle_pipeline_stmt_execute(drizzle_stmt_st *stmt);
+
+/**
+ * Send the queued commands. They go out in batches of at most 16 KB, and a
+ * batch is only sent once every result of the previous one has been read,
+ * so that the server is never kept from reading commands while it waits to
+ * send a result. Nothing is sent, and DRIZZLE_RETURN_OK returned, while
+ * results are still to be read; drizzle_pipeline_result() then sends the
+ * next batch when it needs it.
+ *
+ * @param[in] con Connection with queued commands.
+ * @return Standard drizzle return value. DRIZZLE_RETURN_IO_WAIT in
+ *  non-blocking mode means the function should be called again once the
+ *  connection is writable.
+ */
+DRIZZLE_API
+drizzle_return_t drizzle_pipeline_flush(drizzle_st *con);
+
+/**
+ * Read the result of the oldest pipelined command. Queued commands are
+ * flushed first if they have not been sent yet.
+ *
+ * @param[in] con Connection with pipelined commands.
+ * @param[out] ret_ptr Standard drizzle return value. DRIZZLE_RETURN_ERROR_CODE
+ *  if the server returned an error for this command.
+ * @return The result, which is freed with drizzle_result_free() unless it
+ *  belongs to a statement, or NULL with DRIZZLE_RETURN_OK when no
+ *  pipelined commands are left.
+ */
+DRIZZLE_API
+drizzle_result_st *drizzle_pipeline_result(drizzle_st *con,
+                                           drizzle_return_t *ret_ptr);
+
+/**
+ * Get the number of pipelined commands whose result has not been read yet.
+ *
+ * @param[in] con A connection object
+ * @return Number of outstanding pipelined results.
+ */
+DRIZZLE_API
+uint32_t drizzle_pipeline_count(const drizzle_st *con);
+
+/** @} */
+
+#ifdef __cplusplus
+}
+#endif
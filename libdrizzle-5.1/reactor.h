@@ -0,0 +1,135 @@
+/* vim:expandtab:shiftwidth=2:tabstop=2:smarttab:
+ *
+ * Drizzle Client & Protocol Library
+ *
+ * Copyright (C) 2012-2013 Drizzle Developer Group
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following disclaimer
+ * in the documentation and/or other materials provided with the
+ * distribution.
+ *
+ *     * The names of its contributors may not be used to endorse or
+ * promote products derived from this software without specific prior
+ * written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/**
+ * @file
+ * @brief Reactor Declarations
+ */
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @addtogroup drizzle_reactor Reactor Declarations
+ * @ingroup drizzle_client_interface
+ *
+ * A reactor drives many non-blocking connections from one thread. Every
+ * registered connection is added to a single epoll set (or polled together
+ * where epoll is not available), and its interest is updated whenever the
+ * library asks for new events. Waiting returns a batch of connections that
+ * are ready, with their events already set as if drizzle_set_revents() had
+ * been called, so the function that returned DRIZZLE_RETURN_IO_WAIT can be
+ * called again on each of them.
+ *
+ * Registered connections are expected to use non-blocking mode, see
+ * drizzle_options_set_non_blocking(). A custom watcher set with
+ * drizzle_set_event_watch_fn() keeps working alongside the reactor.
+ *
+ * Once a connection with the io_uring option is added, the reactor sets up
+ * an io_uring shared by all its connections. Those connections queue each
+ * read on the ring instead of waiting for POLLIN, and a wait submits the
+ * queued reads and collects the completed ones, together with the epoll
+ * events of the other connections, in a single system call. The data is
+ * already in the connection buffer when a connection is returned as ready.
+ * @{
+ */
+
+/**
+ * Create a reactor.
+ *
+ * @return A newly allocated reactor, or NULL on failure.
+ */
+DRIZZLE_API
+drizzle_reactor_st *drizzle_reactor_create(void);
+
+/**
+ * Free a reactor. Connections still registered are detached but not
+ * closed.
+ *
+ * @param[in] reactor A reactor object
+ */
+DRIZZLE_API
+void drizzle_reactor_free(drizzle_reactor_st *reactor);
+
+/**
+ * Register a connection with a reactor. It may be connected or not; the
+ * socket is added as soon as the connection first waits for I/O.
+ *
+ * @param[in] reactor A reactor object
+ * @param[in] con A connection object, not registered with another reactor
+ * @return Standard drizzle return value.
+ */
+DRIZZLE_API
+drizzle_return_t drizzle_reactor_add(drizzle_reactor_st *reactor,
+                                     drizzle_st *con);
+
+/**
+ * Remove a connection from a reactor. Freeing a connection removes it
+ * automatically.
+ *
+ * @param[in] reactor A reactor object
+ * @param[in] con A connection object registered with reactor
+ * @return Standard drizzle return value.
+ */
+DRIZZLE_API
+drizzle_return_t drizzle_reactor_remove(drizzle_reactor_st *reactor,
+                                        drizzle_st *con);
+
+/**
+ * Wait for I/O on the registered connections.
+ *
+ * @param[in] reactor A reactor object
+ * @param[out] ready Array receiving the connections that are ready for I/O.
+ * @param[in] ready_size Number of entries in ready.
+ * @param[in] timeout Timeout in milliseconds, or -1 to wait forever.
+ * @param[out] ret_ptr Standard drizzle return value, DRIZZLE_RETURN_TIMEOUT
+ *  if nothing became ready in time.
+ * @return Number of connections stored in ready.
+ */
+DRIZZLE_API
+size_t drizzle_reactor_wait(drizzle_reactor_st *reactor,
+                            drizzle_st **ready, size_t ready_size,
+                            int timeout, drizzle_return_t *ret_ptr);
+
+/** @} */
+
+#ifdef __cplusplus
+}
+#endif
@@ -66,6 +66,22 @@ DRIZZLE_API
 drizzle_result_st *drizzle_result_read(drizzle_st *con,
                                        drizzle_return_t *ret_ptr);
 
+/**
+ * Reads the result set following the given one in the response to a
+ * multi-statement query or a stored procedure call. The rows of result must
+ * have been read or buffered first. Keep result until this returns, then
+ * free it as usual.
+ *
+ * @param[in] result The result that was read last
+ * @param[out] ret_ptr A pointer to a drizzle_return_t to store the return
+ *      status into. DRIZZLE_RETURN_NOT_READY if the rows of result have not
+ *      been read yet.
+ * @return The next result, or NULL once the response has no more results
+ */
+DRIZZLE_API
+drizzle_result_st *drizzle_result_next(drizzle_result_st *result,
+                                       drizzle_return_t *ret_ptr);
+
 /**
  * Buffers a result set
  *
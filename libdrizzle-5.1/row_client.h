@@ -71,8 +71,10 @@ DRIZZLE_API
 uint64_t drizzle_row_read(drizzle_result_st *result, drizzle_return_t *ret_ptr);
 
 /**
- * Read and buffer one row. The returned row must be freed by the caller with
- * drizzle_row_free().
+ * Read and buffer one row. The row and its fields are kept in arrays of the
+ * result that are reused for the next row, so after the first row reading a
+ * row does not allocate memory unless a field is larger than any before it.
+ * The row is valid until the next row is read or the result is freed.
  *
  * @param[in,out] result pointer to the result structure to read from.
  * @param[out] ret_pointer Standard drizzle return value.
@@ -83,7 +85,67 @@ drizzle_row_t drizzle_row_buffer(drizzle_result_st *result,
                                  drizzle_return_t *ret_ptr);
 
 /**
- * Free a row that was buffered with drizzle_row_buffer().
+ * Read one row without copying its fields. The fields point into the
+ * receive buffer of the connection and are not NUL terminated, their sizes
+ * are given by drizzle_row_field_sizes(). They are only copied when the row
+ * is larger than a packet. The row is valid until the next row is read or
+ * the result is freed and does not need to be freed.
+ *
+ * @param[in,out] result pointer to the result structure to read from.
+ * @param[out] ret_ptr Standard drizzle return value.
+ * @return the row that was read, or NULL if there are no more rows.
+ */
+DRIZZLE_API
+drizzle_row_t drizzle_row_view(drizzle_result_st *result,
+                               drizzle_return_t *ret_ptr);
+
+/**
+ * Function receiving the rows of a result from drizzle_result_stream().
+ *
+ * @param[in] result Result the rows are read from.
+ * @param[in] rows Rows of the batch, one field per column. The fields are
+ *  not NUL terminated and are only valid until the function returns.
+ * @param[in] field_sizes Field sizes of each row.
+ * @param[in] row_count Number of rows in the batch.
+ * @param[in] context Application context pointer given to
+ *  drizzle_result_stream().
+ * @return DRIZZLE_RETURN_OK to keep reading rows, anything else stops the
+ *  stream and is returned by drizzle_result_stream().
+ */
+typedef drizzle_return_t (drizzle_row_batch_fn)(drizzle_result_st *result,
+                                                drizzle_row_t *rows,
+                                                size_t **field_sizes,
+                                                uint32_t row_count,
+                                                void *context);
+
+/**
+ * Read the rows of a result in batches handed to a callback. The rows that
+ * are already in the receive buffer are parsed in place, without copying
+ * their fields or going through the state machine, which only runs when more
+ * data has to be read. Rows of binary results have a field for every column,
+ * NULL for columns that are NULL. Reading stops at the end of the rows, on an
+ * error, or when the callback does not return DRIZZLE_RETURN_OK.
+ *
+ * @param[in,out] result pointer to an unbuffered result.
+ * @param[in] batch_rows Most rows handed over at once, 0 for
+ *  DRIZZLE_DEFAULT_ROW_BATCH_ROWS.
+ * @param[in] row_batch_fn Function receiving the batches.
+ * @param[in] context Application context pointer passed to @p row_batch_fn.
+ * @return DRIZZLE_RETURN_OK once all the rows have been read, otherwise the
+ *  error or the return value of @p row_batch_fn. In non-blocking mode
+ *  DRIZZLE_RETURN_IO_WAIT is returned when more data has to be waited for,
+ *  call it again to carry on.
+ */
+DRIZZLE_API
+drizzle_return_t drizzle_result_stream(drizzle_result_st *result,
+                                       uint32_t batch_rows,
+                                       drizzle_row_batch_fn *row_batch_fn,
+                                       void *context);
+
+/**
+ * Release a row that was buffered with drizzle_row_buffer(). The memory of
+ * the row belongs to the result and is freed with it, so this does nothing
+ * and is kept for compatibility.
  *
  * @param[in,out] result A result object
  * @param[in,out] row The row data to be freed
@@ -100,6 +162,26 @@ void drizzle_row_free(drizzle_result_st *result, drizzle_row_t row);
 DRIZZLE_API
 size_t *drizzle_row_field_sizes(drizzle_result_st *result);
 
+/**
+ * Gets a field of a row by the name of its column. The columns of the result
+ * must have been buffered, which drizzle_result_buffer() does. The first call
+ * builds a hash table of the column names, later calls cost one lookup.
+ * Rows of prepared statements are not supported, see
+ * drizzle_stmt_get_int_from_name() and friends for those.
+ *
+ * @param[in,out] result A result object
+ * @param[in] row A row of the result
+ * @param[in] column_name The name of the column
+ * @param[out] ret_ptr A pointer to a drizzle_return_t to store the return
+ *  status into, DRIZZLE_RETURN_NOT_FOUND if there is no column of that name
+ * @return The field, NULL if it is NULL or on error
+ */
+DRIZZLE_API
+drizzle_field_t drizzle_row_field_by_name(drizzle_result_st *result,
+                                          drizzle_row_t row,
+                                          const char *column_name,
+                                          drizzle_return_t *ret_ptr);
+
 /**
  * Gets the next row in a buffered result set
  *
@@ -65,6 +65,27 @@ drizzle_stmt_st *drizzle_stmt_prepare(drizzle_st *con, const char *statement,
 DRIZZLE_API
 drizzle_return_t drizzle_stmt_execute(drizzle_stmt_st *stmt);
 
+/**
+ * Executes a prepared statement once for each row of the arrays bound with
+ * drizzle_stmt_set_array(). The executions are pipelined, their results are
+ * read in batches. The statement must not return rows, and the connection
+ * must be blocking and have no pipelined results left to read.
+ *
+ * @param stmt The prepared statement object
+ * @param rows The number of rows
+ * @param affected_rows Filled with the affected rows of each row, or NULL
+ * @param error_codes Filled with the server error code of each row, 0 if it
+ *  succeeded, or NULL
+ * @return A return status code, DRIZZLE_RETURN_OK if every row succeeded or
+ *  DRIZZLE_RETURN_ERROR_CODE if the server returned an error for any, in
+ *  which case drizzle_error() holds the last one
+ */
+DRIZZLE_API
+drizzle_return_t drizzle_stmt_execute_array(drizzle_stmt_st *stmt,
+                                            uint32_t rows,
+                                            uint64_t *affected_rows,
+                                            uint16_t *error_codes);
+
 /**
  * Send long binary data packet
  *
@@ -162,6 +183,16 @@ uint16_t drizzle_stmt_param_count(drizzle_stmt_st *stmt);
 DRIZZLE_API
 uint64_t drizzle_stmt_row_count(drizzle_stmt_st *stmt);
 
+/**
+ * Gets the result of the last execution of a prepared statement. The result
+ * belongs to the statement and must not be freed.
+ *
+ * @param stmt The prepared statement object
+ * @return The result, or NULL if the statement has not been executed
+ */
+DRIZZLE_API
+drizzle_result_st *drizzle_stmt_result(drizzle_stmt_st *stmt);
+
 /**
  *Sets a parameter of a prepared statement to a tinyint value
  *
@@ -299,6 +330,34 @@ drizzle_return_t drizzle_stmt_set_timestamp(drizzle_stmt_st *stmt, uint16_t para
                                             uint8_t hours, uint8_t minutes, uint8_t seconds,
                                             uint32_t microseconds);
 
+/**
+ * Binds a parameter of a prepared statement to an array of values, one per
+ * row, for drizzle_stmt_execute_array(). The arrays are read when the
+ * statement is executed, so they must stay valid until then. Parameters
+ * that are not bound to an array keep the value set with
+ * drizzle_stmt_set_*() for every row.
+ *
+ * @param stmt A prepared statement object
+ * @param param_num The parameter number to bind (starting at 0)
+ * @param type The type of the values: DRIZZLE_COLUMN_TYPE_TINY, _SHORT,
+ *  _LONG, _LONGLONG, _FLOAT, _DOUBLE or a string type
+ * @param data The value of the first row, or NULL to remove the binding
+ * @param stride The distance in bytes between the values of two rows, 0 if
+ *  fixed width values follow each other. Strings are stored in slots of
+ *  this size.
+ * @param lengths The length of the string of each row, unused for fixed
+ *  width types
+ * @param nulls Whether the value of each row is NULL, or NULL if no value is
+ * @param is_unsigned Set to true if the integers are unsigned
+ * @return A return status code, DRIZZLE_RETURN_OK upon success
+ */
+DRIZZLE_API
+drizzle_return_t drizzle_stmt_set_array(drizzle_stmt_st *stmt, uint16_t param_num,
+                                        drizzle_column_type_t type,
+                                        const void *data, size_t stride,
+                                        const size_t *lengths, const bool *nulls,
+                                        bool is_unsigned);
+
 /**
  * Check if a column for a fetched row is set to NULL using a column name
  *
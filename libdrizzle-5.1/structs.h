@@ -46,4 +46,6 @@ struct drizzle_binlog_st;
 struct drizzle_column_st;
 struct drizzle_stmt_st;
 struct drizzle_bind_st;
+struct drizzle_array_bind_st;
+struct drizzle_reactor_st;
 #endif
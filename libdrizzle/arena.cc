@@ -0,0 +1,165 @@
+/* vim:expandtab:shiftwidth=2:tabstop=2:smarttab:
+ *
+ * Drizzle Client & Protocol Library
+ *
+ * Copyright (C) 2012-2013 Drizzle Developer Group
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following disclaimer
+ * in the documentation and/or other materials provided with the
+ * distribution.
+ *
+ *     * The names of its contributors may not be used to endorse or
+ * promote products derived from this software without specific prior
+ * written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+/**
+ * @file
+ * @brief Arena Allocator Definitions
+ */
+
+#include "config.h"
+#include "libdrizzle/common.h"
+
+/* First slab of an arena, later slabs double up to the maximum. */
+#define DRIZZLE_ARENA_SLAB_SIZE (16 * 1024)
+#define DRIZZLE_ARENA_MAX_SLAB_SIZE (1024 * 1024)
+#define DRIZZLE_ARENA_ALIGN sizeof(uint64_t)
+
+struct drizzle_arena_slab_st
+{
+  drizzle_arena_slab_st *next;
+  size_t size;
+};
+
+/**
+ * @addtogroup drizzle_arena_static Static Arena Allocator Declarations
+ * @ingroup drizzle_arena
+ * @{
+ */
+
+/**
+ * Allocate a slab with room for size bytes after its header.
+ *
+ * @param[in,out] arena Arena the slab is added to.
+ * @param[in] size Usable size of the slab.
+ * @return The new slab, or NULL if it could not be allocated.
+ */
+static drizzle_arena_slab_st *_arena_slab_create(drizzle_arena_st *arena,
+                                                 size_t size)
+{
+  drizzle_arena_slab_st *slab=
+    (drizzle_arena_slab_st *)malloc(sizeof(drizzle_arena_slab_st) + size);
+  if (slab == NULL)
+  {
+    return NULL;
+  }
+
+  slab->size= size;
+  arena->allocation+= size;
+
+  return slab;
+}
+
+/** @} */
+
+/*
+ * Local Definitions
+ */
+
+void *drizzle_arena_alloc(drizzle_arena_st *arena, size_t size)
+{
+  size= (size + DRIZZLE_ARENA_ALIGN - 1) & ~(DRIZZLE_ARENA_ALIGN - 1);
+
+  if (size <= arena->available)
+  {
+    void *ptr= arena->ptr;
+    arena->ptr+= size;
+    arena->available-= size;
+    return ptr;
+  }
+
+  /* Large requests get a slab of their own behind the current one, so the
+     space left in the current slab is not given up for them. */
+  if (size > DRIZZLE_ARENA_MAX_SLAB_SIZE / 4 && arena->slab != NULL)
+  {
+    drizzle_arena_slab_st *slab= _arena_slab_create(arena, size);
+    if (slab == NULL)
+    {
+      return NULL;
+    }
+
+    slab->next= arena->slab->next;
+    arena->slab->next= slab;
+
+    return slab + 1;
+  }
+
+  size_t slab_size= arena->slab_size ? arena->slab_size
+                                      : DRIZZLE_ARENA_SLAB_SIZE;
+  if (arena->slab != NULL)
+  {
+    slab_size= arena->slab->size * 2;
+    if (slab_size > DRIZZLE_ARENA_MAX_SLAB_SIZE)
+    {
+      slab_size= DRIZZLE_ARENA_MAX_SLAB_SIZE;
+    }
+  }
+  if (slab_size < size)
+  {
+    slab_size= size;
+  }
+
+  drizzle_arena_slab_st *slab= _arena_slab_create(arena, slab_size);
+  if (slab == NULL)
+  {
+    return NULL;
+  }
+
+  slab->next= arena->slab;
+  arena->slab= slab;
+  arena->ptr= (unsigned char *)(slab + 1) + size;
+  arena->available= slab_size - size;
+
+  return slab + 1;
+}
+
+void drizzle_arena_free(drizzle_arena_st *arena)
+{
+  drizzle_arena_slab_st *slab= arena->slab;
+
+  while (slab != NULL)
+  {
+    drizzle_arena_slab_st *next= slab->next;
+    free(slab);
+    slab= next;
+  }
+
+  arena->slab= NULL;
+  arena->ptr= NULL;
+  arena->available= 0;
+  arena->allocation= 0;
+}
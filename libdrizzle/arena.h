@@ -0,0 +1,101 @@
+/* vim:expandtab:shiftwidth=2:tabstop=2:smarttab:
+ *
+ * Drizzle Client & Protocol Library
+ *
+ * Copyright (C) 2012-2013 Drizzle Developer Group
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following disclaimer
+ * in the documentation and/or other materials provided with the
+ * distribution.
+ *
+ *     * The names of its contributors may not be used to endorse or
+ * promote products derived from this software without specific prior
+ * written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#pragma once
+
+/**
+ * @file
+ * @brief Arena Allocator Declarations
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @addtogroup drizzle_arena Arena Allocator Declarations
+ * @ingroup drizzle_result
+ *
+ * An arena hands out memory from large slabs by bumping a pointer and
+ * releases everything at once. Buffered results keep their rows in one, so
+ * buffering a result costs a handful of allocations instead of several per
+ * row, and freeing it does not walk the rows.
+ * @{
+ */
+
+struct drizzle_arena_slab_st;
+
+struct drizzle_arena_st
+{
+  drizzle_arena_slab_st *slab;    /* slab being filled, head of the list */
+  unsigned char *ptr;             /* next free byte in slab */
+  size_t available;               /* free bytes after ptr */
+  size_t allocation;              /* bytes held by all slabs */
+  size_t slab_size;               /* size of the first slab, 0 for default */
+
+  drizzle_arena_st() :
+    slab(NULL),
+    ptr(NULL),
+    available(0),
+    allocation(0),
+    slab_size(0)
+  { }
+};
+
+/**
+ * Allocate memory from an arena. The memory is aligned for any integer or
+ * pointer type and stays valid until drizzle_arena_free().
+ *
+ * @param[in,out] arena Arena to allocate from.
+ * @param[in] size Number of bytes.
+ * @return The memory, or NULL if a new slab could not be allocated.
+ */
+void *drizzle_arena_alloc(drizzle_arena_st *arena, size_t size);
+
+/**
+ * Release all memory held by an arena and reset it for reuse.
+ *
+ * @param[in,out] arena Arena to free.
+ */
+void drizzle_arena_free(drizzle_arena_st *arena);
+
+/** @} */
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,851 @@
+/* vim:expandtab:shiftwidth=2:tabstop=2:smarttab:
+ *
+ * Drizzle Client & Protocol Library
+ *
+ * Copyright (C) 2012-2013 Drizzle Developer Group
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following disclaimer
+ * in the documentation and/or other materials provided with the
+ * distribution.
+ *
+ *     * The names of its contributors may not be used to endorse or
+ * promote products derived from this software without specific prior
+ * written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/**
+ * @file
+ * @brief Arrow IPC Export Definitions
+ */
+
+#include "config.h"
+#include "libdrizzle/common.h"
+
+#include <cerrno>
+
+/* Values from the Arrow Schema.fbs and Message.fbs flatbuffer schemas. */
+#define DRIZZLE_ARROW_CONTINUATION        0xFFFFFFFF
+#define DRIZZLE_ARROW_METADATA_V5         4
+#define DRIZZLE_ARROW_HEADER_SCHEMA       1
+#define DRIZZLE_ARROW_HEADER_RECORD_BATCH 3
+#define DRIZZLE_ARROW_TYPE_INT            2
+#define DRIZZLE_ARROW_TYPE_FLOATING_POINT 3
+#define DRIZZLE_ARROW_TYPE_LARGE_BINARY   19
+#define DRIZZLE_ARROW_TYPE_LARGE_UTF8     20
+#define DRIZZLE_ARROW_PRECISION_SINGLE    1
+#define DRIZZLE_ARROW_PRECISION_DOUBLE    2
+#define DRIZZLE_ARROW_ENDIANNESS_BIG      1
+/* Buffers and messages are padded to this size. */
+#define DRIZZLE_ARROW_ALIGN               8
+/* Longest text form of a temporal value, YYYY-MM-DD HH:MM:SS.ssssss. */
+#define DRIZZLE_ARROW_TEMPORAL_SIZE       26
+
+/* One scalar or offset field of a flatbuffer table, size 0 if absent. */
+struct drizzle_arrow_field_st
+{
+  size_t size;
+  uint64_t value;
+};
+
+/* One buffer of the body of a record batch. */
+struct drizzle_arrow_buffer_st
+{
+  const void *data;
+  uint64_t offset;
+  uint64_t length;
+};
+
+struct drizzle_arrow_st
+{
+  drizzle_result_st *result;
+  int fd;                         /* -1 to write to memory */
+  unsigned char *data;            /* memory output */
+  size_t size;
+  size_t capacity;
+  unsigned char *meta;            /* flatbuffer of the current message */
+  size_t meta_size;
+  size_t meta_capacity;
+  bool failed;                    /* meta could not grow */
+  drizzle_column_vector_st *text; /* temporal columns of binary rows as text */
+  drizzle_arrow_buffer_st *buffers;
+  drizzle_bind_st bind;           /* scratch space for temporal values */
+
+  drizzle_arrow_st() :
+    result(NULL),
+    fd(-1),
+    data(NULL),
+    size(0),
+    capacity(0),
+    meta(NULL),
+    meta_size(0),
+    meta_capacity(0),
+    failed(false),
+    text(NULL),
+    buffers(NULL)
+  { }
+};
+
+/**
+ * @addtogroup drizzle_arrow_static Static Arrow IPC Export Declarations
+ * @ingroup drizzle_arrow
+ * @{
+ */
+
+/**
+ * Write bytes to the output of an export.
+ *
+ * @param[in,out] arrow Export state.
+ * @param[in] data Bytes to write.
+ * @param[in] size Number of bytes.
+ * @return Standard drizzle return value.
+ */
+static drizzle_return_t _arrow_write(drizzle_arrow_st *arrow, const void *data,
+                                     size_t size)
+{
+  if (arrow->fd == -1)
+  {
+    if (arrow->size + size > arrow->capacity)
+    {
+      size_t capacity= arrow->capacity ? arrow->capacity * 2 : DRIZZLE_DEFAULT_BUFFER_SIZE;
+      while (capacity < arrow->size + size)
+      {
+        capacity*= 2;
+      }
+
+      unsigned char *output= (unsigned char *)realloc(arrow->data, capacity);
+      if (output == NULL)
+      {
+        drizzle_set_error(arrow->result->con, __func__, "Failed to realloc output.");
+        return DRIZZLE_RETURN_MEMORY;
+      }
+      arrow->data= output;
+      arrow->capacity= capacity;
+    }
+
+    if (size)
+    {
+      memcpy(arrow->data + arrow->size, data, size);
+    }
+    arrow->size+= size;
+    return DRIZZLE_RETURN_OK;
+  }
+
+  const char *ptr= (const char *)data;
+  while (size)
+  {
+    ssize_t written= write(arrow->fd, ptr, size);
+    if (written == -1)
+    {
+      if (errno == EINTR)
+      {
+        continue;
+      }
+
+      drizzle_set_error(arrow->result->con, __func__, "write:%s", strerror(errno));
+      return DRIZZLE_RETURN_ERRNO;
+    }
+
+    ptr+= written;
+    size-= (size_t)written;
+  }
+
+  return DRIZZLE_RETURN_OK;
+}
+
+/**
+ * Write zeros after size bytes up to the next multiple of the alignment.
+ *
+ * @param[in,out] arrow Export state.
+ * @param[in] size Number of bytes written before.
+ * @return Standard drizzle return value.
+ */
+static drizzle_return_t _arrow_pad(drizzle_arrow_st *arrow, uint64_t size)
+{
+  static const unsigned char zeros[DRIZZLE_ARROW_ALIGN]= { 0 };
+  size_t pad= (size_t)(-size & (DRIZZLE_ARROW_ALIGN - 1));
+
+  return _arrow_write(arrow, zeros, pad);
+}
+
+/**
+ * Append zeroed space to the flatbuffer being built.
+ *
+ * @param[in,out] arrow Export state.
+ * @param[in] size Number of bytes.
+ * @param[in] align Alignment of the space from the start of the flatbuffer.
+ * @return Position of the space.
+ */
+static size_t _fb_space(drizzle_arrow_st *arrow, size_t size, size_t align)
+{
+  size_t pos= (arrow->meta_size + align - 1) & ~(align - 1);
+
+  if (pos + size > arrow->meta_capacity)
+  {
+    size_t capacity= arrow->meta_capacity ? arrow->meta_capacity * 2 : 1024;
+    while (capacity < pos + size)
+    {
+      capacity*= 2;
+    }
+
+    unsigned char *meta= (unsigned char *)realloc(arrow->meta, capacity);
+    if (meta == NULL)
+    {
+      arrow->failed= true;
+      arrow->meta_size= 0;
+      return 0;
+    }
+    arrow->meta= meta;
+    arrow->meta_capacity= capacity;
+  }
+
+  memset(arrow->meta + arrow->meta_size, 0, pos + size - arrow->meta_size);
+  arrow->meta_size= pos + size;
+  return pos;
+}
+
+/**
+ * Store a little endian scalar in the flatbuffer being built.
+ *
+ * @param[in,out] arrow Export state.
+ * @param[in] pos Position of the scalar.
+ * @param[in] value Value to store.
+ * @param[in] size Size of the scalar in bytes.
+ */
+static void _fb_put(drizzle_arrow_st *arrow, size_t pos, uint64_t value,
+                    size_t size)
+{
+  if (arrow->failed)
+  {
+    return;
+  }
+
+  for (size_t x= 0; x < size; x++)
+  {
+    arrow->meta[pos + x]= (unsigned char)(value >> (8 * x));
+  }
+}
+
+/**
+ * Point an offset field of the flatbuffer being built at a later object.
+ *
+ * @param[in,out] arrow Export state.
+ * @param[in] pos Position of the offset field.
+ * @param[in] target Position of the object.
+ */
+static void _fb_link(drizzle_arrow_st *arrow, size_t pos, size_t target)
+{
+  _fb_put(arrow, pos, target - pos, 4);
+}
+
+/**
+ * Append a table to the flatbuffer being built. Offset fields are left
+ * zero, to be set with _fb_link() once their object has been appended.
+ *
+ * @param[in,out] arrow Export state.
+ * @param[in] fields Fields in the order of their ids.
+ * @param[in] count Number of fields.
+ * @param[out] positions Position of each field, may be NULL.
+ * @return Position of the table.
+ */
+static size_t _fb_table(drizzle_arrow_st *arrow,
+                        const drizzle_arrow_field_st *fields, uint16_t count,
+                        size_t *positions)
+{
+  size_t vtable= _fb_space(arrow, 4 + 2 * (size_t)count, 2);
+  size_t table= _fb_space(arrow, 4, DRIZZLE_ARROW_ALIGN);
+
+  _fb_put(arrow, table, table - vtable, 4);
+  for (uint16_t x= 0; x < count; x++)
+  {
+    size_t pos= 0;
+    if (fields[x].size)
+    {
+      pos= _fb_space(arrow, fields[x].size, fields[x].size);
+      _fb_put(arrow, pos, fields[x].value, fields[x].size);
+      _fb_put(arrow, vtable + 4 + 2 * (size_t)x, pos - table, 2);
+    }
+
+    if (positions)
+    {
+      positions[x]= pos;
+    }
+  }
+
+  _fb_put(arrow, vtable, 4 + 2 * (size_t)count, 2);
+  _fb_put(arrow, vtable + 2, arrow->meta_size - table, 2);
+  return table;
+}
+
+/**
+ * Append a vector to the flatbuffer being built.
+ *
+ * @param[in,out] arrow Export state.
+ * @param[in] count Number of elements.
+ * @param[in] size Size of an element, 4 for offsets or 16 for the structs.
+ * @return Position of the vector, its elements follow 4 bytes later.
+ */
+static size_t _fb_vector(drizzle_arrow_st *arrow, uint64_t count, size_t size)
+{
+  /* Align the elements rather than the length before them. */
+  size_t align= size < DRIZZLE_ARROW_ALIGN ? 4 : DRIZZLE_ARROW_ALIGN;
+  if ((arrow->meta_size + 4) & (align - 1))
+  {
+    _fb_space(arrow, align - ((arrow->meta_size + 4) & (align - 1)), 1);
+  }
+
+  size_t vector= _fb_space(arrow, 4 + (size_t)count * size, 4);
+  _fb_put(arrow, vector, count, 4);
+  return vector;
+}
+
+/**
+ * Append a string to the flatbuffer being built.
+ *
+ * @param[in,out] arrow Export state.
+ * @param[in] string NUL terminated string.
+ * @return Position of the string.
+ */
+static size_t _fb_string(drizzle_arrow_st *arrow, const char *string)
+{
+  size_t length= strlen(string);
+  size_t pos= _fb_space(arrow, 4 + length + 1, 4);
+
+  _fb_put(arrow, pos, length, 4);
+  if (!arrow->failed)
+  {
+    memcpy(arrow->meta + pos + 4, string, length);
+  }
+  return pos;
+}
+
+/**
+ * Start the flatbuffer of a message.
+ *
+ * @param[in,out] arrow Export state.
+ * @param[in] header_type Type of the header table.
+ * @param[in] body_length Size of the body after the message.
+ * @return Position of the header field, to be linked to the header table.
+ */
+static size_t _arrow_message(drizzle_arrow_st *arrow, uint8_t header_type,
+                             uint64_t body_length)
+{
+  drizzle_arrow_field_st fields[4]= {
+    { 2, DRIZZLE_ARROW_METADATA_V5 },
+    { 1, header_type },
+    { 4, 0 },
+    { 8, body_length }
+  };
+  size_t positions[4];
+
+  arrow->meta_size= 0;
+  arrow->failed= false;
+  size_t root= _fb_space(arrow, 4, 4);
+  size_t message= _fb_table(arrow, fields, 4, positions);
+  _fb_link(arrow, root, message);
+
+  return positions[2];
+}
+
+/**
+ * Write the message built in the flatbuffer, framed by its continuation
+ * marker and length.
+ *
+ * @param[in,out] arrow Export state.
+ * @return Standard drizzle return value.
+ */
+static drizzle_return_t _arrow_message_write(drizzle_arrow_st *arrow)
+{
+  if (arrow->failed)
+  {
+    drizzle_set_error(arrow->result->con, __func__, "Failed to realloc metadata.");
+    return DRIZZLE_RETURN_MEMORY;
+  }
+
+  uint64_t size= (arrow->meta_size + DRIZZLE_ARROW_ALIGN - 1) & ~(uint64_t)(DRIZZLE_ARROW_ALIGN - 1);
+  unsigned char prefix[8];
+  drizzle_set_byte4(prefix, DRIZZLE_ARROW_CONTINUATION);
+  drizzle_set_byte4(prefix + 4, size);
+
+  drizzle_return_t ret= _arrow_write(arrow, prefix, sizeof(prefix));
+  if (ret == DRIZZLE_RETURN_OK)
+  {
+    ret= _arrow_write(arrow, arrow->meta, arrow->meta_size);
+  }
+  if (ret == DRIZZLE_RETURN_OK)
+  {
+    ret= _arrow_pad(arrow, arrow->meta_size);
+  }
+
+  return ret;
+}
+
+/**
+ * Check whether a column is exported as text converted from binary rows.
+ *
+ * @param[in] result Result being exported.
+ * @param[in] column Column number.
+ * @return true for the temporal columns of binary rows.
+ */
+static bool _arrow_is_temporal(drizzle_result_st *result, uint16_t column)
+{
+  if (!result->binary_rows)
+  {
+    return false;
+  }
+
+  drizzle_column_type_t type= result->column_buffer[column].type;
+  return type == DRIZZLE_COLUMN_TYPE_TIME || type == DRIZZLE_COLUMN_TYPE_DATE ||
+         type == DRIZZLE_COLUMN_TYPE_DATETIME ||
+         type == DRIZZLE_COLUMN_TYPE_TIMESTAMP;
+}
+
+/**
+ * Append the Arrow type of a column to the flatbuffer being built.
+ *
+ * @param[in,out] arrow Export state.
+ * @param[in] column Column number.
+ * @param[out] type_type Arrow type id of the type table.
+ * @return Position of the type table.
+ */
+static size_t _arrow_type(drizzle_arrow_st *arrow, uint16_t column,
+                          uint8_t *type_type)
+{
+  drizzle_column_st *info= &arrow->result->column_buffer[column];
+  size_t width= arrow->result->columnar->columns[column].width;
+
+  if (info->type == DRIZZLE_COLUMN_TYPE_FLOAT && width)
+  {
+    drizzle_arrow_field_st precision= { 2, DRIZZLE_ARROW_PRECISION_SINGLE };
+    *type_type= DRIZZLE_ARROW_TYPE_FLOATING_POINT;
+    return _fb_table(arrow, &precision, 1, NULL);
+  }
+
+  if (info->type == DRIZZLE_COLUMN_TYPE_DOUBLE && width)
+  {
+    drizzle_arrow_field_st precision= { 2, DRIZZLE_ARROW_PRECISION_DOUBLE };
+    *type_type= DRIZZLE_ARROW_TYPE_FLOATING_POINT;
+    return _fb_table(arrow, &precision, 1, NULL);
+  }
+
+  if (width)
+  {
+    drizzle_arrow_field_st fields[2]= {
+      { 4, width * 8 },
+      { 1, (info->flags & DRIZZLE_COLUMN_FLAGS_UNSIGNED) ? 0U : 1U }
+    };
+    *type_type= DRIZZLE_ARROW_TYPE_INT;
+    return _fb_table(arrow, fields, 2, NULL);
+  }
+
+  *type_type= DRIZZLE_ARROW_TYPE_LARGE_UTF8;
+  if (info->charset == DRIZZLE_CHARSET_BINARY &&
+      (info->type == DRIZZLE_COLUMN_TYPE_TINY_BLOB ||
+       info->type == DRIZZLE_COLUMN_TYPE_MEDIUM_BLOB ||
+       info->type == DRIZZLE_COLUMN_TYPE_LONG_BLOB ||
+       info->type == DRIZZLE_COLUMN_TYPE_BLOB ||
+       info->type == DRIZZLE_COLUMN_TYPE_BIT ||
+       info->type == DRIZZLE_COLUMN_TYPE_STRING ||
+       info->type == DRIZZLE_COLUMN_TYPE_VAR_STRING ||
+       info->type == DRIZZLE_COLUMN_TYPE_VARCHAR ||
+       info->type == DRIZZLE_COLUMN_TYPE_GEOMETRY))
+  {
+    *type_type= DRIZZLE_ARROW_TYPE_LARGE_BINARY;
+  }
+
+  return _fb_table(arrow, NULL, 0, NULL);
+}
+
+/**
+ * Write the schema message, with one nullable field per column.
+ *
+ * @param[in,out] arrow Export state.
+ * @return Standard drizzle return value.
+ */
+static drizzle_return_t _arrow_schema_write(drizzle_arrow_st *arrow)
+{
+  drizzle_result_st *result= arrow->result;
+  uint16_t host= 1;
+  bool big_endian= *(uint8_t *)&host == 0;
+
+  size_t header= _arrow_message(arrow, DRIZZLE_ARROW_HEADER_SCHEMA, 0);
+  drizzle_arrow_field_st schema_fields[2]= {
+    { big_endian ? 2U : 0U, DRIZZLE_ARROW_ENDIANNESS_BIG },
+    { 4, 0 }
+  };
+  size_t schema_positions[2];
+  size_t schema= _fb_table(arrow, schema_fields, 2, schema_positions);
+  _fb_link(arrow, header, schema);
+
+  size_t fields= _fb_vector(arrow, result->column_count, 4);
+  _fb_link(arrow, schema_positions[1], fields);
+
+  for (uint16_t x= 0; x < result->column_count; x++)
+  {
+    /* name, nullable, type_type, type, dictionary, children */
+    drizzle_arrow_field_st field_fields[6]= {
+      { 4, 0 },
+      { 1, 1 },
+      { 1, 0 },
+      { 4, 0 },
+      { 0, 0 },
+      { 4, 0 }
+    };
+    size_t positions[6];
+    uint8_t type_type;
+
+    const char *name= drizzle_column_name(&result->column_buffer[x]);
+    if (name == NULL)
+    {
+      arrow->failed= true;
+      name= "";
+    }
+
+    size_t field= _fb_table(arrow, field_fields, 6, positions);
+    _fb_link(arrow, fields + 4 + 4 * (size_t)x, field);
+    _fb_link(arrow, positions[0], _fb_string(arrow, name));
+    _fb_link(arrow, positions[3], _arrow_type(arrow, x, &type_type));
+    _fb_put(arrow, positions[2], type_type, 1);
+    _fb_link(arrow, positions[5], _fb_vector(arrow, 0, 4));
+  }
+
+  return _arrow_message_write(arrow);
+}
+
+/**
+ * Convert the temporal values of a column of binary rows to text.
+ *
+ * @param[in,out] arrow Export state.
+ * @param[in] column Column number.
+ * @param[in] rows Number of rows in the column vector.
+ * @return Standard drizzle return value.
+ */
+static drizzle_return_t _arrow_temporal(drizzle_arrow_st *arrow, uint16_t column,
+                                        uint64_t rows)
+{
+  drizzle_column_st *info= &arrow->result->column_buffer[column];
+  drizzle_column_vector_st *vector= &arrow->result->columnar->columns[column];
+  drizzle_column_vector_st *text= &arrow->text[column];
+
+  if (text->data_size < rows * DRIZZLE_ARROW_TEMPORAL_SIZE)
+  {
+    free(text->offsets);
+    free(text->data);
+    text->offsets= (uint64_t *)malloc(sizeof(uint64_t) * (rows + 1));
+    text->data= (char *)malloc(rows * DRIZZLE_ARROW_TEMPORAL_SIZE);
+    if (text->offsets == NULL || text->data == NULL)
+    {
+      text->data_size= 0;
+      drizzle_set_error(arrow->result->con, __func__, "Failed to allocate.");
+      return DRIZZLE_RETURN_MEMORY;
+    }
+    text->data_size= rows * DRIZZLE_ARROW_TEMPORAL_SIZE;
+  }
+
+  arrow->bind.type= info->type;
+  text->offsets[0]= 0;
+  for (uint64_t row= 0; row < rows; row++)
+  {
+    uint64_t end= text->offsets[row];
+    if (vector->validity[row / 8] & (1 << (row % 8)))
+    {
+      drizzle_datetime_st datetime;
+      char *value;
+      size_t length= (size_t)(vector->offsets[row + 1] - vector->offsets[row]);
+
+      if (info->type == DRIZZLE_COLUMN_TYPE_TIME)
+      {
+        drizzle_unpack_time(vector->data + vector->offsets[row], length, &datetime, info->decimals);
+        value= time_to_string(&arrow->bind, &datetime);
+      }
+      else
+      {
+        drizzle_unpack_datetime(vector->data + vector->offsets[row], length, &datetime, info->decimals);
+        value= timestamp_to_string(&arrow->bind, &datetime);
+      }
+
+      length= strlen(value);
+      memcpy(text->data + end, value, length);
+      end+= length;
+    }
+    text->offsets[row + 1]= end;
+  }
+
+  return DRIZZLE_RETURN_OK;
+}
+
+/**
+ * Write the rows held by the column vectors as a record batch message.
+ *
+ * @param[in,out] arrow Export state.
+ * @param[in] rows Number of rows in the column vectors.
+ * @return Standard drizzle return value.
+ */
+static drizzle_return_t _arrow_batch_write(drizzle_arrow_st *arrow, uint64_t rows)
+{
+  drizzle_result_st *result= arrow->result;
+  drizzle_return_t ret;
+  uint16_t count= 0;
+  uint64_t body_length= 0;
+
+  /* Validity and values, or validity, offsets and data, for each column. */
+  for (uint16_t x= 0; x < result->column_count; x++)
+  {
+    drizzle_column_vector_st *vector= &result->columnar->columns[x];
+    drizzle_arrow_buffer_st *buffer= &arrow->buffers[count];
+
+    buffer->data= vector->validity;
+    buffer->length= vector->null_count ? (rows + 7) / 8 : 0;
+    count++;
+
+    if (vector->width)
+    {
+      buffer[1].data= vector->values;
+      buffer[1].length= rows * vector->width;
+      count++;
+      continue;
+    }
+
+    if (_arrow_is_temporal(result, x))
+    {
+      ret= _arrow_temporal(arrow, x, rows);
+      if (ret != DRIZZLE_RETURN_OK)
+      {
+        return ret;
+      }
+      vector= &arrow->text[x];
+    }
+
+    buffer[1].data= vector->offsets;
+    buffer[1].length= (rows + 1) * sizeof(uint64_t);
+    buffer[2].data= vector->data;
+    buffer[2].length= vector->offsets[rows];
+    count+= 2;
+  }
+
+  for (uint16_t x= 0; x < count; x++)
+  {
+    arrow->buffers[x].offset= body_length;
+    body_length+= (arrow->buffers[x].length + DRIZZLE_ARROW_ALIGN - 1) & ~(uint64_t)(DRIZZLE_ARROW_ALIGN - 1);
+  }
+
+  size_t header= _arrow_message(arrow, DRIZZLE_ARROW_HEADER_RECORD_BATCH, body_length);
+  drizzle_arrow_field_st batch_fields[3]= {
+    { 8, rows },
+    { 4, 0 },
+    { 4, 0 }
+  };
+  size_t positions[3];
+  size_t batch= _fb_table(arrow, batch_fields, 3, positions);
+  _fb_link(arrow, header, batch);
+
+  /* FieldNode { length: long; null_count: long; } */
+  size_t nodes= _fb_vector(arrow, result->column_count, 16);
+  _fb_link(arrow, positions[1], nodes);
+  for (uint16_t x= 0; x < result->column_count; x++)
+  {
+    _fb_put(arrow, nodes + 4 + 16 * (size_t)x, rows, 8);
+    _fb_put(arrow, nodes + 12 + 16 * (size_t)x, result->columnar->columns[x].null_count, 8);
+  }
+
+  /* Buffer { offset: long; length: long; } */
+  size_t buffers= _fb_vector(arrow, count, 16);
+  _fb_link(arrow, positions[2], buffers);
+  for (uint16_t x= 0; x < count; x++)
+  {
+    _fb_put(arrow, buffers + 4 + 16 * (size_t)x, arrow->buffers[x].offset, 8);
+    _fb_put(arrow, buffers + 12 + 16 * (size_t)x, arrow->buffers[x].length, 8);
+  }
+
+  ret= _arrow_message_write(arrow);
+  for (uint16_t x= 0; x < count && ret == DRIZZLE_RETURN_OK; x++)
+  {
+    ret= _arrow_write(arrow, arrow->buffers[x].data, (size_t)arrow->buffers[x].length);
+    if (ret == DRIZZLE_RETURN_OK)
+    {
+      ret= _arrow_pad(arrow, arrow->buffers[x].length);
+    }
+  }
+
+  return ret;
+}
+
+/**
+ * Export the rows of a result as an Arrow IPC stream.
+ *
+ * @param[in,out] arrow Export state, with the result and output set.
+ * @param[in] batch_rows Maximum number of rows per record batch.
+ * @return Standard drizzle return value.
+ */
+static drizzle_return_t _arrow_export(drizzle_arrow_st *arrow, uint64_t batch_rows)
+{
+  drizzle_result_st *result= arrow->result;
+  drizzle_return_t ret;
+
+  if (result->options & (DRIZZLE_RESULT_BUFFER_ROW | DRIZZLE_RESULT_BUFFER_COLUMNAR) ||
+      result->columnar != NULL)
+  {
+    drizzle_set_error(result->con, __func__, "rows have already been buffered");
+    return DRIZZLE_RETURN_UNEXPECTED_DATA;
+  }
+
+  if (!(result->options & DRIZZLE_RESULT_BUFFER_COLUMN))
+  {
+    ret= drizzle_column_buffer(result);
+    if (ret != DRIZZLE_RETURN_OK)
+    {
+      return ret;
+    }
+  }
+
+  if (batch_rows == 0)
+  {
+    batch_rows= DRIZZLE_DEFAULT_ARROW_BATCH_ROWS;
+  }
+
+  if (result->column_count > 0)
+  {
+    ret= drizzle_columnar_create(result);
+    if (ret != DRIZZLE_RETURN_OK)
+    {
+      return ret;
+    }
+
+    arrow->text= new (std::nothrow) drizzle_column_vector_st[result->column_count]();
+    arrow->buffers= new (std::nothrow) drizzle_arrow_buffer_st[3 * (size_t)result->column_count];
+    if (arrow->text == NULL || arrow->buffers == NULL || arrow->bind.data_buffer == NULL)
+    {
+      drizzle_set_error(result->con, __func__, "Failed to allocate.");
+      return DRIZZLE_RETURN_MEMORY;
+    }
+  }
+
+  ret= _arrow_schema_write(arrow);
+
+  while (ret == DRIZZLE_RETURN_OK && result->column_count > 0)
+  {
+    drizzle_columnar_clear(result);
+    ret= drizzle_columnar_read(result, batch_rows);
+    if (ret != DRIZZLE_RETURN_OK)
+    {
+      break;
+    }
+
+    uint64_t rows= result->row_count - result->columnar->row_first;
+    if (rows > 0)
+    {
+      ret= _arrow_batch_write(arrow, rows);
+    }
+
+    if (rows < batch_rows)
+    {
+      break;
+    }
+  }
+
+  if (ret == DRIZZLE_RETURN_OK)
+  {
+    unsigned char eos[8];
+    drizzle_set_byte4(eos, DRIZZLE_ARROW_CONTINUATION);
+    drizzle_set_byte4(eos + 4, 0);
+    ret= _arrow_write(arrow, eos, sizeof(eos));
+  }
+
+  /* The vectors only held the batch being written. */
+  drizzle_columnar_free(result);
+  return ret;
+}
+
+/**
+ * Free the memory used by an export, apart from the memory output.
+ *
+ * @param[in,out] arrow Export state.
+ */
+static void _arrow_free(drizzle_arrow_st *arrow)
+{
+  if (arrow->text)
+  {
+    for (uint16_t x= 0; x < arrow->result->column_count; x++)
+    {
+      free(arrow->text[x].offsets);
+      free(arrow->text[x].data);
+    }
+    delete[] arrow->text;
+  }
+  delete[] arrow->buffers;
+  delete[] arrow->bind.data_buffer;
+  free(arrow->meta);
+}
+
+/** @} */
+
+/*
+ * Client definitions
+ */
+
+drizzle_return_t drizzle_result_arrow_fd(drizzle_result_st *result, int fd,
+                                         uint64_t batch_rows)
+{
+  if (result == NULL || fd < 0)
+  {
+    return DRIZZLE_RETURN_INVALID_ARGUMENT;
+  }
+
+  drizzle_arrow_st arrow;
+  arrow.result= result;
+  arrow.fd= fd;
+
+  drizzle_return_t ret= _arrow_export(&arrow, batch_rows);
+  _arrow_free(&arrow);
+
+  return ret;
+}
+
+drizzle_return_t drizzle_result_arrow_memory(drizzle_result_st *result,
+                                             uint64_t batch_rows,
+                                             void **data, size_t *size)
+{
+  if (result == NULL || data == NULL || size == NULL)
+  {
+    return DRIZZLE_RETURN_INVALID_ARGUMENT;
+  }
+
+  drizzle_arrow_st arrow;
+  arrow.result= result;
+
+  drizzle_return_t ret= _arrow_export(&arrow, batch_rows);
+  _arrow_free(&arrow);
+
+  if (ret != DRIZZLE_RETURN_OK)
+  {
+    free(arrow.data);
+    *data= NULL;
+    *size= 0;
+    return ret;
+  }
+
+  *data= arrow.data;
+  *size= arrow.size;
+  return DRIZZLE_RETURN_OK;
+}
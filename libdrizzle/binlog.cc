@@ -286,13 +286,9 @@ drizzle_return_t drizzle_state_binlog_read(drizzle_st *con)
     return DRIZZLE_RETURN_OK;
   }
 
-  if (con->packet_size == 5 && con->buffer_ptr[0] == 254)
+  if (drizzle_check_unpack_eof(con, &con->result->warning_count))
   {
     /* Got EOF packet, no more data. */
-    con->result->warning_count= drizzle_get_byte2(con->buffer_ptr + 1);
-    con->status= (drizzle_status_t)drizzle_get_byte2(con->buffer_ptr + 3);
-    con->buffer_ptr+= 5;
-    con->buffer_size-= 5;
     con->pop_state();
     con->binlog->error_fn(DRIZZLE_RETURN_EOF, con, con->binlog->binlog_context);
     return DRIZZLE_RETURN_EOF;
@@ -300,7 +296,7 @@ drizzle_return_t drizzle_state_binlog_read(drizzle_st *con)
   else if (drizzle_check_unpack_error(con))
   {
     snprintf(con->result->info, DRIZZLE_MAX_INFO_SIZE, "%.*s",
-             (int)con->packet_size, con->last_error);
+             (int)con->packet_size, drizzle_error(con));
     con->result->info[DRIZZLE_MAX_INFO_SIZE-1]= 0;
 
     con->pop_state();
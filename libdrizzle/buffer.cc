@@ -0,0 +1,305 @@
+/* vim:expandtab:shiftwidth=2:tabstop=2:smarttab:
+ *
+ * Drizzle Client & Protocol Library
+ *
+ * Copyright (C) 2012-2013 Drizzle Developer Group
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following disclaimer
+ * in the documentation and/or other materials provided with the
+ * distribution.
+ *
+ *     * The names of its contributors may not be used to endorse or
+ * promote products derived from this software without specific prior
+ * written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/**
+ * @file
+ * @brief Receive Buffer Definitions
+ */
+
+#include "config.h"
+#include "libdrizzle/common.h"
+
+#if defined(HAVE_SYS_MMAN_H) && defined(HAVE_MEMFD_CREATE)
+# include <sys/mman.h>
+# define DRIZZLE_BUFFER_MIRROR 1
+#endif
+
+/**
+ * @addtogroup drizzle_buffer_static Static Receive Buffer Declarations
+ * @ingroup drizzle_buffer
+ * @{
+ */
+
+#ifdef DRIZZLE_BUFFER_MIRROR
+/**
+ * Map size bytes of anonymous memory twice in a row.
+ *
+ * @param[in] size Size of one mapping, a multiple of the page size.
+ * @return Start of the first mapping, or NULL on failure.
+ */
+static unsigned char *_mirror_map(size_t size)
+{
+  int fd= memfd_create("libdrizzle", MFD_CLOEXEC);
+  if (fd == -1)
+  {
+    return NULL;
+  }
+
+  if (ftruncate(fd, (off_t)size) == -1)
+  {
+    close(fd);
+    return NULL;
+  }
+
+  /* Reserve the address range first so both halves land next to each
+     other, then place the shared pages over it. */
+  void *base= mmap(NULL, size * 2, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (base == MAP_FAILED)
+  {
+    close(fd);
+    return NULL;
+  }
+
+  unsigned char *start= (unsigned char *)base;
+  if (mmap(start, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED ||
+      mmap(start + size, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED)
+  {
+    munmap(base, size * 2);
+    close(fd);
+    return NULL;
+  }
+
+  close(fd);
+
+  return start;
+}
+#endif
+
+/** @} */
+
+/*
+ * Local Definitions
+ */
+
+drizzle_return_t drizzle_buffer_resize(drizzle_st *con, size_t size)
+{
+  if (con == NULL || size < con->buffer_size)
+  {
+    return DRIZZLE_RETURN_INVALID_ARGUMENT;
+  }
+
+  if (con->uring != NULL)
+  {
+    drizzle_uring_unregister(con);
+  }
+
+#ifdef DRIZZLE_BUFFER_MIRROR
+  /* Every mirrored buffer costs a few extra mappings, which adds up with
+     thousands of mostly idle connections. */
+  long page_size= sysconf(_SC_PAGESIZE);
+  if (page_size > 0 && con->options.low_footprint == false)
+  {
+    size_t mirror_size= (size + (size_t)page_size - 1) & ~((size_t)page_size - 1);
+    unsigned char *mirror= _mirror_map(mirror_size);
+    if (mirror != NULL)
+    {
+      if (con->buffer_size != 0)
+      {
+        memcpy(mirror, con->buffer_ptr, con->buffer_size);
+      }
+      drizzle_buffer_free(con);
+      con->buffer= mirror;
+      con->buffer_ptr= mirror;
+      con->buffer_allocation= mirror_size;
+      con->buffer_mirrored= true;
+
+      return DRIZZLE_RETURN_OK;
+    }
+  }
+#endif
+
+  if (con->buffer_mirrored)
+  {
+    unsigned char *heap= (unsigned char *)malloc(size);
+    if (heap == NULL)
+    {
+      drizzle_set_error(con, __func__, "malloc failure");
+      return DRIZZLE_RETURN_MEMORY;
+    }
+    if (con->buffer_size != 0)
+    {
+      memcpy(heap, con->buffer_ptr, con->buffer_size);
+    }
+    drizzle_buffer_free(con);
+    con->buffer= heap;
+  }
+  else
+  {
+    // Shift data to beginning of the buffer then resize
+    // This means that buffer_ptr isn't screwed up by realloc pointer move
+    if (con->buffer_ptr != con->buffer && con->buffer_size != 0)
+    {
+      memmove(con->buffer, con->buffer_ptr, con->buffer_size);
+    }
+    unsigned char *realloc_buffer= (unsigned char *)realloc(con->buffer, size);
+    if (realloc_buffer == NULL)
+    {
+      drizzle_set_error(con, __func__, "realloc failure");
+      return DRIZZLE_RETURN_MEMORY;
+    }
+    con->buffer= realloc_buffer;
+  }
+
+  con->buffer_ptr= con->buffer;
+  con->buffer_allocation= size;
+  con->buffer_mirrored= false;
+
+  return DRIZZLE_RETURN_OK;
+}
+
+drizzle_return_t drizzle_buffer_reserve(drizzle_st *con, size_t size)
+{
+  if (con == NULL)
+  {
+    return DRIZZLE_RETURN_INVALID_ARGUMENT;
+  }
+
+  if (size <= con->buffer_allocation)
+  {
+    return DRIZZLE_RETURN_OK;
+  }
+
+  if (size > DRIZZLE_MAX_BUFFER_SIZE)
+  {
+    drizzle_set_error(con, __func__, "buffer too small:%" PRIu64, (uint64_t)size);
+    return DRIZZLE_RETURN_INTERNAL_ERROR;
+  }
+
+  size_t allocation= con->buffer_allocation;
+  if (allocation == 0)
+  {
+    allocation= drizzle_buffer_resting_size(con);
+  }
+  while (allocation < size)
+  {
+    allocation*= 2;
+  }
+
+  drizzle_log_debug(con, "buffer reserved: %" PRIu64, (uint64_t)allocation);
+
+  return drizzle_buffer_resize(con, allocation);
+}
+
+void drizzle_buffer_free(drizzle_st *con)
+{
+  if (con == NULL || con->buffer == NULL)
+  {
+    return;
+  }
+
+  if (con->uring != NULL)
+  {
+    drizzle_uring_unregister(con);
+  }
+
+#ifdef DRIZZLE_BUFFER_MIRROR
+  if (con->buffer_mirrored)
+  {
+    munmap(con->buffer, con->buffer_allocation * 2);
+  }
+  else
+#endif
+  {
+    free(con->buffer);
+  }
+
+  con->buffer= NULL;
+  con->buffer_ptr= NULL;
+  con->buffer_mirrored= false;
+}
+
+void drizzle_buffer_rewind(drizzle_st *con)
+{
+  if (con->buffer_size == 0)
+  {
+    /* Give the memory back once enough reads in a row fit in the resting
+       size, so a stream of large packets does not grow and shrink the buffer
+       for each of them. If that fails the bigger buffer is simply kept. */
+    if (con->buffer_allocation > drizzle_buffer_resting_size(con) &&
+        con->buffer_small_reads >= DRIZZLE_BUFFER_SHRINK_READS)
+    {
+      (void)drizzle_buffer_resize(con, drizzle_buffer_resting_size(con));
+    }
+    con->buffer_ptr= con->buffer;
+  }
+  else if (con->buffer_mirrored)
+  {
+    if (con->buffer_ptr >= con->buffer + con->buffer_allocation)
+    {
+      con->buffer_ptr-= con->buffer_allocation;
+    }
+  }
+  else if ((size_t)(con->buffer_ptr - con->buffer) > (con->buffer_allocation / 2))
+  {
+    memmove(con->buffer, con->buffer_ptr, con->buffer_size);
+    con->buffer_ptr= con->buffer;
+  }
+}
+
+void drizzle_buffer_shrink(drizzle_st *con)
+{
+  /* A read the reactor ring owns or has completed still lands in the
+     buffer. */
+  if (con->buffer_size != 0 || con->uring_reading || con->uring_read_done ||
+      con->buffer_allocation <= drizzle_buffer_resting_size(con))
+  {
+    return;
+  }
+
+  /* If that fails the bigger buffer is simply kept. */
+  (void)drizzle_buffer_resize(con, drizzle_buffer_resting_size(con));
+}
+
+size_t drizzle_buffer_resting_size(const drizzle_st *con)
+{
+  if (con->options.low_footprint)
+  {
+    return DRIZZLE_LOW_FOOTPRINT_BUFFER_SIZE;
+  }
+
+  return DRIZZLE_DEFAULT_BUFFER_SIZE;
+}
+
+size_t drizzle_buffer_available(const drizzle_st *con)
+{
+  if (con->buffer_mirrored)
+  {
+    return con->buffer_allocation - con->buffer_size;
+  }
+
+  return con->buffer_allocation - ((size_t)(con->buffer_ptr - con->buffer) + con->buffer_size);
+}
@@ -0,0 +1,149 @@
+/* vim:expandtab:shiftwidth=2:tabstop=2:smarttab:
+ *
+ * Drizzle Client & Protocol Library
+ *
+ * Copyright (C) 2012-2013 Drizzle Developer Group
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following disclaimer
+ * in the documentation and/or other materials provided with the
+ * distribution.
+ *
+ *     * The names of its contributors may not be used to endorse or
+ * promote products derived from this software without specific prior
+ * written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#pragma once
+
+/**
+ * @file
+ * @brief Receive Buffer Declarations
+ */
+
+/* Reads in a row that must fit in the resting size before a grown buffer
+   is shrunk again. */
+#define DRIZZLE_BUFFER_SHRINK_READS 16
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @addtogroup drizzle_buffer Receive Buffer Declarations
+ * @ingroup drizzle_con
+ *
+ * Where the platform allows it the connection buffer is a ring: the same
+ * pages are mapped twice, back to back, so unread data that wraps around
+ * the end of the allocation is still seen as one contiguous range starting
+ * at buffer_ptr. Packet parsing can then read across the wrap point and the
+ * buffer never has to be compacted. Otherwise, and for connections in low
+ * footprint mode, a plain heap buffer is used and the unread tail is moved
+ * back to the front when needed.
+ * @{
+ */
+
+/**
+ * Allocate the buffer of a connection, replacing any existing one. Unread
+ * data after buffer_ptr is carried over to the start of the new buffer.
+ *
+ * @param[in] con Connection structure previously initialized with
+ *  drizzle_create(), drizzle_clone(), or related functions.
+ * @param[in] size Requested size in bytes, rounded up to the page size when
+ *  the buffer is mirrored.
+ * @return Standard drizzle return value.
+ */
+drizzle_return_t drizzle_buffer_resize(drizzle_st *con, size_t size);
+
+/**
+ * Make sure the buffer can hold at least size bytes of unread data, growing
+ * it to the next power of two in a single step. Used when a packet header
+ * announces a packet larger than the current buffer, so the partial packet
+ * is copied once rather than on every doubling.
+ *
+ * @param[in] con Connection structure previously initialized with
+ *  drizzle_create(), drizzle_clone(), or related functions.
+ * @param[in] size Number of bytes that must fit in the buffer.
+ * @return Standard drizzle return value.
+ */
+drizzle_return_t drizzle_buffer_reserve(drizzle_st *con, size_t size);
+
+/**
+ * Release the buffer of a connection.
+ *
+ * @param[in] con Connection structure previously initialized with
+ *  drizzle_create(), drizzle_clone(), or related functions.
+ */
+void drizzle_buffer_free(drizzle_st *con);
+
+/**
+ * Prepare the buffer for reading more data: rewind an empty buffer, wrap
+ * buffer_ptr back into the first mapping of a mirrored buffer, or move the
+ * unread tail of a plain buffer to the front once more than half of it has
+ * been consumed. An empty buffer that was grown for a large packet is
+ * shrunk back to drizzle_buffer_resting_size() once the last
+ * DRIZZLE_BUFFER_SHRINK_READS reads all fitted in that size.
+ *
+ * @param[in] con Connection structure previously initialized with
+ *  drizzle_create(), drizzle_clone(), or related functions.
+ */
+void drizzle_buffer_rewind(drizzle_st *con);
+
+/**
+ * Shrink a buffer that was grown for a large packet back to
+ * drizzle_buffer_resting_size() if nothing is left to read from it. Called
+ * at the end of a result, where no packet of the result can follow and the
+ * hysteresis of drizzle_buffer_rewind() would keep the memory until enough
+ * further reads.
+ *
+ * @param[in] con Connection structure previously initialized with
+ *  drizzle_create(), drizzle_clone(), or related functions.
+ */
+void drizzle_buffer_shrink(drizzle_st *con);
+
+/**
+ * Get the size the buffer of a connection is returned to once it is empty:
+ * DRIZZLE_LOW_FOOTPRINT_BUFFER_SIZE in low footprint mode, otherwise
+ * DRIZZLE_DEFAULT_BUFFER_SIZE.
+ *
+ * @param[in] con Connection structure previously initialized with
+ *  drizzle_create(), drizzle_clone(), or related functions.
+ * @return Size in bytes.
+ */
+size_t drizzle_buffer_resting_size(const drizzle_st *con);
+
+/**
+ * Get the number of bytes that can be appended after the unread data.
+ *
+ * @param[in] con Connection structure previously initialized with
+ *  drizzle_create(), drizzle_clone(), or related functions.
+ * @return Contiguous free space in bytes.
+ */
+size_t drizzle_buffer_available(const drizzle_st *con);
+
+/** @} */
+
+#ifdef __cplusplus
+}
+#endif
@@ -45,6 +45,216 @@
 #include "config.h"
 #include "libdrizzle/common.h"
 
+/**
+ * @addtogroup drizzle_column_static Static Column Declarations
+ * @ingroup drizzle_column
+ * @{
+ */
+
+/**
+ * Read the length of a length encoded string of a column definition packet
+ * and check the string is inside the packet. A NULL string reads as empty.
+ *
+ * @param[in,out] ptr Start of the string, moved past its length.
+ * @param[in] end End of the packet.
+ * @param[out] length Length of the string.
+ * @return false if the string runs past the end of the packet.
+ */
+static bool _column_string_length(unsigned char **ptr, unsigned char *end,
+                                  uint64_t *length)
+{
+  unsigned char *data= *ptr;
+  size_t bytes;
+
+  if (data >= end)
+  {
+    return false;
+  }
+
+  switch (data[0])
+  {
+    case 251:
+      *length= 0;
+      bytes= 1;
+      break;
+    case 252:
+      bytes= 3;
+      break;
+    case 253:
+      bytes= 4;
+      break;
+    case 254:
+      bytes= 9;
+      break;
+    default:
+      *length= data[0];
+      bytes= 1;
+      break;
+  }
+
+  if ((size_t)(end - data) < bytes)
+  {
+    return false;
+  }
+
+  if (bytes == 3)
+  {
+    *length= drizzle_get_byte2(data + 1);
+  }
+  else if (bytes == 4)
+  {
+    *length= drizzle_get_byte3(data + 1);
+  }
+  else if (bytes == 9)
+  {
+    *length= drizzle_get_byte8(data + 1);
+  }
+
+  if (*length > (uint64_t)(end - data) - bytes)
+  {
+    return false;
+  }
+
+  *ptr= data + bytes;
+  return true;
+}
+
+/**
+ * Decode the names of a column the first time one of them is asked for.
+ * They are decoded into a copy, NUL terminated, which has the size of the
+ * encoded names because each length took at least one byte. The encoded
+ * names stay as received so a resent definition can be compared to them.
+ * If the copy cannot be allocated the names are left NULL, so the next call
+ * tries again.
+ *
+ * @param[in,out] column Column to decode the names of.
+ * @return Standard drizzle return value.
+ */
+static drizzle_return_t _column_decode_names(drizzle_column_st *column)
+{
+  const char **strings[6]= {
+    &column->catalog,
+    &column->db,
+    &column->table,
+    &column->orig_table,
+    &column->name,
+    &column->orig_name
+  };
+
+  if (column->catalog != NULL)
+  {
+    return DRIZZLE_RETURN_OK;
+  }
+
+  unsigned char *ptr= column->names;
+  unsigned char *end= column->names + column->names_size;
+  char *decoded= NULL;
+
+  /* Only a column that was never read has no names. */
+  if (column->names != NULL)
+  {
+    decoded= (char *)drizzle_arena_alloc(&column->result->column_arena,
+                                         column->names_size);
+    if (decoded == NULL)
+    {
+      drizzle_set_error(column->result->con, __func__, "Failed to allocate.");
+      return DRIZZLE_RETURN_MEMORY;
+    }
+  }
+
+  for (size_t x= 0; x < 6; x++)
+  {
+    uint64_t length;
+
+    if (decoded == NULL || !_column_string_length(&ptr, end, &length))
+    {
+      *strings[x]= "";
+      continue;
+    }
+
+    memcpy(decoded, ptr, (size_t)length);
+    decoded[length]= '\0';
+    *strings[x]= decoded;
+    decoded+= length + 1;
+    ptr+= length;
+  }
+
+  return DRIZZLE_RETURN_OK;
+}
+
+/**
+ * Hash a column name, FNV-1a.
+ *
+ * @param[in] name Column name.
+ * @return Hash of the name.
+ */
+static uint32_t _column_hash(const char *name)
+{
+  uint32_t hash= 2166136261U;
+
+  for (; *name != '\0'; name++)
+  {
+    hash^= (unsigned char)*name;
+    hash*= 16777619U;
+  }
+
+  return hash;
+}
+
+/**
+ * Build the hash table of the names of the buffered columns of a result.
+ * Open addressing with linear probing, at most half full. A name that is
+ * already there is left out so that lookups find the first column with it.
+ *
+ * @param[in,out] result Result with buffered columns.
+ * @return Standard drizzle return value.
+ */
+static drizzle_return_t _column_hash_build(drizzle_result_st *result)
+{
+  uint32_t size= 8;
+  while (size < (uint32_t)result->column_count * 2)
+  {
+    size*= 2;
+  }
+
+  result->column_hash= new (std::nothrow) uint16_t[size]();
+  if (result->column_hash == NULL)
+  {
+    drizzle_set_error(result->con, __func__, "Failed to allocate.");
+    return DRIZZLE_RETURN_MEMORY;
+  }
+  result->column_hash_size= size;
+
+  for (uint16_t column= 0; column < result->column_count; column++)
+  {
+    drizzle_return_t ret= _column_decode_names(&result->column_buffer[column]);
+    if (ret != DRIZZLE_RETURN_OK)
+    {
+      delete[] result->column_hash;
+      result->column_hash= NULL;
+      return ret;
+    }
+
+    const char *name= result->column_buffer[column].name;
+    uint32_t slot= _column_hash(name) & (size - 1);
+
+    while (result->column_hash[slot] != 0 &&
+           strcmp(name, drizzle_column_name(&result->column_buffer[result->column_hash[slot] - 1])) != 0)
+    {
+      slot= (slot + 1) & (size - 1);
+    }
+
+    if (result->column_hash[slot] == 0)
+    {
+      result->column_hash[slot]= (uint16_t)(column + 1);
+    }
+  }
+
+  return DRIZZLE_RETURN_OK;
+}
+
+/** @} */
+
 /*
  * Common definitions
  */
@@ -111,6 +321,10 @@ const char *drizzle_column_catalog(drizzle_column_st *column)
     return NULL;
   }
 
+  if (_column_decode_names(column) != DRIZZLE_RETURN_OK)
+  {
+    return NULL;
+  }
   return column->catalog;
 }
 
@@ -121,6 +335,10 @@ const char *drizzle_column_db(drizzle_column_st *column)
     return NULL;
   }
 
+  if (_column_decode_names(column) != DRIZZLE_RETURN_OK)
+  {
+    return NULL;
+  }
   return column->db;
 }
 
@@ -131,6 +349,10 @@ const char *drizzle_column_table(drizzle_column_st *column)
     return NULL;
   }
 
+  if (_column_decode_names(column) != DRIZZLE_RETURN_OK)
+  {
+    return NULL;
+  }
   return column->table;
 }
 
@@ -141,6 +363,10 @@ const char *drizzle_column_orig_table(drizzle_column_st *column)
     return NULL;
   }
 
+  if (_column_decode_names(column) != DRIZZLE_RETURN_OK)
+  {
+    return NULL;
+  }
   return column->orig_table;
 }
 
@@ -151,6 +377,10 @@ const char *drizzle_column_name(drizzle_column_st *column)
     return NULL;
   }
 
+  if (_column_decode_names(column) != DRIZZLE_RETURN_OK)
+  {
+    return NULL;
+  }
   return column->name;
 }
 
@@ -161,6 +391,10 @@ const char *drizzle_column_orig_name(drizzle_column_st *column)
     return NULL;
   }
 
+  if (_column_decode_names(column) != DRIZZLE_RETURN_OK)
+  {
+    return NULL;
+  }
   return column->orig_name;
 }
 
@@ -303,9 +537,111 @@ const unsigned char *drizzle_column_default_value(drizzle_column_st *column,
   }
 
   *size= column->default_value_size;
+  if (column->default_value == NULL)
+  {
+    return (const unsigned char *)"";
+  }
+
   return column->default_value;
 }
 
+drizzle_return_t drizzle_column_binary_size(drizzle_column_type_t type,
+                                            uint32_t *size)
+{
+  switch (type)
+  {
+    case DRIZZLE_COLUMN_TYPE_NULL:
+      *size= 0;
+      break;
+    case DRIZZLE_COLUMN_TYPE_TINY:
+      *size= 1;
+      break;
+    case DRIZZLE_COLUMN_TYPE_SHORT:
+    case DRIZZLE_COLUMN_TYPE_YEAR:
+      *size= 2;
+      break;
+    case DRIZZLE_COLUMN_TYPE_INT24:
+    case DRIZZLE_COLUMN_TYPE_LONG:
+    case DRIZZLE_COLUMN_TYPE_FLOAT:
+      *size= 4;
+      break;
+    case DRIZZLE_COLUMN_TYPE_LONGLONG:
+    case DRIZZLE_COLUMN_TYPE_DOUBLE:
+      *size= 8;
+      break;
+    case DRIZZLE_COLUMN_TYPE_TIME:
+    case DRIZZLE_COLUMN_TYPE_DATE:
+    case DRIZZLE_COLUMN_TYPE_DATETIME:
+    case DRIZZLE_COLUMN_TYPE_TIMESTAMP:
+    case DRIZZLE_COLUMN_TYPE_TINY_BLOB:
+    case DRIZZLE_COLUMN_TYPE_MEDIUM_BLOB:
+    case DRIZZLE_COLUMN_TYPE_LONG_BLOB:
+    case DRIZZLE_COLUMN_TYPE_BLOB:
+    case DRIZZLE_COLUMN_TYPE_BIT:
+    case DRIZZLE_COLUMN_TYPE_STRING:
+    case DRIZZLE_COLUMN_TYPE_VAR_STRING:
+    case DRIZZLE_COLUMN_TYPE_DECIMAL:
+    case DRIZZLE_COLUMN_TYPE_NEWDECIMAL:
+    case DRIZZLE_COLUMN_TYPE_NEWDATE:
+      *size= 0;
+      return DRIZZLE_RETURN_OK;
+    case DRIZZLE_COLUMN_TYPE_VARCHAR:
+    case DRIZZLE_COLUMN_TYPE_ENUM:
+    case DRIZZLE_COLUMN_TYPE_SET:
+    case DRIZZLE_COLUMN_TYPE_GEOMETRY:
+    /* We do not need to support these three: they exist internally to the MySQL server, but do not appear on the wire */
+    case DRIZZLE_COLUMN_TYPE_TIMESTAMP2:
+    case DRIZZLE_COLUMN_TYPE_DATETIME2:
+    case DRIZZLE_COLUMN_TYPE_TIME2:
+    default:
+      return DRIZZLE_RETURN_UNEXPECTED_DATA;
+  }
+
+  return DRIZZLE_RETURN_OK;
+}
+
+uint16_t drizzle_column_lookup(drizzle_result_st *result,
+                               const char *column_name,
+                               drizzle_return_t *ret_ptr)
+{
+  if (result->column_count == 0)
+  {
+    *ret_ptr= DRIZZLE_RETURN_NOT_FOUND;
+    return 0;
+  }
+
+  if (result->column_buffer == NULL)
+  {
+    drizzle_set_error(result->con, __func__, "columns have not been buffered");
+    *ret_ptr= DRIZZLE_RETURN_INVALID_ARGUMENT;
+    return 0;
+  }
+
+  if (result->column_hash == NULL)
+  {
+    *ret_ptr= _column_hash_build(result);
+    if (*ret_ptr != DRIZZLE_RETURN_OK)
+    {
+      return 0;
+    }
+  }
+
+  uint32_t slot= _column_hash(column_name) & (result->column_hash_size - 1);
+  while (result->column_hash[slot] != 0)
+  {
+    uint16_t column= (uint16_t)(result->column_hash[slot] - 1);
+    if (strcmp(column_name, drizzle_column_name(&result->column_buffer[column])) == 0)
+    {
+      *ret_ptr= DRIZZLE_RETURN_OK;
+      return column;
+    }
+    slot= (slot + 1) & (result->column_hash_size - 1);
+  }
+
+  *ret_ptr= DRIZZLE_RETURN_NOT_FOUND;
+  return 0;
+}
+
 /*
  * Client definitions
  */
@@ -367,6 +703,35 @@ drizzle_column_st *drizzle_column_read(drizzle_result_st *result,
 
   if (result->has_state())
   {
+    /* Without the EOF packet there is nothing left to read after the last
+       column. */
+    if (result->column_current == result->column_count &&
+        (result->con->capabilities & DRIZZLE_CAPABILITIES_DEPRECATE_EOF))
+    {
+      result->column= NULL;
+      *ret_ptr= DRIZZLE_RETURN_OK;
+      return NULL;
+    }
+
+    /* Without column definitions the columns are left as they are, a
+       prepared statement fills them in from earlier results. */
+    if (result->no_metadata && result->column_current < result->column_count)
+    {
+      if (result->column == NULL)
+      {
+        result->column= drizzle_column_create(result);
+        if (result->column == NULL)
+        {
+          *ret_ptr= DRIZZLE_RETURN_MEMORY;
+          return NULL;
+        }
+      }
+
+      result->column_current++;
+      *ret_ptr= DRIZZLE_RETURN_OK;
+      return result->column;
+    }
+
     result->push_state(drizzle_state_column_read);
     result->push_state(drizzle_state_packet_read);
   }
@@ -493,35 +858,36 @@ uint16_t drizzle_column_current(drizzle_result_st *result)
  * Server definitions
  */
 
-void drizzle_column_set_default_value(drizzle_column_st *column,
-                                      const unsigned char *default_value,
-                                      size_t size)
+drizzle_return_t drizzle_column_set_default_value(drizzle_column_st *column,
+                                                  const unsigned char *default_value,
+                                                  size_t size)
 {
   if (column == NULL)
   {
-    return;
+    return DRIZZLE_RETURN_INVALID_ARGUMENT;
   }
 
   if (default_value == NULL)
   {
-    column->default_value[0]= 0;
+    column->default_value= NULL;
+    column->default_value_size= 0;
+    return DRIZZLE_RETURN_OK;
   }
-  else
+
+  column->default_value=
+    (unsigned char *)drizzle_arena_alloc(&column->result->column_arena,
+                                         size + 1);
+  if (column->default_value == NULL)
   {
-    if (size < DRIZZLE_MAX_DEFAULT_VALUE_SIZE)
-    {
-      memcpy(column->default_value, default_value, size);
-      column->default_value[size]= 0;
-      column->default_value_size= size;
-    }
-    else
-    {
-      memcpy(column->default_value, default_value,
-             DRIZZLE_MAX_DEFAULT_VALUE_SIZE - 1);
-      column->default_value[DRIZZLE_MAX_DEFAULT_VALUE_SIZE - 1]= 0;
-      column->default_value_size= DRIZZLE_MAX_DEFAULT_VALUE_SIZE;
-    }
+    drizzle_set_error(column->result->con, __func__, "Failed to allocate.");
+    return DRIZZLE_RETURN_MEMORY;
   }
+
+  memcpy(column->default_value, default_value, size);
+  column->default_value[size]= 0;
+  column->default_value_size= size;
+
+  return DRIZZLE_RETURN_OK;
 }
 
 /*
@@ -581,17 +947,50 @@ drizzle_return_t drizzle_state_column_read(drizzle_st *con)
       column= con->result->column;
     }
 
-    /* These functions can only fail if they need to read data, but we know we
-       buffered the entire packet, so ignore returns. */
-    (void)drizzle_unpack_string(con, column->catalog, DRIZZLE_MAX_CATALOG_SIZE);
-    (void)drizzle_unpack_string(con, column->db, DRIZZLE_MAX_DB_SIZE);
-    (void)drizzle_unpack_string(con, column->table, DRIZZLE_MAX_TABLE_SIZE);
-    (void)drizzle_unpack_string(con, column->orig_table,
-                                DRIZZLE_MAX_TABLE_SIZE);
-    (void)drizzle_unpack_string(con, column->name,
-                                DRIZZLE_MAX_COLUMN_NAME_SIZE);
-    (void)drizzle_unpack_string(con, column->orig_name,
-                                DRIZZLE_MAX_COLUMN_NAME_SIZE);
+    column->result= con->result;
+
+    /* Only find where the names end, they are copied as they are and decoded
+       when first asked for. */
+    unsigned char *ptr= con->buffer_ptr;
+    unsigned char *end= con->buffer_ptr + con->packet_size;
+    for (size_t x= 0; x < 6; x++)
+    {
+      uint64_t length;
+      if (!_column_string_length(&ptr, end, &length))
+      {
+        drizzle_set_error(con, __func__, "column name extends past end of packet");
+        return DRIZZLE_RETURN_UNEXPECTED_DATA;
+      }
+      ptr+= length;
+    }
+
+    if (end - ptr < 13)
+    {
+      drizzle_set_error(con, __func__, "column definition is too short");
+      return DRIZZLE_RETURN_UNEXPECTED_DATA;
+    }
+
+    /* A prepared statement reuses the columns of its last result, which
+       usually are sent again unchanged. */
+    uint32_t names_size= (uint32_t)(ptr - con->buffer_ptr);
+    if (column->names == NULL || column->names_size != names_size ||
+        memcmp(column->names, con->buffer_ptr, names_size) != 0)
+    {
+      column->names= (unsigned char *)drizzle_arena_alloc(&con->result->column_arena,
+                                                          names_size);
+      if (column->names == NULL)
+      {
+        drizzle_set_error(con, __func__, "Failed to allocate.");
+        return DRIZZLE_RETURN_MEMORY;
+      }
+      memcpy(column->names, con->buffer_ptr, names_size);
+      column->names_size= names_size;
+      column->catalog= NULL;
+    }
+
+    con->buffer_ptr+= names_size;
+    con->buffer_size-= names_size;
+    con->packet_size-= names_size;
 
     /* Skip one filler byte. */
     column->charset= (drizzle_charset_t)drizzle_get_byte2(con->buffer_ptr + 1);
@@ -607,6 +1006,7 @@ drizzle_return_t drizzle_state_column_read(drizzle_st *con)
     }
 
     column->decimals= con->buffer_ptr[10];
+    column->size= 0;
     /* Skip two reserved bytes. */
 
     con->buffer_ptr+= 13;
@@ -615,14 +1015,27 @@ drizzle_return_t drizzle_state_column_read(drizzle_st *con)
 
     if (con->packet_size > 0)
     {
-      drizzle_column_set_default_value(column, con->buffer_ptr,
-                                       con->packet_size);
+      if (column->default_value == NULL ||
+          column->default_value_size != con->packet_size ||
+          memcmp(column->default_value, con->buffer_ptr, con->packet_size) != 0)
+      {
+        drizzle_return_t ret= drizzle_column_set_default_value(column,
+                                                               con->buffer_ptr,
+                                                               con->packet_size);
+        if (ret != DRIZZLE_RETURN_OK)
+        {
+          return ret;
+        }
+      }
 
       con->buffer_ptr+= con->packet_size;
       con->buffer_size-= con->packet_size;
     }
     else
-      column->default_value[0]= 0;
+    {
+      column->default_value= NULL;
+      column->default_value_size= 0;
+    }
 
     con->result->column_current++;
 
@@ -37,11 +37,49 @@
 
 #pragma once
 
+/* First slab of the arena holding the names of the columns of a result. */
+#define DRIZZLE_COLUMN_ARENA_SLAB_SIZE 1024
+
 /**
  * Initialize a column structure.
  */
 drizzle_column_st *drizzle_column_create(drizzle_result_st *result);
 
-void drizzle_column_set_default_value(drizzle_column_st *column,
-                                      const unsigned char *default_value,
-                                      size_t size);
+/**
+ * Get how the values of a column type are sent in binary rows.
+ *
+ * @param[in] type Column type.
+ * @param[out] size Size of the values, 0 if each value starts with its
+ *  length.
+ * @return DRIZZLE_RETURN_OK, or DRIZZLE_RETURN_UNEXPECTED_DATA for types that
+ *  are not sent in binary rows.
+ */
+drizzle_return_t drizzle_column_binary_size(drizzle_column_type_t type,
+                                            uint32_t *size);
+
+/**
+ * Find a buffered column by name. The first lookup builds a hash table of
+ * the column names of the result, later ones cost one probe.
+ *
+ * @param[in,out] result Result with buffered columns.
+ * @param[in] column_name Name of the column.
+ * @param[out] ret_ptr DRIZZLE_RETURN_OK, DRIZZLE_RETURN_NOT_FOUND if there
+ *  is no column of that name or another standard drizzle return value.
+ * @return Index of the first column of that name.
+ */
+uint16_t drizzle_column_lookup(drizzle_result_st *result,
+                               const char *column_name,
+                               drizzle_return_t *ret_ptr);
+
+/**
+ * Set the default value of a column, copied into the column_arena of its
+ * result.
+ *
+ * @param[in,out] column Column to set the default value of.
+ * @param[in] default_value The value, or NULL for none.
+ * @param[in] size Size of the value.
+ * @return Standard drizzle return value.
+ */
+drizzle_return_t drizzle_column_set_default_value(drizzle_column_st *column,
+                                                  const unsigned char *default_value,
+                                                  size_t size);
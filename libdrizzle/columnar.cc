@@ -0,0 +1,651 @@
+/* vim:expandtab:shiftwidth=2:tabstop=2:smarttab:
+ *
+ * Drizzle Client & Protocol Library
+ *
+ * Copyright (C) 2012-2013 Drizzle Developer Group
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following disclaimer
+ * in the documentation and/or other materials provided with the
+ * distribution.
+ *
+ *     * The names of its contributors may not be used to endorse or
+ * promote products derived from this software without specific prior
+ * written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/**
+ * @file
+ * @brief Columnar Result Definitions
+ */
+
+#include "config.h"
+#include "libdrizzle/common.h"
+
+/* Rows the vectors first have room for, they double whenever they fill up. */
+#define DRIZZLE_COLUMNAR_SIZE 64
+/* Smallest allocation for the data of a variable length column. */
+#define DRIZZLE_COLUMNAR_DATA_SIZE 4096
+
+/**
+ * @addtogroup drizzle_columnar_static Static Columnar Result Declarations
+ * @ingroup drizzle_columnar
+ * @{
+ */
+
+/**
+ * Get the size of the values of a column if it is stored as fixed width.
+ *
+ * @param[in] result Result being buffered.
+ * @param[in] column Column number.
+ * @return Bytes per value, 0 for variable length values.
+ */
+static size_t _column_width(drizzle_result_st *result, uint16_t column)
+{
+  if (!result->binary_rows)
+  {
+    return 0;
+  }
+
+  switch (result->column_buffer[column].type)
+  {
+    case DRIZZLE_COLUMN_TYPE_TINY:
+      return 1;
+    case DRIZZLE_COLUMN_TYPE_SHORT:
+    case DRIZZLE_COLUMN_TYPE_YEAR:
+      return 2;
+    case DRIZZLE_COLUMN_TYPE_INT24:
+    case DRIZZLE_COLUMN_TYPE_LONG:
+    case DRIZZLE_COLUMN_TYPE_FLOAT:
+      return 4;
+    case DRIZZLE_COLUMN_TYPE_LONGLONG:
+    case DRIZZLE_COLUMN_TYPE_DOUBLE:
+      return 8;
+    case DRIZZLE_COLUMN_TYPE_NULL:
+    case DRIZZLE_COLUMN_TYPE_TIME:
+    case DRIZZLE_COLUMN_TYPE_DATE:
+    case DRIZZLE_COLUMN_TYPE_DATETIME:
+    case DRIZZLE_COLUMN_TYPE_TIMESTAMP:
+    case DRIZZLE_COLUMN_TYPE_TINY_BLOB:
+    case DRIZZLE_COLUMN_TYPE_MEDIUM_BLOB:
+    case DRIZZLE_COLUMN_TYPE_LONG_BLOB:
+    case DRIZZLE_COLUMN_TYPE_BLOB:
+    case DRIZZLE_COLUMN_TYPE_BIT:
+    case DRIZZLE_COLUMN_TYPE_STRING:
+    case DRIZZLE_COLUMN_TYPE_VAR_STRING:
+    case DRIZZLE_COLUMN_TYPE_DECIMAL:
+    case DRIZZLE_COLUMN_TYPE_NEWDECIMAL:
+    case DRIZZLE_COLUMN_TYPE_NEWDATE:
+    case DRIZZLE_COLUMN_TYPE_VARCHAR:
+    case DRIZZLE_COLUMN_TYPE_ENUM:
+    case DRIZZLE_COLUMN_TYPE_SET:
+    case DRIZZLE_COLUMN_TYPE_GEOMETRY:
+    case DRIZZLE_COLUMN_TYPE_TIMESTAMP2:
+    case DRIZZLE_COLUMN_TYPE_DATETIME2:
+    case DRIZZLE_COLUMN_TYPE_TIME2:
+    default:
+      return 0;
+  }
+}
+
+/**
+ * Double the room of the column vectors of a result.
+ *
+ * @param[in,out] result Result being buffered.
+ * @return Standard drizzle return value.
+ */
+static drizzle_return_t _columnar_grow(drizzle_result_st *result)
+{
+  drizzle_columnar_st *columnar= result->columnar;
+  uint64_t size= columnar->row_list_size;
+  uint64_t rows= size ? size * 2 : DRIZZLE_COLUMNAR_SIZE;
+
+  for (uint16_t x= 0; x < result->column_count; x++)
+  {
+    drizzle_column_vector_st *vector= &columnar->columns[x];
+
+    if (vector->width)
+    {
+      uint8_t *values= (uint8_t *)realloc(vector->values, rows * vector->width);
+      if (values == NULL)
+      {
+        drizzle_set_error(result->con, __func__, "Failed to realloc values.");
+        return DRIZZLE_RETURN_MEMORY;
+      }
+      vector->values= values;
+    }
+    else
+    {
+      uint64_t *offsets= (uint64_t *)realloc(vector->offsets,
+                                             sizeof(uint64_t) * (rows + 1));
+      if (offsets == NULL)
+      {
+        drizzle_set_error(result->con, __func__, "Failed to realloc offsets.");
+        return DRIZZLE_RETURN_MEMORY;
+      }
+      if (vector->offsets == NULL)
+      {
+        offsets[0]= 0;
+      }
+      vector->offsets= offsets;
+    }
+
+    /* Both sizes are multiples of 8 rows. */
+    uint8_t *validity= (uint8_t *)realloc(vector->validity, rows / 8);
+    if (validity == NULL)
+    {
+      drizzle_set_error(result->con, __func__, "Failed to realloc validity.");
+      return DRIZZLE_RETURN_MEMORY;
+    }
+    memset(validity + size / 8, 0, (rows - size) / 8);
+    vector->validity= validity;
+  }
+
+  columnar->row_list_size= rows;
+  return DRIZZLE_RETURN_OK;
+}
+
+/**
+ * Append bytes to the value of the current row of a variable length column.
+ *
+ * @param[in,out] result Result being buffered.
+ * @param[in,out] vector Column vector to append to.
+ * @param[in] field Bytes to append.
+ * @param[in] size Number of bytes.
+ * @return Standard drizzle return value.
+ */
+static drizzle_return_t _columnar_append(drizzle_result_st *result,
+                                         drizzle_column_vector_st *vector,
+                                         const char *field, size_t size)
+{
+  uint64_t *end= &vector->offsets[result->row_count - result->columnar->row_first];
+
+  if (*end + size > vector->data_size)
+  {
+    uint64_t data_size= vector->data_size ? vector->data_size * 2
+                                          : DRIZZLE_COLUMNAR_DATA_SIZE;
+    if (data_size < *end + size)
+    {
+      data_size= *end + size;
+    }
+
+#if SIZE_MAX < UINT64_MAX
+    if (data_size >= SIZE_MAX)
+    {
+      drizzle_set_error(result->con, __func__, "Column is larger than memory.");
+      return DRIZZLE_RETURN_MEMORY;
+    }
+#endif
+
+    char *data= (char *)realloc(vector->data, (size_t)data_size);
+    if (data == NULL)
+    {
+      drizzle_set_error(result->con, __func__, "Failed to realloc data.");
+      return DRIZZLE_RETURN_MEMORY;
+    }
+    vector->data= data;
+    vector->data_size= data_size;
+  }
+
+  memcpy(vector->data + *end, field, size);
+  *end+= size;
+  return DRIZZLE_RETURN_OK;
+}
+
+/**
+ * Store NULL in the current row of the columns from the cursor up to, not
+ * including, the given column.
+ *
+ * @param[in,out] result Result being buffered.
+ * @param[in] column First column not to set.
+ */
+static void _columnar_set_null(drizzle_result_st *result, uint16_t column)
+{
+  drizzle_columnar_st *columnar= result->columnar;
+  uint64_t row= result->row_count - 1 - columnar->row_first;
+
+  for (; columnar->column < column; columnar->column++)
+  {
+    drizzle_column_vector_st *vector= &columnar->columns[columnar->column];
+    if (vector->width)
+    {
+      memset(vector->values + row * vector->width, 0, vector->width);
+    }
+    else
+    {
+      vector->offsets[row + 1]= vector->offsets[row];
+    }
+    vector->null_count++;
+  }
+}
+
+/**
+ * Store a field of a binary row in its column.
+ *
+ * @param[in,out] result Result being buffered.
+ * @param[in] field The field as sent by the server.
+ * @param[in] size Size of field.
+ * @return Standard drizzle return value.
+ */
+static drizzle_return_t _columnar_binary_field(drizzle_result_st *result,
+                                               drizzle_field_t field,
+                                               size_t size)
+{
+  drizzle_columnar_st *columnar= result->columnar;
+  uint64_t row= result->row_count - 1 - columnar->row_first;
+  uint16_t column= result->field_column - 1;
+
+  /* The columns skipped by the server are NULL. */
+  _columnar_set_null(result, column);
+
+  drizzle_column_vector_st *vector= &columnar->columns[column];
+  vector->validity[row / 8]|= (uint8_t)(1 << (row % 8));
+  columnar->column++;
+
+  if (vector->width == 0)
+  {
+    vector->offsets[row + 1]= vector->offsets[row];
+    return _columnar_append(result, vector, field, size);
+  }
+
+  uint8_t *value= vector->values + row * vector->width;
+  uint16_t value2;
+  uint32_t value4;
+  uint64_t value8;
+
+  switch (vector->width)
+  {
+    case 1:
+      *value= (uint8_t)field[0];
+      break;
+    case 2:
+      value2= drizzle_get_byte2(field);
+      memcpy(value, &value2, 2);
+      break;
+    case 4:
+      value4= drizzle_get_byte4(field);
+      memcpy(value, &value4, 4);
+      break;
+    default:
+      value8= drizzle_get_byte8(field);
+      memcpy(value, &value8, 8);
+      break;
+  }
+
+  return DRIZZLE_RETURN_OK;
+}
+
+/**
+ * Store a field or a fragment of a field of a text row in its column.
+ *
+ * @param[in,out] result Result being buffered.
+ * @param[in] field The field, NULL if it is NULL.
+ * @param[in] offset Offset of this fragment in the field.
+ * @param[in] size Size of this fragment.
+ * @param[in] total Size of the whole field.
+ * @return Standard drizzle return value.
+ */
+static drizzle_return_t _columnar_text_field(drizzle_result_st *result,
+                                             drizzle_field_t field,
+                                             uint64_t offset, size_t size,
+                                             uint64_t total)
+{
+  drizzle_columnar_st *columnar= result->columnar;
+  uint64_t row= result->row_count - 1 - columnar->row_first;
+
+  if (field == NULL)
+  {
+    _columnar_set_null(result, columnar->column + 1);
+    return DRIZZLE_RETURN_OK;
+  }
+
+  drizzle_column_vector_st *vector= &columnar->columns[columnar->column];
+  if (offset == 0)
+  {
+    vector->offsets[row + 1]= vector->offsets[row];
+    vector->validity[row / 8]|= (uint8_t)(1 << (row % 8));
+  }
+
+  if (offset + size == total)
+  {
+    columnar->column++;
+  }
+
+  return _columnar_append(result, vector, field, size);
+}
+
+/**
+ * Get the vector of a column if the result has been buffered by column.
+ *
+ * @param[in] result A result object
+ * @param[in] column The column number
+ * @return The column vector, or NULL.
+ */
+static drizzle_column_vector_st *_column_vector(const drizzle_result_st *result,
+                                                uint16_t column)
+{
+  if (result == NULL || result->columnar == NULL ||
+      !(result->options & DRIZZLE_RESULT_BUFFER_COLUMNAR) ||
+      column >= result->column_count)
+  {
+    return NULL;
+  }
+
+  return &result->columnar->columns[column];
+}
+
+/** @} */
+
+/*
+ * Internal definitions
+ */
+
+void drizzle_columnar_free(drizzle_result_st *result)
+{
+  drizzle_columnar_st *columnar= result->columnar;
+  if (columnar == NULL)
+  {
+    return;
+  }
+
+  if (columnar->columns)
+  {
+    for (uint16_t x= 0; x < result->column_count; x++)
+    {
+      free(columnar->columns[x].values);
+      free(columnar->columns[x].offsets);
+      free(columnar->columns[x].data);
+      free(columnar->columns[x].validity);
+    }
+    delete[] columnar->columns;
+  }
+
+  delete columnar;
+  result->columnar= NULL;
+}
+
+drizzle_return_t drizzle_columnar_create(drizzle_result_st *result)
+{
+  if (result->columnar != NULL)
+  {
+    return DRIZZLE_RETURN_OK;
+  }
+
+  result->columnar= new (std::nothrow) drizzle_columnar_st;
+  if (result->columnar == NULL)
+  {
+    drizzle_set_error(result->con, __func__, "Failed to allocate.");
+    return DRIZZLE_RETURN_MEMORY;
+  }
+  result->columnar->row_first= result->row_count;
+
+  result->columnar->columns=
+    new (std::nothrow) drizzle_column_vector_st[result->column_count]();
+  if (result->columnar->columns == NULL)
+  {
+    drizzle_set_error(result->con, __func__, "Failed to allocate.");
+    return DRIZZLE_RETURN_MEMORY;
+  }
+
+  for (uint16_t x= 0; x < result->column_count; x++)
+  {
+    result->columnar->columns[x].width= _column_width(result, x);
+  }
+
+  /* Results without rows still have their offsets and validity. */
+  return _columnar_grow(result);
+}
+
+drizzle_return_t drizzle_columnar_read(drizzle_result_st *result, uint64_t rows)
+{
+  drizzle_columnar_st *columnar= result->columnar;
+  drizzle_return_t ret;
+
+  while (1)
+  {
+    if (!columnar->in_row)
+    {
+      if (rows && result->row_count - columnar->row_first == rows)
+      {
+        break;
+      }
+
+      if (drizzle_row_read(result, &ret) == 0 || ret != DRIZZLE_RETURN_OK)
+      {
+        if (ret != DRIZZLE_RETURN_OK)
+        {
+          return ret;
+        }
+        break;
+      }
+
+      if (columnar->row_list_size < result->row_count - columnar->row_first)
+      {
+        ret= _columnar_grow(result);
+        if (ret != DRIZZLE_RETURN_OK)
+        {
+          return ret;
+        }
+      }
+
+      columnar->in_row= true;
+      columnar->column= 0;
+    }
+
+    uint64_t offset;
+    size_t size;
+    uint64_t total;
+    drizzle_field_t field= drizzle_field_read(result, &offset, &size, &total,
+                                              &ret);
+    if (ret == DRIZZLE_RETURN_ROW_END)
+    {
+      _columnar_set_null(result, result->column_count);
+      columnar->in_row= false;
+      continue;
+    }
+
+    if (ret != DRIZZLE_RETURN_OK)
+    {
+      return ret;
+    }
+
+    if (result->binary_rows)
+    {
+      ret= _columnar_binary_field(result, field, size);
+    }
+    else
+    {
+      ret= _columnar_text_field(result, field, offset, size, total);
+    }
+
+    if (ret != DRIZZLE_RETURN_OK)
+    {
+      return ret;
+    }
+  }
+
+  return DRIZZLE_RETURN_OK;
+}
+
+void drizzle_columnar_clear(drizzle_result_st *result)
+{
+  drizzle_columnar_st *columnar= result->columnar;
+
+  columnar->row_first= result->row_count;
+  for (uint16_t x= 0; x < result->column_count; x++)
+  {
+    drizzle_column_vector_st *vector= &columnar->columns[x];
+    memset(vector->validity, 0, columnar->row_list_size / 8);
+    vector->null_count= 0;
+  }
+}
+
+/*
+ * Client definitions
+ */
+
+drizzle_return_t drizzle_result_buffer_columnar(drizzle_result_st *result)
+{
+  if (result == NULL)
+  {
+    return DRIZZLE_RETURN_INVALID_ARGUMENT;
+  }
+
+  if (result->options & DRIZZLE_RESULT_BUFFER_COLUMNAR)
+  {
+    return DRIZZLE_RETURN_OK;
+  }
+
+  if (result->options & DRIZZLE_RESULT_BUFFER_ROW)
+  {
+    drizzle_set_error(result->con, __func__, "rows have already been buffered");
+    return DRIZZLE_RETURN_UNEXPECTED_DATA;
+  }
+
+  drizzle_return_t ret;
+  if (!(result->options & DRIZZLE_RESULT_BUFFER_COLUMN))
+  {
+    ret= drizzle_column_buffer(result);
+    if (ret != DRIZZLE_RETURN_OK)
+    {
+      return ret;
+    }
+  }
+
+  if (result->column_count == 0)
+  {
+    result->options = (drizzle_result_options_t)((int)result->options | (int)DRIZZLE_RESULT_BUFFER_COLUMNAR);
+    return DRIZZLE_RETURN_OK;
+  }
+
+  ret= drizzle_columnar_create(result);
+  if (ret != DRIZZLE_RETURN_OK)
+  {
+    return ret;
+  }
+
+  ret= drizzle_columnar_read(result, 0);
+  if (ret != DRIZZLE_RETURN_OK)
+  {
+    return ret;
+  }
+
+  result->options = (drizzle_result_options_t)((int)result->options | (int)DRIZZLE_RESULT_BUFFER_COLUMNAR);
+  return DRIZZLE_RETURN_OK;
+}
+
+drizzle_return_t drizzle_stmt_buffer_columnar(drizzle_stmt_st *stmt)
+{
+  if (stmt == NULL)
+  {
+    return DRIZZLE_RETURN_INVALID_ARGUMENT;
+  }
+  if (stmt->state >= DRIZZLE_STMT_FETCHED)
+  {
+    drizzle_set_error(stmt->con, __func__, "data set has already been read");
+    return DRIZZLE_RETURN_UNEXPECTED_DATA;
+  }
+  if (stmt->state < DRIZZLE_STMT_EXECUTED)
+  {
+    drizzle_set_error(stmt->con, __func__, "statement has not been executed");
+    return DRIZZLE_RETURN_UNEXPECTED_DATA;
+  }
+
+  stmt->con->result= stmt->execute_result;
+  stmt->state= DRIZZLE_STMT_FETCHED;
+
+  return drizzle_result_buffer_columnar(stmt->execute_result);
+}
+
+size_t drizzle_result_column_width(const drizzle_result_st *result,
+                                   uint16_t column)
+{
+  drizzle_column_vector_st *vector= _column_vector(result, column);
+  if (vector == NULL)
+  {
+    return 0;
+  }
+
+  return vector->width;
+}
+
+const void *drizzle_result_column_values(const drizzle_result_st *result,
+                                         uint16_t column)
+{
+  drizzle_column_vector_st *vector= _column_vector(result, column);
+  if (vector == NULL)
+  {
+    return NULL;
+  }
+
+  return vector->values;
+}
+
+const uint64_t *drizzle_result_column_offsets(const drizzle_result_st *result,
+                                              uint16_t column)
+{
+  drizzle_column_vector_st *vector= _column_vector(result, column);
+  if (vector == NULL)
+  {
+    return NULL;
+  }
+
+  return vector->offsets;
+}
+
+const char *drizzle_result_column_data(const drizzle_result_st *result,
+                                       uint16_t column)
+{
+  drizzle_column_vector_st *vector= _column_vector(result, column);
+  if (vector == NULL)
+  {
+    return NULL;
+  }
+
+  return vector->data;
+}
+
+const uint8_t *drizzle_result_column_validity(const drizzle_result_st *result,
+                                              uint16_t column)
+{
+  drizzle_column_vector_st *vector= _column_vector(result, column);
+  if (vector == NULL)
+  {
+    return NULL;
+  }
+
+  return vector->validity;
+}
+
+uint64_t drizzle_result_column_null_count(const drizzle_result_st *result,
+                                          uint16_t column)
+{
+  drizzle_column_vector_st *vector= _column_vector(result, column);
+  if (vector == NULL)
+  {
+    return 0;
+  }
+
+  return vector->null_count;
+}
@@ -0,0 +1,126 @@
+/* vim:expandtab:shiftwidth=2:tabstop=2:smarttab:
+ *
+ * Drizzle Client & Protocol Library
+ *
+ * Copyright (C) 2012-2013 Drizzle Developer Group
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following disclaimer
+ * in the documentation and/or other materials provided with the
+ * distribution.
+ *
+ *     * The names of its contributors may not be used to endorse or
+ * promote products derived from this software without specific prior
+ * written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#pragma once
+
+/**
+ * @file
+ * @brief Columnar Result Declarations
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @addtogroup drizzle_columnar_local Local Columnar Result Declarations
+ * @ingroup drizzle_columnar
+ * @{
+ */
+
+/**
+ * Values of one column of a result buffered with
+ * drizzle_result_buffer_columnar(). Fixed width columns fill values, the
+ * others append to data and record where each value ends in offsets.
+ */
+struct drizzle_column_vector_st
+{
+  size_t width;                   /* bytes per value, 0 for variable length */
+  uint8_t *values;                /* width bytes per row */
+  uint64_t *offsets;              /* row_count + 1 offsets into data */
+  char *data;
+  uint64_t data_size;             /* bytes data has room for */
+  uint8_t *validity;              /* bit set for each row that is not NULL */
+  uint64_t null_count;
+};
+
+struct drizzle_columnar_st
+{
+  drizzle_column_vector_st *columns;
+  uint64_t row_list_size;         /* rows the vectors have room for */
+  uint64_t row_first;             /* number of the row stored first */
+  uint16_t column;                /* column the next text field belongs to */
+  bool in_row;                    /* fields of a row are being read */
+
+  drizzle_columnar_st() :
+    columns(NULL),
+    row_list_size(0),
+    row_first(0),
+    column(0),
+    in_row(false)
+  { }
+};
+
+/**
+ * Allocate the column vectors of a result, if it has none yet. The columns
+ * must have been buffered.
+ *
+ * @param[in,out] result Result to buffer by column.
+ * @return Standard drizzle return value.
+ */
+drizzle_return_t drizzle_columnar_create(drizzle_result_st *result);
+
+/**
+ * Read rows into the column vectors of a result, until the end of the rows
+ * or until the vectors hold the given number of rows.
+ *
+ * @param[in,out] result Result with column vectors.
+ * @param[in] rows Rows to stop at, 0 to read all rows.
+ * @return Standard drizzle return value.
+ */
+drizzle_return_t drizzle_columnar_read(drizzle_result_st *result, uint64_t rows);
+
+/**
+ * Empty the column vectors of a result so the next rows read are stored
+ * first. The memory is kept for them.
+ *
+ * @param[in,out] result Result with column vectors.
+ */
+void drizzle_columnar_clear(drizzle_result_st *result);
+
+/**
+ * Free the column vectors of a result.
+ *
+ * @param[in,out] result Result buffered by column.
+ */
+void drizzle_columnar_free(drizzle_result_st *result);
+
+/** @} */
+
+#ifdef __cplusplus
+}
+#endif
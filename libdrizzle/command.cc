@@ -102,6 +102,10 @@ drizzle_return_t drizzle_state_command_write(drizzle_st *con)
 
     /* Store packet size at the end since it may change. */
     con->packet_number= 1;
+    if (con->compress != NULL)
+    {
+      drizzle_compress_reset(con);
+    }
     ptr= start;
     ptr[3]= 0;
     ptr[4]= (unsigned char)(con->command);
@@ -125,22 +129,24 @@ drizzle_return_t drizzle_state_command_write(drizzle_st *con)
       con->packet_size= (uint32_t)(1 + con->command_total);
       free_size-= 5;
 
-      /* Copy as much of the data in as we can into the write buffer. */
-      if (con->command_size <= free_size)
+      /* Small payloads are cheap to copy and go out with the header in a
+         single send. Anything larger is sent straight from the caller
+         buffer, gathered with the header by drizzle_state_write(). */
+      if (con->command_size < DRIZZLE_BUFFER_COPY_THRESHOLD &&
+          con->command_size <= free_size)
       {
         memcpy(ptr, con->command_data, con->command_size);
-        con->command_offset= con->command_size;
-        con->command_data= NULL;
         con->buffer_size+= 5 + con->command_size;
       }
       else
       {
-        memcpy(ptr, con->command_data, free_size);
-        con->command_offset= free_size;
-        con->command_data+= free_size;
-        con->command_size-= free_size;
-        con->buffer_size+= 5 + free_size;
+        con->write_data= con->command_data;
+        con->write_data_size= con->command_size;
+        con->buffer_size+= 5;
       }
+
+      con->command_offset= con->command_size;
+      con->command_data= NULL;
     }
 
     /* Store packet size now. */
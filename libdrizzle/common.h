@@ -81,7 +81,12 @@ typedef struct pollfd pollfd_t;
 #include <stdlib.h>
 #include <string.h>
 
+#include "libdrizzle/arena.h"
 #include "libdrizzle/structs.h"
+#include "libdrizzle/buffer.h"
+#include "libdrizzle/columnar.h"
+#include "libdrizzle/compress.h"
+#include "libdrizzle/uring.h"
 #include "libdrizzle/drizzle_local.h"
 #include "libdrizzle/conn_local.h"
 #include "libdrizzle/pack.h"
@@ -89,8 +94,11 @@ typedef struct pollfd pollfd_t;
 #include "libdrizzle/sha1.h"
 #include "libdrizzle/statement_local.h"
 #include "libdrizzle/column.h"
+#include "libdrizzle/field.h"
 #include "libdrizzle/binlog.h"
 #include "libdrizzle/handshake_client.h"
 #include "libdrizzle/result.h"
+#include "libdrizzle/reactor_local.h"
+#include "libdrizzle/pipeline_local.h"
 
 #include <memory.h>
@@ -0,0 +1,688 @@
+/* vim:expandtab:shiftwidth=2:tabstop=2:smarttab:
+ *
+ * Drizzle Client & Protocol Library
+ *
+ * Copyright (C) 2012-2013 Drizzle Developer Group
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following disclaimer
+ * in the documentation and/or other materials provided with the
+ * distribution.
+ *
+ *     * The names of its contributors may not be used to endorse or
+ * promote products derived from this software without specific prior
+ * written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/**
+ * @file
+ * @brief Compressed Protocol Definitions
+ */
+
+#include "config.h"
+#include "libdrizzle/common.h"
+
+#include <zlib.h>
+
+#if defined(HAVE_ZSTD) && HAVE_ZSTD
+# include <zstd.h>
+# define DRIZZLE_COMPRESS_ZSTD 1
+#endif
+
+/* Payload length, sequence number and length before compression. */
+#define DRIZZLE_COMPRESS_HEADER_SIZE 7
+#define DRIZZLE_COMPRESS_MAX_PAYLOAD 0xFFFFFF
+/* Buffer size kept between packets; larger packets grow it. */
+#define DRIZZLE_COMPRESS_READ_SIZE (64*1024)
+#define DRIZZLE_COMPRESS_ZSTD_DEFAULT_LEVEL 3
+#define DRIZZLE_COMPRESS_ZSTD_MAX_LEVEL 22
+
+/**
+ * @addtogroup drizzle_compress_static Static Compressed Protocol Declarations
+ * @ingroup drizzle_compress
+ * @{
+ */
+
+/**
+ * Part of a payload to compress, which may span the connection buffer and
+ * the caller data sent after it.
+ */
+struct _piece
+{
+  const unsigned char *data;
+  size_t size;
+};
+
+/**
+ * Get the largest size a payload can take once compressed.
+ *
+ * @param[in] con Connection structure in compressed mode.
+ * @param[in] size Payload size.
+ * @return Size in bytes.
+ */
+static size_t _bound(const drizzle_st *con, size_t size)
+{
+#ifdef DRIZZLE_COMPRESS_ZSTD
+  if (con->compression == DRIZZLE_COMPRESSION_ZSTD)
+  {
+    return ZSTD_compressBound(size);
+  }
+#else
+  (void)con;
+#endif
+
+  return compressBound((uLong)size);
+}
+
+/**
+ * Create the compression stream of a connection.
+ *
+ * @param[in] con Connection structure in compressed mode.
+ * @return Standard drizzle return value.
+ */
+static drizzle_return_t _deflate_create(drizzle_st *con)
+{
+  drizzle_compress_st *compress= con->compress;
+
+#ifdef DRIZZLE_COMPRESS_ZSTD
+  if (con->compression == DRIZZLE_COMPRESSION_ZSTD)
+  {
+    ZSTD_CCtx *cctx= ZSTD_createCCtx();
+    if (cctx == NULL)
+    {
+      drizzle_set_error(con, __func__, "ZSTD_createCCtx failure");
+      return DRIZZLE_RETURN_MEMORY;
+    }
+    ZSTD_CCtx_setParameter(cctx, ZSTD_c_compressionLevel,
+                           drizzle_compress_zstd_level(con));
+    compress->deflate_stream= cctx;
+
+    return DRIZZLE_RETURN_OK;
+  }
+#endif
+
+  z_stream *stream= new (std::nothrow) z_stream;
+  if (stream == NULL)
+  {
+    drizzle_set_error(con, __func__, "new");
+    return DRIZZLE_RETURN_MEMORY;
+  }
+
+  memset(stream, 0, sizeof(*stream));
+  int level= con->options.compression_level;
+  if (level <= 0 || level > Z_BEST_COMPRESSION)
+  {
+    level= Z_DEFAULT_COMPRESSION;
+  }
+  if (deflateInit(stream, level) != Z_OK)
+  {
+    delete stream;
+    drizzle_set_error(con, __func__, "deflateInit failure");
+    return DRIZZLE_RETURN_MEMORY;
+  }
+  compress->deflate_stream= stream;
+
+  return DRIZZLE_RETURN_OK;
+}
+
+/**
+ * Create the decompression stream of a connection.
+ *
+ * @param[in] con Connection structure in compressed mode.
+ * @return Standard drizzle return value.
+ */
+static drizzle_return_t _inflate_create(drizzle_st *con)
+{
+  drizzle_compress_st *compress= con->compress;
+
+#ifdef DRIZZLE_COMPRESS_ZSTD
+  if (con->compression == DRIZZLE_COMPRESSION_ZSTD)
+  {
+    ZSTD_DCtx *dctx= ZSTD_createDCtx();
+    if (dctx == NULL)
+    {
+      drizzle_set_error(con, __func__, "ZSTD_createDCtx failure");
+      return DRIZZLE_RETURN_MEMORY;
+    }
+    compress->inflate_stream= dctx;
+
+    return DRIZZLE_RETURN_OK;
+  }
+#endif
+
+  z_stream *stream= new (std::nothrow) z_stream;
+  if (stream == NULL)
+  {
+    drizzle_set_error(con, __func__, "new");
+    return DRIZZLE_RETURN_MEMORY;
+  }
+
+  memset(stream, 0, sizeof(*stream));
+  if (inflateInit(stream) != Z_OK)
+  {
+    delete stream;
+    drizzle_set_error(con, __func__, "inflateInit failure");
+    return DRIZZLE_RETURN_MEMORY;
+  }
+  compress->inflate_stream= stream;
+
+  return DRIZZLE_RETURN_OK;
+}
+
+/**
+ * Compress a payload.
+ *
+ * @param[in] con Connection structure in compressed mode.
+ * @param[in] pieces The parts of the payload.
+ * @param[in] count Number of parts.
+ * @param[in] size Payload size.
+ * @param[out] dest Where to store the compressed payload.
+ * @param[in] capacity Room at dest, from _bound().
+ * @return Compressed size, 0 if compression failed.
+ */
+static size_t _compress(drizzle_st *con, const struct _piece *pieces,
+                        size_t count, size_t size, unsigned char *dest,
+                        size_t capacity)
+{
+#ifdef DRIZZLE_COMPRESS_ZSTD
+  if (con->compression == DRIZZLE_COMPRESSION_ZSTD)
+  {
+    ZSTD_CCtx *cctx= (ZSTD_CCtx *)con->compress->deflate_stream;
+    ZSTD_outBuffer output= { dest, capacity, 0 };
+
+    ZSTD_CCtx_reset(cctx, ZSTD_reset_session_only);
+    ZSTD_CCtx_setPledgedSrcSize(cctx, size);
+    for (size_t x= 0; x < count; x++)
+    {
+      ZSTD_inBuffer input= { pieces[x].data, pieces[x].size, 0 };
+      ZSTD_EndDirective mode= (x == count - 1) ? ZSTD_e_end : ZSTD_e_continue;
+      size_t remaining;
+
+      do
+      {
+        remaining= ZSTD_compressStream2(cctx, &output, &input, mode);
+        if (ZSTD_isError(remaining) ||
+            (remaining != 0 && output.pos == output.size))
+        {
+          return 0;
+        }
+      } while (mode == ZSTD_e_end ? remaining != 0 : input.pos < input.size);
+    }
+
+    return output.pos;
+  }
+#endif
+  (void)size;
+
+  z_stream *stream= (z_stream *)con->compress->deflate_stream;
+
+  deflateReset(stream);
+  stream->next_out= dest;
+  stream->avail_out= (uInt)capacity;
+  for (size_t x= 0; x < count; x++)
+  {
+    stream->next_in= (Bytef *)pieces[x].data;
+    stream->avail_in= (uInt)pieces[x].size;
+
+    if (x == count - 1)
+    {
+      if (deflate(stream, Z_FINISH) != Z_STREAM_END)
+      {
+        return 0;
+      }
+    }
+    else if (deflate(stream, Z_NO_FLUSH) != Z_OK || stream->avail_in != 0)
+    {
+      return 0;
+    }
+  }
+
+  return (size_t)stream->total_out;
+}
+
+/**
+ * Decompress a payload.
+ *
+ * @param[in] con Connection structure in compressed mode.
+ * @param[in] data Compressed payload.
+ * @param[in] size Size of the compressed payload.
+ * @param[out] dest Where to store the payload.
+ * @param[in] dest_size Payload size announced in the packet header.
+ * @return true if exactly dest_size bytes were recovered.
+ */
+static bool _decompress(drizzle_st *con, const unsigned char *data,
+                        size_t size, unsigned char *dest, size_t dest_size)
+{
+#ifdef DRIZZLE_COMPRESS_ZSTD
+  if (con->compression == DRIZZLE_COMPRESSION_ZSTD)
+  {
+    size_t ret= ZSTD_decompressDCtx((ZSTD_DCtx *)con->compress->inflate_stream,
+                                    dest, dest_size, data, size);
+
+    return ZSTD_isError(ret) == 0 && ret == dest_size;
+  }
+#endif
+
+  z_stream *stream= (z_stream *)con->compress->inflate_stream;
+
+  inflateReset(stream);
+  stream->next_in= (Bytef *)data;
+  stream->avail_in= (uInt)size;
+  stream->next_out= dest;
+  stream->avail_out= (uInt)dest_size;
+
+  return inflate(stream, Z_FINISH) == Z_STREAM_END &&
+         stream->total_out == dest_size;
+}
+
+/**
+ * Make room for size bytes after the unread data in the connection buffer.
+ *
+ * @param[in] con Connection structure in compressed mode.
+ * @param[in] size Number of bytes to append.
+ * @return Standard drizzle return value.
+ */
+static drizzle_return_t _reserve(drizzle_st *con, size_t size)
+{
+  if (drizzle_buffer_available(con) >= size)
+  {
+    return DRIZZLE_RETURN_OK;
+  }
+
+  if (con->buffer_size + size > con->buffer_allocation)
+  {
+    return drizzle_buffer_reserve(con, con->buffer_size + size);
+  }
+
+  /* A plain buffer with the unread data too far from the front. */
+  return drizzle_buffer_resize(con, con->buffer_allocation);
+}
+
+/** @} */
+
+/*
+ * Local Definitions
+ */
+
+drizzle_compression_t drizzle_compress_negotiate(const drizzle_st *con)
+{
+#ifdef DRIZZLE_COMPRESS_ZSTD
+  if (con->options.compression == DRIZZLE_COMPRESSION_ZSTD &&
+      (con->capabilities & DRIZZLE_CAPABILITIES_ZSTD_COMPRESSION_ALGORITHM))
+  {
+    return DRIZZLE_COMPRESSION_ZSTD;
+  }
+#endif
+
+  /* zlib is what every server with compression support speaks, so it is
+     also used when zstd is not available on either side. */
+  if (con->options.compression != DRIZZLE_COMPRESSION_NONE &&
+      (con->capabilities & DRIZZLE_CAPABILITIES_COMPRESS))
+  {
+    return DRIZZLE_COMPRESSION_ZLIB;
+  }
+
+  return DRIZZLE_COMPRESSION_NONE;
+}
+
+uint8_t drizzle_compress_zstd_level(const drizzle_st *con)
+{
+  int level= con->options.compression_level;
+
+  if (level <= 0)
+  {
+    return DRIZZLE_COMPRESS_ZSTD_DEFAULT_LEVEL;
+  }
+  if (level > DRIZZLE_COMPRESS_ZSTD_MAX_LEVEL)
+  {
+    return DRIZZLE_COMPRESS_ZSTD_MAX_LEVEL;
+  }
+
+  return (uint8_t)level;
+}
+
+drizzle_return_t drizzle_compress_start(drizzle_st *con)
+{
+  if (con->compress != NULL)
+  {
+    return DRIZZLE_RETURN_OK;
+  }
+
+  con->compress= new (std::nothrow) drizzle_compress_st;
+  if (con->compress == NULL)
+  {
+    drizzle_set_error(con, __func__, "new");
+    return DRIZZLE_RETURN_MEMORY;
+  }
+
+  drizzle_log_debug(con, "compressed protocol: %s",
+                    con->compression == DRIZZLE_COMPRESSION_ZSTD ? "zstd" : "zlib");
+
+  return DRIZZLE_RETURN_OK;
+}
+
+void drizzle_compress_free(drizzle_st *con)
+{
+  drizzle_compress_st *compress= con->compress;
+
+  if (compress == NULL)
+  {
+    return;
+  }
+
+#ifdef DRIZZLE_COMPRESS_ZSTD
+  if (con->compression == DRIZZLE_COMPRESSION_ZSTD)
+  {
+    ZSTD_freeCCtx((ZSTD_CCtx *)compress->deflate_stream);
+    ZSTD_freeDCtx((ZSTD_DCtx *)compress->inflate_stream);
+  }
+  else
+#endif
+  {
+    if (compress->deflate_stream != NULL)
+    {
+      deflateEnd((z_stream *)compress->deflate_stream);
+      delete (z_stream *)compress->deflate_stream;
+    }
+    if (compress->inflate_stream != NULL)
+    {
+      inflateEnd((z_stream *)compress->inflate_stream);
+      delete (z_stream *)compress->inflate_stream;
+    }
+  }
+
+  free(compress->in);
+  free(compress->out);
+  delete compress;
+  con->compress= NULL;
+}
+
+void drizzle_compress_reset(drizzle_st *con)
+{
+  con->compress->packet_number= 0;
+}
+
+bool drizzle_compress_packet_ready(const drizzle_st *con)
+{
+  const drizzle_compress_st *compress= con->compress;
+  size_t pending= compress->in_size - compress->in_offset;
+
+  if (pending < DRIZZLE_COMPRESS_HEADER_SIZE)
+  {
+    return false;
+  }
+
+  return pending >= DRIZZLE_COMPRESS_HEADER_SIZE +
+                    (size_t)drizzle_get_byte3(compress->in + compress->in_offset);
+}
+
+unsigned char *drizzle_compress_read_space(drizzle_st *con, size_t *size)
+{
+  drizzle_compress_st *compress= con->compress;
+  size_t needed= DRIZZLE_COMPRESS_READ_SIZE;
+
+  if (compress->in_offset == compress->in_size)
+  {
+    compress->in_offset= 0;
+    compress->in_size= 0;
+
+    /* Give back the room taken by a large packet. */
+    if (compress->in_allocation > DRIZZLE_COMPRESS_READ_SIZE)
+    {
+      free(compress->in);
+      compress->in= NULL;
+      compress->in_allocation= 0;
+    }
+  }
+
+  size_t pending= compress->in_size - compress->in_offset;
+  if (pending >= DRIZZLE_COMPRESS_HEADER_SIZE)
+  {
+    size_t packet= DRIZZLE_COMPRESS_HEADER_SIZE +
+                   (size_t)drizzle_get_byte3(compress->in + compress->in_offset);
+    if (packet > needed)
+    {
+      needed= packet;
+    }
+  }
+
+  if (compress->in_offset != 0 &&
+      compress->in_offset + needed > compress->in_allocation)
+  {
+    memmove(compress->in, compress->in + compress->in_offset, pending);
+    compress->in_offset= 0;
+    compress->in_size= pending;
+  }
+
+  if (needed > compress->in_allocation)
+  {
+    unsigned char *in= (unsigned char *)realloc(compress->in, needed);
+    if (in == NULL)
+    {
+      drizzle_set_error(con, __func__, "realloc failure");
+      return NULL;
+    }
+    compress->in= in;
+    compress->in_allocation= needed;
+  }
+
+  *size= compress->in_allocation - compress->in_size;
+
+  return compress->in + compress->in_size;
+}
+
+void drizzle_compress_read_done(drizzle_st *con, size_t size)
+{
+  con->compress->in_size+= size;
+}
+
+drizzle_return_t drizzle_compress_inflate(drizzle_st *con)
+{
+  drizzle_compress_st *compress= con->compress;
+  unsigned char *packet= compress->in + compress->in_offset;
+  size_t payload_size= drizzle_get_byte3(packet);
+  size_t size= drizzle_get_byte3(packet + 4);
+  drizzle_return_t ret;
+
+  if (packet[3] != compress->packet_number)
+  {
+    drizzle_set_error(con, __func__, "bad compressed packet number:%u:%u",
+                      compress->packet_number, packet[3]);
+    return DRIZZLE_RETURN_BAD_PACKET_NUMBER;
+  }
+  compress->packet_number++;
+
+  ret= _reserve(con, size == 0 ? payload_size : size);
+  if (ret != DRIZZLE_RETURN_OK)
+  {
+    return ret;
+  }
+
+  unsigned char *dest= con->buffer_ptr + con->buffer_size;
+  if (size == 0)
+  {
+    memcpy(dest, packet + DRIZZLE_COMPRESS_HEADER_SIZE, payload_size);
+    size= payload_size;
+  }
+  else
+  {
+    if (compress->inflate_stream == NULL)
+    {
+      ret= _inflate_create(con);
+      if (ret != DRIZZLE_RETURN_OK)
+      {
+        return ret;
+      }
+    }
+
+    if (_decompress(con, packet + DRIZZLE_COMPRESS_HEADER_SIZE, payload_size,
+                    dest, size) == false)
+    {
+      drizzle_set_error(con, __func__, "corrupt compressed packet:%" PRIu64,
+                        (uint64_t)payload_size);
+      return DRIZZLE_RETURN_BAD_PACKET;
+    }
+  }
+
+  drizzle_log_debug(con, "inflated %" PRIu64 " into %" PRIu64 " bytes",
+                    (uint64_t)payload_size, (uint64_t)size);
+
+  con->buffer_size+= size;
+  compress->in_offset+= DRIZZLE_COMPRESS_HEADER_SIZE + payload_size;
+
+  return DRIZZLE_RETURN_OK;
+}
+
+bool drizzle_compress_write_pending(const drizzle_st *con)
+{
+  const drizzle_compress_st *compress= con->compress;
+
+  if (con->buffer_size != 0)
+  {
+    return true;
+  }
+
+  return con->write_data_size != 0 &&
+         (con->write_data < compress->out ||
+          con->write_data >= compress->out + compress->out_allocation);
+}
+
+drizzle_return_t drizzle_compress_deflate(drizzle_st *con)
+{
+  drizzle_compress_st *compress= con->compress;
+  struct _piece segments[2];
+  size_t total= con->buffer_size + con->write_data_size;
+  size_t needed= 0;
+  drizzle_return_t ret;
+
+  segments[0].data= con->buffer_ptr;
+  segments[0].size= con->buffer_size;
+  segments[1].data= con->write_data;
+  segments[1].size= con->write_data_size;
+
+  for (size_t left= total; left != 0;)
+  {
+    size_t chunk= left > DRIZZLE_COMPRESS_MAX_PAYLOAD ? DRIZZLE_COMPRESS_MAX_PAYLOAD : left;
+    needed+= DRIZZLE_COMPRESS_HEADER_SIZE + _bound(con, chunk);
+    left-= chunk;
+  }
+
+  /* Grow for a large write, and give the memory back on the next small one. */
+  if (needed > compress->out_allocation ||
+      (compress->out_allocation > DRIZZLE_COMPRESS_READ_SIZE &&
+       needed <= DRIZZLE_COMPRESS_READ_SIZE))
+  {
+    free(compress->out);
+    compress->out= (unsigned char *)malloc(needed);
+    if (compress->out == NULL)
+    {
+      compress->out_allocation= 0;
+      drizzle_set_error(con, __func__, "malloc failure");
+      return DRIZZLE_RETURN_MEMORY;
+    }
+    compress->out_allocation= needed;
+  }
+
+  unsigned char *ptr= compress->out;
+  size_t segment= 0;
+  size_t offset= 0;
+
+  while (total != 0)
+  {
+    size_t chunk= total > DRIZZLE_COMPRESS_MAX_PAYLOAD ? DRIZZLE_COMPRESS_MAX_PAYLOAD : total;
+    struct _piece pieces[2];
+    size_t count= 0;
+
+    /* A payload spans at most the end of one segment and the start of
+       the next. */
+    for (size_t left= chunk; left != 0;)
+    {
+      while (offset == segments[segment].size)
+      {
+        segment++;
+        offset= 0;
+      }
+
+      size_t size= segments[segment].size - offset;
+      if (size > left)
+      {
+        size= left;
+      }
+      pieces[count].data= segments[segment].data + offset;
+      pieces[count].size= size;
+      count++;
+      offset+= size;
+      left-= size;
+    }
+
+    unsigned char *payload= ptr + DRIZZLE_COMPRESS_HEADER_SIZE;
+    size_t compressed= 0;
+
+    if (chunk >= con->options.compression_threshold)
+    {
+      if (compress->deflate_stream == NULL)
+      {
+        ret= _deflate_create(con);
+        if (ret != DRIZZLE_RETURN_OK)
+        {
+          return ret;
+        }
+      }
+      compressed= _compress(con, pieces, count, chunk, payload, _bound(con, chunk));
+    }
+
+    if (compressed == 0 || compressed >= chunk)
+    {
+      /* Too small to be worth it, or incompressible: send as is. */
+      unsigned char *copy= payload;
+      for (size_t x= 0; x < count; x++)
+      {
+        memcpy(copy, pieces[x].data, pieces[x].size);
+        copy+= pieces[x].size;
+      }
+      drizzle_set_byte3(ptr, chunk);
+      drizzle_set_byte3(ptr + 4, 0);
+      compressed= chunk;
+    }
+    else
+    {
+      drizzle_set_byte3(ptr, compressed);
+      drizzle_set_byte3(ptr + 4, chunk);
+    }
+    ptr[3]= compress->packet_number++;
+
+    drizzle_log_debug(con, "deflated %" PRIu64 " into %" PRIu64 " bytes",
+                      (uint64_t)chunk, (uint64_t)compressed);
+
+    ptr+= DRIZZLE_COMPRESS_HEADER_SIZE + compressed;
+    total-= chunk;
+  }
+
+  con->buffer_ptr= con->buffer;
+  con->buffer_size= 0;
+  con->write_data= compress->out;
+  con->write_data_size= (size_t)(ptr - compress->out);
+
+  return DRIZZLE_RETURN_OK;
+}
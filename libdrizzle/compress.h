@@ -0,0 +1,168 @@
+/* vim:expandtab:shiftwidth=2:tabstop=2:smarttab:
+ *
+ * Drizzle Client & Protocol Library
+ *
+ * Copyright (C) 2012-2013 Drizzle Developer Group
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following disclaimer
+ * in the documentation and/or other materials provided with the
+ * distribution.
+ *
+ *     * The names of its contributors may not be used to endorse or
+ * promote products derived from this software without specific prior
+ * written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#pragma once
+
+/**
+ * @file
+ * @brief Compressed Protocol Declarations
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @addtogroup drizzle_compress Compressed Protocol Declarations
+ * @ingroup drizzle_con
+ *
+ * Once the handshake has completed with DRIZZLE_CAPABILITIES_COMPRESS or
+ * DRIZZLE_CAPABILITIES_ZSTD_COMPRESSION_ALGORITHM, everything on the wire is
+ * carried in compressed packets: a 3 byte payload length, a sequence number
+ * and the 3 byte length of the payload before compression, zero when it was
+ * sent as is. The payload is a slice of the regular packet stream.
+ *
+ * drizzle_state_read() receives compressed packets into a separate buffer
+ * and inflates them into the connection buffer, so packet parsing does not
+ * change. drizzle_state_write() wraps whatever is pending into compressed
+ * packets and sends those instead.
+ * @{
+ */
+
+/**
+ * Pick the compression algorithm to ask for, given the connection options
+ * and what the server announced.
+ *
+ * @param[in] con Connection structure that has read the server handshake.
+ * @return The algorithm to use, DRIZZLE_COMPRESSION_NONE if none.
+ */
+drizzle_compression_t drizzle_compress_negotiate(const drizzle_st *con);
+
+/**
+ * Get the zstd compression level sent in the client handshake.
+ *
+ * @param[in] con Connection structure previously initialized with
+ *  drizzle_create(), drizzle_clone(), or related functions.
+ * @return Level between 1 and 22.
+ */
+uint8_t drizzle_compress_zstd_level(const drizzle_st *con);
+
+/**
+ * Switch the connection to compressed packets using the algorithm
+ * negotiated during the handshake.
+ *
+ * @param[in] con Connection structure that completed the handshake.
+ * @return Standard drizzle return value.
+ */
+drizzle_return_t drizzle_compress_start(drizzle_st *con);
+
+/**
+ * Leave compressed mode and release its buffers.
+ *
+ * @param[in] con Connection structure previously initialized with
+ *  drizzle_create(), drizzle_clone(), or related functions.
+ */
+void drizzle_compress_free(drizzle_st *con);
+
+/**
+ * Start numbering compressed packets from zero again, as done for every
+ * new command.
+ *
+ * @param[in] con Connection structure in compressed mode.
+ */
+void drizzle_compress_reset(drizzle_st *con);
+
+/**
+ * Check whether a complete compressed packet has been received.
+ *
+ * @param[in] con Connection structure in compressed mode.
+ * @return true if drizzle_compress_inflate() can proceed.
+ */
+bool drizzle_compress_packet_ready(const drizzle_st *con);
+
+/**
+ * Get room for reading from the socket, making sure the next compressed
+ * packet fits.
+ *
+ * @param[in] con Connection structure in compressed mode.
+ * @param[out] size Number of bytes that can be stored.
+ * @return Where to store the data, NULL if the allocation failed.
+ */
+unsigned char *drizzle_compress_read_space(drizzle_st *con, size_t *size);
+
+/**
+ * Account for data stored at the location given by
+ * drizzle_compress_read_space().
+ *
+ * @param[in] con Connection structure in compressed mode.
+ * @param[in] size Number of bytes received.
+ */
+void drizzle_compress_read_done(drizzle_st *con, size_t size);
+
+/**
+ * Unpack the next complete compressed packet into the connection buffer.
+ *
+ * @param[in] con Connection structure in compressed mode.
+ * @return Standard drizzle return value.
+ */
+drizzle_return_t drizzle_compress_inflate(drizzle_st *con);
+
+/**
+ * Check whether there is data to send that has not been wrapped into
+ * compressed packets yet.
+ *
+ * @param[in] con Connection structure in compressed mode.
+ * @return true if drizzle_compress_deflate() needs to be called.
+ */
+bool drizzle_compress_write_pending(const drizzle_st *con);
+
+/**
+ * Wrap the pending data, from buffer_ptr and write_data, into compressed
+ * packets. On return write_data points to the packets to send. Payloads
+ * shorter than the compression threshold, or that do not shrink, are sent
+ * as is.
+ *
+ * @param[in] con Connection structure in compressed mode.
+ * @return Standard drizzle return value.
+ */
+drizzle_return_t drizzle_compress_deflate(drizzle_st *con);
+
+/** @} */
+
+#ifdef __cplusplus
+}
+#endif
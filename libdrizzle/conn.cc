@@ -68,6 +68,17 @@
  */
 static drizzle_return_t _setsockopt(drizzle_st *con);
 
+/**
+ * Send pending output for a connection: the remaining bytes at buffer_ptr,
+ * followed by the caller owned write_data segment. On plain sockets both
+ * are gathered into a single sendmsg() call.
+ *
+ * @param[in] con Connection structure previously initialized with
+ *  drizzle_create(), drizzle_clone(), or related functions.
+ * @return Number of bytes sent, or -1 with errno set.
+ */
+static ssize_t _write_pending(drizzle_st *con);
+
 static void connect_failed_try_next(drizzle_st *con, const char *func, const char *msg);
 
 static void __closesocket(socket_t& fd)
@@ -108,16 +119,35 @@ void drizzle_close(drizzle_st *con)
     return;
   }
 
+  if (con->reactor != NULL)
+  {
+    drizzle_reactor_reset(con);
+  }
+
   __closesocket(con->fd);
 
   con->state.ready= false;
   con->packet_number= 0;
   con->buffer_ptr= con->buffer;
   con->buffer_size= 0;
+  con->write_data= NULL;
+  con->write_data_size= 0;
   con->events= 0;
   con->revents= 0;
 
   con->clear_state();
+
+  drizzle_compress_free(con);
+  con->compression= DRIZZLE_COMPRESSION_NONE;
+
+  drizzle_pipeline_reset(con);
+
+  if (con->options.low_footprint)
+  {
+    drizzle_uring_free(con);
+    drizzle_buffer_free(con);
+    drizzle_pipeline_free(con);
+  }
 }
 
 drizzle_return_t drizzle_set_events(drizzle_st *con, short events)
@@ -131,6 +161,16 @@ drizzle_return_t drizzle_set_events(drizzle_st *con, short events)
 
   con->events|= events;
 
+  if (con->reactor != NULL)
+  {
+    ret= drizzle_reactor_update(con);
+    if (ret != DRIZZLE_RETURN_OK)
+    {
+      drizzle_close(con);
+      return ret;
+    }
+  }
+
   if (con->event_watch_fn != NULL)
   {
     ret= con->event_watch_fn(con, con->events, con->event_watch_context);
@@ -187,6 +227,11 @@ const char *drizzle_error(const drizzle_st *con)
     return NULL;
   }
 
+  if (con->last_error == NULL)
+  {
+    return "";
+  }
+
   return (const char *)con->last_error;
 }
 
@@ -418,6 +463,134 @@ drizzle_socket_owner drizzle_options_get_socket_owner(drizzle_options_st *option
   return options->socket_owner;
 }
 
+void drizzle_options_set_low_footprint(drizzle_options_st *options, bool state)
+{
+  if (options == NULL)
+  {
+    return;
+  }
+  options->low_footprint= state;
+}
+
+bool drizzle_options_get_low_footprint(drizzle_options_st *options)
+{
+  if (options == NULL)
+  {
+    return false;
+  }
+  return options->low_footprint;
+}
+
+void drizzle_options_set_io_uring(drizzle_options_st *options, bool state)
+{
+  if (options == NULL)
+  {
+    return;
+  }
+  options->io_uring= state;
+}
+
+bool drizzle_options_get_io_uring(drizzle_options_st *options)
+{
+  if (options == NULL)
+  {
+    return false;
+  }
+  return options->io_uring;
+}
+
+void drizzle_options_set_compression(drizzle_options_st *options,
+                                     drizzle_compression_t compression)
+{
+  if (options == NULL)
+  {
+    return;
+  }
+  options->compression= compression;
+}
+
+drizzle_compression_t drizzle_options_get_compression(drizzle_options_st *options)
+{
+  if (options == NULL)
+  {
+    return DRIZZLE_COMPRESSION_NONE;
+  }
+  return options->compression;
+}
+
+void drizzle_options_set_compression_level(drizzle_options_st *options, int level)
+{
+  if (options == NULL)
+  {
+    return;
+  }
+  options->compression_level= level;
+}
+
+int drizzle_options_get_compression_level(drizzle_options_st *options)
+{
+  if (options == NULL)
+  {
+    return 0;
+  }
+  return options->compression_level;
+}
+
+void drizzle_options_set_compression_threshold(drizzle_options_st *options,
+                                               size_t threshold)
+{
+  if (options == NULL)
+  {
+    return;
+  }
+  options->compression_threshold= threshold;
+}
+
+size_t drizzle_options_get_compression_threshold(drizzle_options_st *options)
+{
+  if (options == NULL)
+  {
+    return DRIZZLE_DEFAULT_COMPRESSION_THRESHOLD;
+  }
+  return options->compression_threshold;
+}
+
+size_t drizzle_memory_usage(const drizzle_st *con)
+{
+  if (con == NULL)
+  {
+    return 0;
+  }
+
+  size_t size= sizeof(drizzle_st);
+
+  /* A mirrored buffer maps the same pages twice, count them once. */
+  if (con->buffer != NULL)
+  {
+    size+= con->buffer_allocation;
+  }
+
+  if (con->last_error != NULL)
+  {
+    size+= DRIZZLE_MAX_ERROR_SIZE;
+  }
+
+  if (con->compress != NULL)
+  {
+    size+= sizeof(drizzle_compress_st) + con->compress->in_allocation +
+           con->compress->out_allocation;
+  }
+
+  size+= con->pipeline_allocation;
+
+  if (con->uring != NULL)
+  {
+    size+= drizzle_uring_memory(con->uring);
+  }
+
+  return size;
+}
+
 const char *drizzle_host(const drizzle_st *con)
 {
   if (con == NULL)
@@ -690,6 +863,25 @@ drizzle_return_t drizzle_connect(drizzle_st *con)
     return DRIZZLE_RETURN_OK;
   }
 
+  if (con->buffer == NULL)
+  {
+    drizzle_return_t ret= drizzle_buffer_resize(con, drizzle_buffer_resting_size(con));
+    if (ret != DRIZZLE_RETURN_OK)
+    {
+      return ret;
+    }
+  }
+
+  if (con->options.io_uring && con->options.non_blocking == false &&
+      con->uring == NULL)
+  {
+    /* Not fatal, the plain socket calls are used instead. */
+    if (drizzle_uring_create(con) == false)
+    {
+      drizzle_log_debug(con, "io_uring unavailable: %s", strerror(errno));
+    }
+  }
+
   if (con->has_state())
   {
     if (con->state.raw_packet == false)
@@ -833,6 +1025,13 @@ drizzle_result_st *drizzle_command_write(drizzle_st *con,
 
   if (con->has_state())
   {
+    if (drizzle_pipeline_count(con) != 0)
+    {
+      drizzle_set_error(con, __func__, "pipelined results have not been read");
+      *ret_ptr= DRIZZLE_RETURN_NOT_READY;
+      return result;
+    }
+
     if (con->state.raw_packet || con->state.no_result_read)
     {
       con->result= NULL;
@@ -1007,6 +1206,11 @@ drizzle_return_t drizzle_state_connect(drizzle_st *con)
 
   drizzle_log_debug(con, __func__);
 
+  if (con->reactor != NULL)
+  {
+    drizzle_reactor_reset(con);
+  }
+
   __closesocket(con->fd);
 
   if (con->socket_type == DRIZZLE_CON_SOCKET_UDS)
@@ -1269,14 +1473,30 @@ drizzle_return_t drizzle_state_read(drizzle_st *con)
 
   drizzle_log_debug(con, __func__);
 
-  if (con->buffer_size == 0)
+  if (con->uring_reading)
   {
-    con->buffer_ptr= con->buffer;
+    /* The reactor ring owns the free part of the buffer until its read
+       completes. */
+    return DRIZZLE_RETURN_IO_WAIT;
   }
-  else if ((size_t)(con->buffer_ptr - con->buffer) > (con->buffer_allocation / 2))
+
+  /* A read the reactor ring completed went right after the unread data. */
+  if (con->uring_read_done == false)
   {
-    memmove(con->buffer, con->buffer_ptr, con->buffer_size);
-    con->buffer_ptr= con->buffer;
+    drizzle_buffer_rewind(con);
+  }
+
+  /* A previous read may have brought in several compressed packets. */
+  if (con->compress != NULL && drizzle_compress_packet_ready(con))
+  {
+    ret= drizzle_compress_inflate(con);
+    if (ret != DRIZZLE_RETURN_OK)
+    {
+      return ret;
+    }
+
+    con->pop_state();
+    return DRIZZLE_RETURN_OK;
   }
 
   if ((con->revents & POLLIN) == 0 &&
@@ -1298,7 +1518,23 @@ drizzle_return_t drizzle_state_read(drizzle_st *con)
 
   while (1)
   {
-    size_t available_buffer= con->buffer_allocation - ((size_t)(con->buffer_ptr - con->buffer) + con->buffer_size);
+    unsigned char *read_ptr;
+    size_t available_buffer;
+
+    if (con->compress != NULL)
+    {
+      read_ptr= drizzle_compress_read_space(con, &available_buffer);
+      if (read_ptr == NULL)
+      {
+        return DRIZZLE_RETURN_MEMORY;
+      }
+    }
+    else
+    {
+      available_buffer= drizzle_buffer_available(con);
+      read_ptr= NULL;
+    }
+
     if (available_buffer == 0)
     {
       if (con->buffer_allocation >= DRIZZLE_MAX_BUFFER_SIZE)
@@ -1307,34 +1543,45 @@ drizzle_return_t drizzle_state_read(drizzle_st *con)
                           "buffer too small:%" PRIu32 , con->packet_size + 4);
         return DRIZZLE_RETURN_INTERNAL_ERROR;
       }
-      // Shift data to beginning of the buffer then resize
-      // This means that buffer_ptr isn't screwed up by realloc pointer move
-      if (con->buffer_ptr != con->buffer)
-      {
-        memmove(con->buffer, con->buffer_ptr, con->buffer_size);
-      }
-      con->buffer_allocation= con->buffer_allocation * 2;
-      unsigned char *realloc_buffer= (unsigned char*)realloc(con->buffer, con->buffer_allocation);
-      if (realloc_buffer == NULL)
+      ret= drizzle_buffer_resize(con, con->buffer_allocation * 2);
+      if (ret != DRIZZLE_RETURN_OK)
       {
-        drizzle_set_error(con, __func__, "realloc failure");
-        return DRIZZLE_RETURN_MEMORY;
+        return ret;
       }
-      con->buffer= realloc_buffer;
       drizzle_log_debug(con, "buffer resized to: %" PRIu32, con->buffer_allocation);
-      con->buffer_ptr= con->buffer;
-      available_buffer= con->buffer_allocation - con->buffer_size;
+      available_buffer= drizzle_buffer_available(con);
     }
 
+    if (read_ptr == NULL)
+    {
+      read_ptr= con->buffer_ptr + con->buffer_size;
+    }
+
+    if (con->uring_read_done)
+    {
+      con->uring_read_done= false;
+      read_size= con->uring_read_result;
+      if (read_size < 0)
+      {
+        errno= (int)-read_size;
+        read_size= -1;
+      }
+    }
+    else
 #ifdef USE_OPENSSL
     if (con->ssl_state == DRIZZLE_SSL_STATE_HANDSHAKE_COMPLETE)
     {
-        read_size= SSL_read(con->ssl, (char*)con->buffer_ptr + con->buffer_size, (available_buffer % INT_MAX));
+        read_size= SSL_read(con->ssl, (char*)read_ptr, (available_buffer % INT_MAX));
     }
     else
 #endif
+    if (con->uring != NULL)
+    {
+      read_size= drizzle_uring_recv(con, read_ptr, available_buffer);
+    }
+    else
     {
-      read_size= recv(con->fd, (char *)con->buffer_ptr + con->buffer_size, available_buffer, MSG_NOSIGNAL);
+      read_size= recv(con->fd, (char *)read_ptr, available_buffer, MSG_NOSIGNAL);
     }
 
 #if defined _WIN32 || defined __CYGWIN__
@@ -1399,6 +1646,14 @@ drizzle_return_t drizzle_state_read(drizzle_st *con)
       case EINTR:
         continue;
 
+#ifdef ETIME
+      case ETIME:
+        {
+          drizzle_set_error(con, __func__, "timeout reached");
+          return DRIZZLE_RETURN_TIMEOUT;
+        }
+#endif
+
       case EINVAL:
         {
           drizzle_log_debug(con, "EINVAL fd=%d buffer=%p available_buffer=%" PRIu64,
@@ -1426,10 +1681,36 @@ drizzle_return_t drizzle_state_read(drizzle_st *con)
     {
       con->revents&= ~POLLIN;
     }
+
+    if (con->compress != NULL)
+    {
+      drizzle_compress_read_done(con, (size_t)read_size);
+      if (drizzle_compress_packet_ready(con) == false)
+      {
+        continue;
+      }
+
+      ret= drizzle_compress_inflate(con);
+      if (ret != DRIZZLE_RETURN_OK)
+      {
+        return ret;
+      }
+      break;
+    }
+
     con->buffer_size+= (size_t)read_size;
     break;
   }
 
+  if (con->buffer_size > drizzle_buffer_resting_size(con))
+  {
+    con->buffer_small_reads= 0;
+  }
+  else if (con->buffer_small_reads < DRIZZLE_BUFFER_SHRINK_READS)
+  {
+    con->buffer_small_reads++;
+  }
+
   con->pop_state();
 
   return DRIZZLE_RETURN_OK;
@@ -1447,18 +1728,18 @@ drizzle_return_t drizzle_state_write(drizzle_st *con)
 
   drizzle_log_debug(con, __func__);
 
-  while (con->buffer_size != 0)
+  if (con->compress != NULL && drizzle_compress_write_pending(con))
   {
-#ifdef USE_OPENSSL
-    if (con->ssl_state == DRIZZLE_SSL_STATE_HANDSHAKE_COMPLETE)
-    {
-      write_size= SSL_write(con->ssl, con->buffer_ptr, (con->buffer_size % INT_MAX));
-    }
-    else
-#endif
+    ret= drizzle_compress_deflate(con);
+    if (ret != DRIZZLE_RETURN_OK)
     {
-      write_size= send(con->fd,(char *) con->buffer_ptr, con->buffer_size, MSG_NOSIGNAL);
+      return ret;
     }
+  }
+
+  while (con->buffer_size != 0 || con->write_data_size != 0)
+  {
+    write_size= _write_pending(con);
 
 #if defined _WIN32 || defined __CYGWIN__
     errno= translate_windows_error();
@@ -1506,6 +1787,13 @@ drizzle_return_t drizzle_state_write(drizzle_st *con)
       {
         continue;
       }
+#ifdef ETIME
+      else if (errno == ETIME)
+      {
+        drizzle_set_error(con, __func__, "timeout reached");
+        return DRIZZLE_RETURN_TIMEOUT;
+      }
+#endif
       else if (errno == EPIPE || errno == ECONNRESET)
       {
         drizzle_set_error(con, __func__, "%s:%d lost connection to server (%s)",
@@ -1518,13 +1806,23 @@ drizzle_return_t drizzle_state_write(drizzle_st *con)
       return DRIZZLE_RETURN_ERRNO;
     }
 
-    con->buffer_ptr+= write_size;
-    con->buffer_size-= (size_t)write_size;
-    if (con->buffer_size == 0)
-      break;
+    if ((size_t)write_size > con->buffer_size)
+    {
+      write_size-= (ssize_t)con->buffer_size;
+      con->buffer_ptr+= con->buffer_size;
+      con->buffer_size= 0;
+      con->write_data+= write_size;
+      con->write_data_size-= (size_t)write_size;
+    }
+    else
+    {
+      con->buffer_ptr+= write_size;
+      con->buffer_size-= (size_t)write_size;
+    }
   }
 
   con->buffer_ptr= con->buffer;
+  con->write_data= NULL;
 
   con->pop_state();
 
@@ -1535,6 +1833,64 @@ drizzle_return_t drizzle_state_write(drizzle_st *con)
  * Static Definitions
  */
 
+static ssize_t _write_pending(drizzle_st *con)
+{
+#ifdef USE_OPENSSL
+  if (con->ssl_state == DRIZZLE_SSL_STATE_HANDSHAKE_COMPLETE)
+  {
+    /* SSL_write() has no gather variant, send the segments in turn. */
+    if (con->buffer_size != 0)
+    {
+      return SSL_write(con->ssl, con->buffer_ptr, (con->buffer_size % INT_MAX));
+    }
+
+    return SSL_write(con->ssl, con->write_data, (con->write_data_size % INT_MAX));
+  }
+#endif
+
+#if defined _WIN32 || defined __CYGWIN__
+  if (con->buffer_size != 0)
+  {
+    return send(con->fd, (char *)con->buffer_ptr, con->buffer_size, MSG_NOSIGNAL);
+  }
+
+  return send(con->fd, (char *)con->write_data, con->write_data_size, MSG_NOSIGNAL);
+#else
+  if (con->write_data_size == 0 && con->uring == NULL)
+  {
+    return send(con->fd, (char *)con->buffer_ptr, con->buffer_size, MSG_NOSIGNAL);
+  }
+
+  struct iovec iov[2];
+  struct msghdr msg;
+  int iovcnt= 0;
+
+  if (con->buffer_size != 0)
+  {
+    iov[iovcnt].iov_base= con->buffer_ptr;
+    iov[iovcnt].iov_len= con->buffer_size;
+    iovcnt++;
+  }
+  if (con->write_data_size != 0)
+  {
+    iov[iovcnt].iov_base= con->write_data;
+    iov[iovcnt].iov_len= con->write_data_size;
+    iovcnt++;
+  }
+
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_iov= iov;
+  msg.msg_iovlen= iovcnt;
+
+  if (con->uring != NULL)
+  {
+    return drizzle_uring_sendmsg(con, &msg);
+  }
+
+  return sendmsg(con->fd, &msg, MSG_NOSIGNAL);
+#endif // defined _WIN32 || defined __CYGWIN__
+}
+
 static drizzle_return_t _setsockopt(drizzle_st *con)
 {
   struct linger linger;
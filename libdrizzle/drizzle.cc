@@ -208,6 +208,13 @@ drizzle_st *drizzle_clone(drizzle_st *drizzle, const drizzle_st *from)
   drizzle->capabilities= from->capabilities;
   drizzle->options= from->options;
 
+  if (drizzle->options.low_footprint == false &&
+      drizzle_buffer_resize(drizzle, DRIZZLE_DEFAULT_BUFFER_SIZE) != DRIZZLE_RETURN_OK)
+  {
+    delete drizzle;
+    return NULL;
+  }
+
   drizzle->backlog= from->backlog;
   strcpy(drizzle->db, from->db);
   strcpy(drizzle->password, from->password);
@@ -242,13 +249,23 @@ void drizzle_free(drizzle_st *con)
     con->context_free_fn(con, con->context);
   }
 
+  drizzle_pipeline_reset(con);
   drizzle_result_free_all(con);
 
+  if (con->reactor != NULL)
+  {
+    drizzle_reactor_remove(con->reactor, con);
+  }
+
   if (con->fd != INVALID_SOCKET)
   {
     drizzle_close(con);
   }
 
+  drizzle_uring_free(con);
+  drizzle_compress_free(con);
+  drizzle_pipeline_free(con);
+
   drizzle_reset_addrinfo(con);
 
 #ifdef USE_OPENSSL
@@ -264,7 +281,7 @@ void drizzle_free(drizzle_st *con)
     drizzle_binlog_free(con->binlog);
   }
 
-  free(con->buffer);
+  drizzle_buffer_free(con);
   delete con;
 }
 
@@ -417,6 +434,14 @@ drizzle_st *drizzle_create(const char *host, in_port_t port,
     con->options= *options;
   }
 
+  /* In low footprint mode the buffer is only allocated on connect. */
+  if (con->options.low_footprint == false &&
+      drizzle_buffer_resize(con, DRIZZLE_DEFAULT_BUFFER_SIZE) != DRIZZLE_RETURN_OK)
+  {
+    delete con;
+    return NULL;
+  }
+
   return con;
 }
 
@@ -466,7 +491,11 @@ void drizzle_set_error(drizzle_st *con, const char *function,
 
   if (con->log_fn == NULL)
   {
-    memcpy(con->last_error, log_buffer, size + 1);
+    char *last_error= drizzle_error_buffer(con);
+    if (last_error != NULL)
+    {
+      memcpy(last_error, log_buffer, size + 1);
+    }
   }
   else
   {
@@ -474,6 +503,20 @@ void drizzle_set_error(drizzle_st *con, const char *function,
   }
 }
 
+char *drizzle_error_buffer(drizzle_st *con)
+{
+  if (con->last_error == NULL)
+  {
+    con->last_error= (char *)malloc(DRIZZLE_MAX_ERROR_SIZE);
+    if (con->last_error != NULL)
+    {
+      con->last_error[0]= '\0';
+    }
+  }
+
+  return con->last_error;
+}
+
 __attribute__((__format__ (__printf__, 3, 0)))
 void drizzle_log(drizzle_st *con, drizzle_verbose_t verbose,
                  const char *format, va_list args)
@@ -498,3 +541,13 @@ void drizzle_log(drizzle_st *con, drizzle_verbose_t verbose,
     con->log_fn(log_buffer, verbose, con->log_context);
   }
 }
+
+void drizzle_log_message(drizzle_st *con, drizzle_verbose_t verbose,
+                         const char *format, ...)
+{
+  va_list args;
+
+  va_start(args, format);
+  drizzle_log(con, verbose, format, args);
+  va_end(args);
+}
@@ -61,6 +61,18 @@ extern "C" {
  */
 void drizzle_set_error(drizzle_st *con, const char *function, const char *format, ...);
 
+/**
+ * Get the buffer holding the last error message, allocating it on first
+ * use. Most connections never see an error, so the storage is kept out of
+ * drizzle_st.
+ *
+ * @param[in] con Connection structure previously initialized with
+ *  drizzle_create(), drizzle_clone(), or related functions.
+ * @return Buffer of DRIZZLE_MAX_ERROR_SIZE bytes, or NULL if it could not
+ *  be allocated.
+ */
+char *drizzle_error_buffer(drizzle_st *con);
+
 /**
  * Free a connection structure.
  *
@@ -93,6 +105,14 @@ bool drizzle_library_init(drizzle_st*);
  */
 drizzle_result_st *drizzle_result_create(drizzle_st *con);
 
+/**
+ * Record on a result that has just been completed whether the server
+ * announced another result set after it
+ *
+ * @param[in,out] result the result object whose last packet was read
+ */
+void drizzle_result_set_more_results(drizzle_result_st *result);
+
 /*
  * Convert a char array to hex
  *
@@ -128,64 +148,42 @@ bool drizzle_mysql_password_hash(char *to, const char *from, const size_t from_s
 void drizzle_log(drizzle_st *con, drizzle_verbose_t verbose, const char *format, va_list args);
 
 /**
- * Log a fatal message, see drizzle_log() for argument details.
+ * Log a message, with the same arguments as drizzle_log() but a variable
+ * argument list. Use the drizzle_log_* macros below, they only call it when
+ * the message is logged.
  */
-static inline void drizzle_log_fatal(drizzle_st *con, const char *format, ...)
-{
-  va_list args;
-
-  if (con->verbose >= DRIZZLE_VERBOSE_CRITICAL)
-  {
-    va_start(args, format);
-    drizzle_log(con, DRIZZLE_VERBOSE_CRITICAL, format, args);
-    va_end(args);
-  }
-}
+void drizzle_log_message(drizzle_st *con, drizzle_verbose_t verbose,
+                         const char *format, ...);
 
-/**
- * Log an error message, see drizzle_log() for argument details.
- */
-static inline void drizzle_log_error(drizzle_st *con, const char *format, ...)
-{
-  va_list args;
-
-  if (con->verbose >= DRIZZLE_VERBOSE_ERROR)
-  {
-    va_start(args, format);
-    drizzle_log(con, DRIZZLE_VERBOSE_ERROR, format, args);
-    va_end(args);
-  }
-}
-
-/**
- * Log an info message, see drizzle_log() for argument details.
- */
-static inline void drizzle_log_info(drizzle_st *con, const char *format, ...)
-{
-  va_list args;
-
-  if (con->verbose >= DRIZZLE_VERBOSE_INFO)
-  {
-    va_start(args, format);
-    drizzle_log(con, DRIZZLE_VERBOSE_INFO, format, args);
-    va_end(args);
-  }
-}
-
-/**
- * Log a debug message, see drizzle_log() for argument details.
+/*
+ * Log a message at a given level, see drizzle_log() for argument details.
+ * These are macros so that the arguments, which may be costly to compute,
+ * are only evaluated when the connection logs messages of that level.
  */
-static inline void drizzle_log_debug(drizzle_st *con, const char *format, ...)
-{
-  va_list args;
-
-  if (con->verbose >= DRIZZLE_VERBOSE_DEBUG)
-  {
-    va_start(args, format);
-    drizzle_log(con, DRIZZLE_VERBOSE_DEBUG, format, args);
-    va_end(args);
-  }
-}
+#define drizzle_log_level(__con, __verbose, ...) do { \
+  if ((__con)->verbose >= (__verbose)) \
+    drizzle_log_message((__con), (__verbose), __VA_ARGS__); \
+} while (0)
+
+#define drizzle_log_fatal(__con, ...) \
+  drizzle_log_level((__con), DRIZZLE_VERBOSE_CRITICAL, __VA_ARGS__)
+#define drizzle_log_error(__con, ...) \
+  drizzle_log_level((__con), DRIZZLE_VERBOSE_ERROR, __VA_ARGS__)
+#define drizzle_log_info(__con, ...) \
+  drizzle_log_level((__con), DRIZZLE_VERBOSE_INFO, __VA_ARGS__)
+
+/* Debug messages are logged on every packet and state, configure with
+   --disable-debug-log leaves them out of the library. The call is kept
+   behind a constant so the arguments are still compiled. */
+#ifdef DRIZZLE_DISABLE_DEBUG_LOG
+#define drizzle_log_debug(__con, ...) do { \
+  if (0) \
+    drizzle_log_message((__con), DRIZZLE_VERBOSE_DEBUG, __VA_ARGS__); \
+} while (0)
+#else
+#define drizzle_log_debug(__con, ...) \
+  drizzle_log_level((__con), DRIZZLE_VERBOSE_DEBUG, __VA_ARGS__)
+#endif
 
 /** @} */
 
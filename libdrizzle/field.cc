@@ -46,6 +46,9 @@
 
 #include <inttypes.h>
 
+/* Smallest buffer drizzle_field_buffer() allocates for a column. */
+#define DRIZZLE_FIELD_BUFFER_MIN_SIZE 32
+
 /*
  * Client definitions
  */
@@ -157,12 +160,6 @@ drizzle_field_t drizzle_field_buffer(drizzle_result_st *result, size_t *total,
 #endif
   *total = (size_t)wire_size;
 
-  if (result->field_buffer == NULL)
-  {
-    result->field_buffer= new (std::nothrow) char*[result->column_count]();
-    result->field_buffer_sizes= new (std::nothrow) size_t[result->column_count]();
-  }
-
   /* If we haven't got the whole field then current field hasn't been
    * incremented yet */
   if ((result->field_offset + result->field_size) != result->field_total)
@@ -174,36 +171,9 @@ drizzle_field_t drizzle_field_buffer(drizzle_result_st *result, size_t *total,
     current_field= result->field_current-1;
   }
 
-  /*
-    The code below pre-allocates each field in the buffer to a statically defined
-    size to reduce the number of mallocs at the cost of a memory overhead
-
-    Experimental results did confirm that the number of allocations is halved
-    but with the caveat that the number of bytes allocated is doubled.
-
-    Given that the improvement from lazy allocation is already five orders of
-    magnitude, having minimal memory overhead is (in our opinion) more favorable
-
-    The code is kept for reference and in the case that others would like to
-    pursue this optimization further
-
-    if (result->field_buffer_sizes[current_field] == 0)
-    {
-      result->field_buffer[current_field]= (drizzle_field_t) malloc(64*1024);
-      result->field_buffer_sizes[current_field]= 64*1024;
-    }
-  */
-
-  if (result->field_buffer_sizes[current_field] < (*total) + 1)
+  if (drizzle_field_buffer_reserve(result, current_field, *total, ret_ptr) == NULL)
   {
-    result->field_buffer[current_field]= (drizzle_field_t) realloc(result->field_buffer[current_field], (*total) + 1);
-    result->field_buffer_sizes[current_field]= (*total) + 1;
-    if (result->field_buffer[current_field] == NULL)
-    {
-      drizzle_set_error(result->con, __func__, "Failed to allocate.");
-      *ret_ptr= DRIZZLE_RETURN_MEMORY;
-      return NULL;
-    }
+    return NULL;
   }
 
   memcpy(result->field_buffer[current_field] + offset, field, size);
@@ -234,6 +204,74 @@ drizzle_field_t drizzle_field_buffer(drizzle_result_st *result, size_t *total,
   return field;
 }
 
+drizzle_field_t drizzle_field_buffer_reserve(drizzle_result_st *result,
+                                             uint16_t field, size_t size,
+                                             drizzle_return_t *ret_ptr)
+{
+  if (result->field_buffer == NULL)
+  {
+    result->field_buffer= new (std::nothrow) char*[result->column_count]();
+    result->field_buffer_sizes= new (std::nothrow) size_t[result->column_count]();
+    if (result->field_buffer == NULL || result->field_buffer_sizes == NULL)
+    {
+      delete[] result->field_buffer;
+      delete[] result->field_buffer_sizes;
+      result->field_buffer= NULL;
+      result->field_buffer_sizes= NULL;
+      drizzle_set_error(result->con, __func__, "Failed to allocate.");
+      *ret_ptr= DRIZZLE_RETURN_MEMORY;
+      return NULL;
+    }
+  }
+
+  /*
+    The code below pre-allocates each field in the buffer to a statically defined
+    size to reduce the number of mallocs at the cost of a memory overhead
+
+    Experimental results did confirm that the number of allocations is halved
+    but with the caveat that the number of bytes allocated is doubled.
+
+    Given that the improvement from lazy allocation is already five orders of
+    magnitude, having minimal memory overhead is (in our opinion) more favorable
+
+    The code is kept for reference and in the case that others would like to
+    pursue this optimization further
+
+    if (result->field_buffer_sizes[field] == 0)
+    {
+      result->field_buffer[field]= (drizzle_field_t) malloc(64*1024);
+      result->field_buffer_sizes[field]= 64*1024;
+    }
+  */
+
+  if (result->field_buffer_sizes[field] < size + 1)
+  {
+    /* Grow geometrically so a column whose values get longer row after row
+       is only reallocated a few times. */
+    size_t buffer_size= result->field_buffer_sizes[field] * 2;
+    if (buffer_size < DRIZZLE_FIELD_BUFFER_MIN_SIZE)
+    {
+      buffer_size= DRIZZLE_FIELD_BUFFER_MIN_SIZE;
+    }
+    if (buffer_size < size + 1)
+    {
+      buffer_size= size + 1;
+    }
+
+    drizzle_field_t buffer= (drizzle_field_t) realloc(result->field_buffer[field], buffer_size);
+    if (buffer == NULL)
+    {
+      drizzle_set_error(result->con, __func__, "Failed to allocate.");
+      *ret_ptr= DRIZZLE_RETURN_MEMORY;
+      return NULL;
+    }
+    result->field_buffer[field]= buffer;
+    result->field_buffer_sizes[field]= buffer_size;
+  }
+
+  return result->field_buffer[field];
+}
+
 void drizzle_field_free(drizzle_field_t field)
 {
   if (field)
@@ -374,7 +412,10 @@ drizzle_return_t drizzle_state_binary_null_read(drizzle_st *con)
 {
   uint16_t bit_count= 0;
   con->result->null_bitmap_length= (con->result->column_count+7+2)/8;
-  con->result->null_bitmap= new uint8_t[con->result->null_bitmap_length];
+  if (con->result->null_bitmap == NULL)
+  {
+    con->result->null_bitmap= new uint8_t[con->result->null_bitmap_length];
+  }
   con->buffer_ptr++;
 
   memcpy(con->result->null_bitmap, con->buffer_ptr, con->result->null_bitmap_length);
@@ -389,6 +430,7 @@ drizzle_return_t drizzle_state_binary_null_read(drizzle_st *con)
     }
   }
   con->result->null_bitcount = bit_count;
+  con->result->field_column= 0;
   con->buffer_ptr+= con->result->null_bitmap_length;
   con->buffer_size-= con->result->null_bitmap_length+1;
   con->packet_size-= con->result->null_bitmap_length+1;
@@ -402,57 +444,41 @@ drizzle_return_t drizzle_state_binary_field_read(drizzle_st *con)
 {
   drizzle_return_t ret;
 
-  switch(con->result->column_buffer[con->result->field_current].type)
-  {
-    case DRIZZLE_COLUMN_TYPE_NULL:
-      break;
-    case DRIZZLE_COLUMN_TYPE_TINY:
-      con->result->field_size= 1;
-      break;
-    case DRIZZLE_COLUMN_TYPE_SHORT:
-    case DRIZZLE_COLUMN_TYPE_YEAR:
-      con->result->field_size= 2;
-      break;
-    case DRIZZLE_COLUMN_TYPE_INT24:
-    case DRIZZLE_COLUMN_TYPE_LONG:
-    case DRIZZLE_COLUMN_TYPE_FLOAT:
-      con->result->field_size= 4;
-      break;
-    case DRIZZLE_COLUMN_TYPE_LONGLONG:
-    case DRIZZLE_COLUMN_TYPE_DOUBLE:
-      con->result->field_size= 8;
-      break;
-    case DRIZZLE_COLUMN_TYPE_TIME:
-    case DRIZZLE_COLUMN_TYPE_DATE:
-    case DRIZZLE_COLUMN_TYPE_DATETIME:
-    case DRIZZLE_COLUMN_TYPE_TIMESTAMP:
-    case DRIZZLE_COLUMN_TYPE_TINY_BLOB:
-    case DRIZZLE_COLUMN_TYPE_MEDIUM_BLOB:
-    case DRIZZLE_COLUMN_TYPE_LONG_BLOB:
-    case DRIZZLE_COLUMN_TYPE_BLOB:
-    case DRIZZLE_COLUMN_TYPE_BIT:
-    case DRIZZLE_COLUMN_TYPE_STRING:
-    case DRIZZLE_COLUMN_TYPE_VAR_STRING:
-    case DRIZZLE_COLUMN_TYPE_DECIMAL:
-    case DRIZZLE_COLUMN_TYPE_NEWDECIMAL:
-    case DRIZZLE_COLUMN_TYPE_NEWDATE:
-      con->result->field_size= (uint32_t)drizzle_unpack_length(con, &ret);
-      if (ret != DRIZZLE_RETURN_OK)
-      {
-        return ret;
-      }
-      break;
-    case DRIZZLE_COLUMN_TYPE_VARCHAR:
-    case DRIZZLE_COLUMN_TYPE_ENUM:
-    case DRIZZLE_COLUMN_TYPE_SET:
-    case DRIZZLE_COLUMN_TYPE_GEOMETRY:
-    /* We do not need to support these three: they exist internally to the MySQL server, but do not appear on the wire */
-    case DRIZZLE_COLUMN_TYPE_TIMESTAMP2:
-    case DRIZZLE_COLUMN_TYPE_DATETIME2:
-    case DRIZZLE_COLUMN_TYPE_TIME2:
-    default:
-      return DRIZZLE_RETURN_UNEXPECTED_DATA;
-      break;
+  /* Only fields that are not NULL are sent, skip to the column of this one. */
+  uint16_t column= con->result->field_column;
+  while (column < con->result->column_count &&
+         con->result->null_bitmap[(column + 2) / 8] & (1 << ((column + 2) % 8)))
+  {
+    column++;
+  }
+
+  if (column == con->result->column_count)
+  {
+    return DRIZZLE_RETURN_UNEXPECTED_DATA;
+  }
+
+  uint32_t size;
+  ret= drizzle_column_binary_size(con->result->column_buffer[column].type, &size);
+  if (ret != DRIZZLE_RETURN_OK)
+  {
+    return ret;
+  }
+
+  if (con->result->column_buffer[column].type == DRIZZLE_COLUMN_TYPE_NULL)
+  {
+    /* Nothing is sent for the value, the field size is left as it was. */
+  }
+  else if (size)
+  {
+    con->result->field_size= size;
+  }
+  else
+  {
+    con->result->field_size= (uint32_t)drizzle_unpack_length(con, &ret);
+    if (ret != DRIZZLE_RETURN_OK)
+    {
+      return ret;
+    }
   }
 
   con->result->field= (char*) con->buffer_ptr;
@@ -461,6 +487,7 @@ drizzle_return_t drizzle_state_binary_field_read(drizzle_st *con)
   con->packet_size-= con->result->field_size;
   con->result->field_total= con->result->field_size;
 
+  con->result->field_column= column + 1;
   con->result->field_current++;
   con->pop_state();
   return DRIZZLE_RETURN_OK;
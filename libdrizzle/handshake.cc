@@ -179,6 +179,16 @@ drizzle_return_t drizzle_state_handshake_server_read(drizzle_st *con)
   con->buffer_ptr+= 1;
 
   con->status= (drizzle_status_t)drizzle_get_byte2(con->buffer_ptr);
+
+  /* Of the upper capability flags only the zstd compression algorithm, see
+     drizzle_compress_negotiate(), the OK packet replacing EOF packets and
+     optional result set metadata are taken over. */
+  con->capabilities= (drizzle_capabilities_t)((int)con->capabilities |
+                     (int)(((uint32_t)drizzle_get_byte2(con->buffer_ptr + 2) << 16) &
+                           (DRIZZLE_CAPABILITIES_ZSTD_COMPRESSION_ALGORITHM |
+                            DRIZZLE_CAPABILITIES_DEPRECATE_EOF |
+                            DRIZZLE_CAPABILITIES_OPTIONAL_RESULTSET_METADATA)));
+
   /* Skip status and filler. */
   con->buffer_ptr+= 15;
 
@@ -507,13 +517,40 @@ int drizzle_compile_capabilities(drizzle_st *con)
   {
     capabilities|= DRIZZLE_CAPABILITIES_PLUGIN_AUTH;
   }
+
+  /* Result sets then end with a single OK packet and the EOF packet after
+     the column definitions is left out. */
+  if (con->capabilities & DRIZZLE_CAPABILITIES_DEPRECATE_EOF)
+  {
+    capabilities|= DRIZZLE_CAPABILITIES_DEPRECATE_EOF;
+  }
+
+  /* The server then says whether column definitions follow, and leaves them
+     out when the session sets resultset_metadata to NONE. */
+  if (con->capabilities & DRIZZLE_CAPABILITIES_OPTIONAL_RESULTSET_METADATA)
+  {
+    capabilities|= DRIZZLE_CAPABILITIES_OPTIONAL_RESULTSET_METADATA;
+  }
 #ifdef USE_OPENSSL
   if (con->ssl)
   {
     capabilities|= DRIZZLE_CAPABILITIES_SSL;
   }
 #endif
-  capabilities&= ~DRIZZLE_CAPABILITIES_COMPRESS;
+  switch (drizzle_compress_negotiate(con))
+  {
+  case DRIZZLE_COMPRESSION_ZLIB:
+    capabilities|= DRIZZLE_CAPABILITIES_COMPRESS;
+    break;
+
+  case DRIZZLE_COMPRESSION_ZSTD:
+    capabilities|= DRIZZLE_CAPABILITIES_ZSTD_COMPRESSION_ALGORITHM;
+    break;
+
+  case DRIZZLE_COMPRESSION_NONE:
+    break;
+  }
+
   if (con->db[0] == 0)
     capabilities&= ~DRIZZLE_CAPABILITIES_CONNECT_WITH_DB;
 
@@ -557,6 +594,12 @@ drizzle_return_t drizzle_state_handshake_client_write(drizzle_st *con)
                   + DRIZZLE_MAX_SCRAMBLE_SIZE
                   + strlen(con->db) + 1);
 
+  con->compression= drizzle_compress_negotiate(con);
+  if (con->compression == DRIZZLE_COMPRESSION_ZSTD)
+  {
+    con->packet_size++; /* zstd compression level */
+  }
+
   /* Assume the entire handshake packet will fit in the buffer. */
   if ((con->packet_size + 4) > con->buffer_allocation)
   {
@@ -590,6 +633,21 @@ drizzle_return_t drizzle_state_handshake_client_write(drizzle_st *con)
   if (ret != DRIZZLE_RETURN_OK)
     return ret;
 
+  if (con->compression == DRIZZLE_COMPRESSION_ZSTD)
+  {
+    /* The level follows the last field the server parses. Without a
+       database or plugin name that is the password, so it replaces the
+       terminator written for the empty database name. */
+    if ((capabilities & (DRIZZLE_CAPABILITIES_CONNECT_WITH_DB |
+                         DRIZZLE_CAPABILITIES_PLUGIN_AUTH)) == 0)
+    {
+      ptr--;
+      con->packet_size--;
+    }
+    ptr[0]= drizzle_compress_zstd_level(con);
+    ptr++;
+  }
+
   con->buffer_size+= (4 + con->packet_size);
 
   /* Make sure we packed it correctly. */
@@ -675,6 +733,12 @@ drizzle_return_t drizzle_state_handshake_result_read(drizzle_st *con)
       else
       {
         con->state.ready= true;
+
+        /* Everything after the server OK is compressed. */
+        if (con->compression != DRIZZLE_COMPRESSION_NONE)
+        {
+          ret= drizzle_compress_start(con);
+        }
       }
     }
   }
@@ -495,11 +495,55 @@ bool drizzle_check_unpack_error(drizzle_st *con)
   con->buffer_size-= 9;
   con->packet_size-= 9;
 
-  snprintf(con->last_error, DRIZZLE_MAX_ERROR_SIZE, "%.*s",
-           (int)con->packet_size-1, con->buffer_ptr);
+  char *last_error= drizzle_error_buffer(con);
+  if (last_error != NULL)
+  {
+    snprintf(last_error, DRIZZLE_MAX_ERROR_SIZE, "%.*s",
+             (int)con->packet_size-1, con->buffer_ptr);
+
+    drizzle_set_error(con, __func__, " %s", last_error);
+  }
+
+  con->buffer_ptr+= con->packet_size;
+  con->buffer_size-= con->packet_size;
+  con->packet_size= 0;
+
+  return true;
+}
+
+bool drizzle_check_unpack_eof(drizzle_st *con, uint16_t *warning_count)
+{
+  if (con->buffer_ptr[0] != 254)
+    return false;
+
+  if (con->packet_size == 5)
+  {
+    *warning_count= drizzle_get_byte2(con->buffer_ptr + 1);
+    con->status= (drizzle_status_t)drizzle_get_byte2(con->buffer_ptr + 3);
+    con->buffer_ptr+= 5;
+    con->buffer_size-= 5;
+    return true;
+  }
+
+  /* A row may start with 0xFE as well, but only when its first field is long
+     enough to fill a whole packet. */
+  if (!(con->capabilities & DRIZZLE_CAPABILITIES_DEPRECATE_EOF) ||
+      con->packet_size >= 0xFFFFFF)
+    return false;
+
+  con->buffer_ptr++;
+  con->buffer_size--;
+  con->packet_size--;
+
+  /* Affected rows and insert id, we can ignore the returns since we've
+     buffered the entire packet. */
+  (void)drizzle_unpack_length(con, NULL);
+  (void)drizzle_unpack_length(con, NULL);
 
-  drizzle_set_error(con, __func__, " %s", con->last_error);
+  con->status= (drizzle_status_t)drizzle_get_byte2(con->buffer_ptr);
+  *warning_count= drizzle_get_byte2(con->buffer_ptr + 2);
 
+  /* Skip the status, the warning count and any trailing information. */
   con->buffer_ptr+= con->packet_size;
   con->buffer_size-= con->packet_size;
   con->packet_size= 0;
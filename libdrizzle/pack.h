@@ -107,6 +107,19 @@ unsigned char *drizzle_pack_auth(drizzle_st *con, unsigned char *ptr,
  */
 bool drizzle_check_unpack_error(drizzle_st *con);
 
+/**
+ * Check if the packet ending rows has been received. That is an EOF_Packet,
+ * or once DRIZZLE_CAPABILITIES_DEPRECATE_EOF was negotiated the OK_Packet
+ * with a 0xFE header sent in its place, which must be buffered entirely.
+ * If it was received the server status is set and the packet is consumed.
+ *
+ * @param[in] con Drizzle structure previously initialized with
+ *  drizzle_create() or drizzle_clone().
+ * @param[out] warning_count Warning count carried by the packet
+ * @return True if the packet ending rows was received, false otherwise
+ */
+bool drizzle_check_unpack_eof(drizzle_st *con, uint16_t *warning_count);
+
 /** @} */
 
 #ifdef __cplusplus
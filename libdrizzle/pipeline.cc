@@ -0,0 +1,475 @@
+/* vim:expandtab:shiftwidth=2:tabstop=2:smarttab:
+ *
+ * Drizzle Client & Protocol Library
+ *
+ * Copyright (C) 2012-2013 Drizzle Developer Group
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following disclaimer
+ * in the documentation and/or other materials provided with the
+ * distribution.
+ *
+ *     * The names of its contributors may not be used to endorse or
+ * promote products derived from this software without specific prior
+ * written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/**
+ * @file
+ * @brief Pipeline Definitions
+ */
+
+#include "config.h"
+#include "libdrizzle/common.h"
+
+/* Initial size of the buffer holding queued commands. */
+#define DRIZZLE_PIPELINE_BUFFER_SIZE 4096
+/* Largest command payload that fits in a single packet. */
+#define DRIZZLE_PIPELINE_MAX_PAYLOAD 0xFFFFFE
+/* Most command bytes sent before the results of the previous ones are read.
+   The server stops reading commands while it waits to send a result, so
+   whatever is in flight has to fit in the socket buffers. */
+#define DRIZZLE_PIPELINE_FLUSH_SIZE 16384
+
+/**
+ * @addtogroup drizzle_pipeline_static Static Pipeline Declarations
+ * @ingroup drizzle_pipeline
+ * @{
+ */
+
+/**
+ * Make sure a command can be queued on a connection, connecting it first
+ * if needed.
+ *
+ * @param[in] con Connection structure.
+ * @return Standard drizzle return value.
+ */
+static drizzle_return_t _pipeline_ready(drizzle_st *con)
+{
+  drizzle_return_t ret;
+
+  /* Finish sending the previous batch, its buffer can not move meanwhile. */
+  if (con->state.pipeline_write)
+  {
+    ret= drizzle_pipeline_flush(con);
+    if (ret != DRIZZLE_RETURN_OK)
+    {
+      return ret;
+    }
+  }
+
+  if (con->state.ready == false)
+  {
+    if (con->state.raw_packet)
+    {
+      drizzle_set_error(con, __func__, "connection not ready");
+      return DRIZZLE_RETURN_NOT_READY;
+    }
+
+    ret= drizzle_connect(con);
+    if (ret != DRIZZLE_RETURN_OK)
+    {
+      return ret;
+    }
+  }
+
+  if (con->compress != NULL)
+  {
+    drizzle_set_error(con, __func__,
+                      "pipelining is not supported on compressed connections");
+    return DRIZZLE_RETURN_NOT_READY;
+  }
+
+  return DRIZZLE_RETURN_OK;
+}
+
+/**
+ * Append a command packet to the queued commands and create its result.
+ *
+ * @param[in] con Connection structure.
+ * @param[in] command Command to queue.
+ * @param[in] data Command payload.
+ * @param[in] size Size of data.
+ * @param[in] stmt Statement the command executes, or NULL.
+ * @return Standard drizzle return value.
+ */
+static drizzle_return_t _pipeline_append(drizzle_st *con,
+                                         drizzle_command_t command,
+                                         const unsigned char *data,
+                                         size_t size, drizzle_stmt_st *stmt)
+{
+  size_t needed;
+
+  if (size > DRIZZLE_PIPELINE_MAX_PAYLOAD - 1)
+  {
+    drizzle_set_error(con, __func__, "command too large to be pipelined");
+    return DRIZZLE_RETURN_INVALID_ARGUMENT;
+  }
+
+  /* Drop the commands already sent, no write is using them any more. */
+  if (con->pipeline_sent != 0)
+  {
+    memmove(con->pipeline_buffer, con->pipeline_buffer + con->pipeline_sent,
+            con->pipeline_size - con->pipeline_sent);
+    con->pipeline_size-= con->pipeline_sent;
+    con->pipeline_sent= 0;
+  }
+
+  needed= con->pipeline_size + 5 + size;
+  if (needed > con->pipeline_allocation)
+  {
+    size_t allocation= con->pipeline_allocation ? con->pipeline_allocation
+                                                : DRIZZLE_PIPELINE_BUFFER_SIZE;
+    while (allocation < needed)
+    {
+      allocation*= 2;
+    }
+
+    unsigned char *buffer= (unsigned char *)realloc(con->pipeline_buffer,
+                                                    allocation);
+    if (buffer == NULL)
+    {
+      drizzle_set_error(con, __func__, "Failed to allocate.");
+      return DRIZZLE_RETURN_MEMORY;
+    }
+    con->pipeline_buffer= buffer;
+    con->pipeline_allocation= allocation;
+  }
+
+  /* drizzle_result_create() makes the new result current, which it is not
+     until it is read. */
+  drizzle_result_st *current= con->result;
+  drizzle_result_st *result= drizzle_result_create(con);
+  con->result= current;
+  if (result == NULL)
+  {
+    return DRIZZLE_RETURN_MEMORY;
+  }
+  result->stmt= stmt;
+  result->pipelined= true;
+
+  unsigned char *ptr= con->pipeline_buffer + con->pipeline_size;
+  drizzle_set_byte3(ptr, 1 + size);
+  ptr[3]= 0;
+  ptr[4]= (unsigned char)command;
+  memcpy(ptr + 5, data, size);
+  con->pipeline_size= needed;
+
+  /* Results are created at the front of result_list, so the queue runs
+     from the oldest one towards the front through 'prev', skipping results
+     read with drizzle_result_next() in between. */
+  if (con->pipeline_head == NULL)
+  {
+    con->pipeline_head= result;
+  }
+  con->pipeline_queued++;
+
+  return DRIZZLE_RETURN_OK;
+}
+
+/**
+ * Find the queued result that follows a given one.
+ *
+ * @param[in] con Connection structure.
+ * @param[in] result A queued result.
+ * @return The next queued result, or NULL if result is the last one.
+ */
+static drizzle_result_st *_pipeline_next(drizzle_st *con,
+                                         drizzle_result_st *result)
+{
+  if (con->pipeline_pending + con->pipeline_sending + con->pipeline_queued == 0)
+  {
+    return NULL;
+  }
+
+  drizzle_result_st *next= result->prev;
+  while (next != NULL && next->pipelined == false)
+  {
+    next= next->prev;
+  }
+
+  return next;
+}
+
+/** @} */
+
+/*
+ * Common Definitions
+ */
+
+drizzle_return_t drizzle_pipeline_query(drizzle_st *con, const char *query,
+                                        size_t size)
+{
+  drizzle_return_t ret;
+
+  if (con == NULL || query == NULL)
+  {
+    return DRIZZLE_RETURN_INVALID_ARGUMENT;
+  }
+
+  ret= _pipeline_ready(con);
+  if (ret != DRIZZLE_RETURN_OK)
+  {
+    return ret;
+  }
+
+  if (size == 0)
+  {
+    size= strlen(query);
+  }
+
+  return _pipeline_append(con, DRIZZLE_COMMAND_QUERY,
+                          (const unsigned char *)query, size, NULL);
+}
+
+drizzle_return_t drizzle_pipeline_stmt_execute(drizzle_stmt_st *stmt)
+{
+  unsigned char *buffer;
+  size_t buffer_size;
+  drizzle_return_t ret;
+
+  if (stmt == NULL)
+  {
+    return DRIZZLE_RETURN_INVALID_ARGUMENT;
+  }
+
+  if (stmt->state < DRIZZLE_STMT_PREPARED)
+  {
+    drizzle_set_error(stmt->con, __func__, "stmt object has not been prepared");
+    return DRIZZLE_RETURN_STMT_ERROR;
+  }
+
+  ret= _pipeline_ready(stmt->con);
+  if (ret != DRIZZLE_RETURN_OK)
+  {
+    return ret;
+  }
+
+  ret= drizzle_stmt_execute_pack(stmt, &buffer, &buffer_size);
+  if (ret != DRIZZLE_RETURN_OK)
+  {
+    return ret;
+  }
+
+  ret= _pipeline_append(stmt->con, DRIZZLE_COMMAND_STMT_EXECUTE, buffer,
+                        buffer_size, stmt);
+
+  /* Parameter types are only sent with the first execution after binding. */
+  if (ret == DRIZZLE_RETURN_OK)
+  {
+    stmt->new_bind= false;
+  }
+
+  return ret;
+}
+
+drizzle_return_t drizzle_pipeline_flush(drizzle_st *con)
+{
+  drizzle_return_t ret;
+
+  if (con == NULL)
+  {
+    return DRIZZLE_RETURN_INVALID_ARGUMENT;
+  }
+
+  if (con->state.pipeline_write == false)
+  {
+    /* The receive buffer also holds outgoing data, so nothing can be sent
+       while responses to the previous batch may still be in it. The queued
+       commands then go out from drizzle_pipeline_result(). */
+    if (con->pipeline_pending != 0 || con->pipeline_queued == 0)
+    {
+      return DRIZZLE_RETURN_OK;
+    }
+
+    if (con->has_state() == false)
+    {
+      drizzle_set_error(con, __func__, "a command is in progress");
+      return DRIZZLE_RETURN_NOT_READY;
+    }
+
+    /* Send whole commands up to DRIZZLE_PIPELINE_FLUSH_SIZE, at least one. */
+    size_t size= 0;
+    uint32_t count= 0;
+    while (count < con->pipeline_queued)
+    {
+      size_t packet= 4 + drizzle_get_byte3(con->pipeline_buffer +
+                                           con->pipeline_sent + size);
+      if (count > 0 && size + packet > DRIZZLE_PIPELINE_FLUSH_SIZE)
+      {
+        break;
+      }
+      size+= packet;
+      count++;
+    }
+
+    con->write_data= con->pipeline_buffer + con->pipeline_sent;
+    con->write_data_size= size;
+    con->pipeline_sent+= size;
+    con->pipeline_queued-= count;
+    con->pipeline_sending= count;
+    con->state.pipeline_write= true;
+    con->push_state(drizzle_state_write);
+  }
+
+  ret= drizzle_state_loop(con);
+  if (ret == DRIZZLE_RETURN_OK)
+  {
+    con->state.pipeline_write= false;
+    con->pipeline_pending+= con->pipeline_sending;
+    con->pipeline_sending= 0;
+    if (con->pipeline_sent == con->pipeline_size)
+    {
+      con->pipeline_sent= 0;
+      con->pipeline_size= 0;
+    }
+  }
+
+  return ret;
+}
+
+drizzle_result_st *drizzle_pipeline_result(drizzle_st *con,
+                                           drizzle_return_t *ret_ptr)
+{
+  drizzle_return_t unused;
+  drizzle_result_st *result;
+
+  if (ret_ptr == NULL)
+  {
+    ret_ptr= &unused;
+  }
+
+  if (con == NULL)
+  {
+    *ret_ptr= DRIZZLE_RETURN_INVALID_ARGUMENT;
+    return NULL;
+  }
+
+  if (con->state.pipeline_read == false)
+  {
+    if (con->pipeline_pending == 0)
+    {
+      *ret_ptr= drizzle_pipeline_flush(con);
+      if (*ret_ptr != DRIZZLE_RETURN_OK || con->pipeline_pending == 0)
+      {
+        return NULL;
+      }
+    }
+
+    if (con->has_state() == false)
+    {
+      drizzle_set_error(con, __func__, "a command is in progress");
+      *ret_ptr= DRIZZLE_RETURN_NOT_READY;
+      return NULL;
+    }
+
+    if (con->status & DRIZZLE_CON_STATUS_MORE_RESULTS_EXISTS)
+    {
+      drizzle_set_error(con, __func__,
+                        "more result sets of the previous command must be "
+                        "read with drizzle_result_next()");
+      *ret_ptr= DRIZZLE_RETURN_NOT_READY;
+      return NULL;
+    }
+
+    result= con->pipeline_head;
+    con->result= result;
+    con->command= result->stmt ? DRIZZLE_COMMAND_STMT_EXECUTE
+                               : DRIZZLE_COMMAND_QUERY;
+    con->packet_number= 1;
+    con->state.pipeline_read= true;
+
+    con->push_state(drizzle_state_result_read);
+    con->push_state(drizzle_state_packet_read);
+  }
+
+  *ret_ptr= drizzle_state_loop(con);
+  if (*ret_ptr != DRIZZLE_RETURN_OK && *ret_ptr != DRIZZLE_RETURN_ERROR_CODE)
+  {
+    return NULL;
+  }
+
+  result= con->pipeline_head;
+  con->state.pipeline_read= false;
+  con->pipeline_pending--;
+  con->pipeline_head= _pipeline_next(con, result);
+  result->pipelined= false;
+
+  if (result->stmt != NULL)
+  {
+    drizzle_stmt_st *stmt= result->stmt;
+    result->stmt= NULL;
+    *ret_ptr= drizzle_stmt_execute_result(stmt, result, *ret_ptr);
+  }
+
+  return result;
+}
+
+uint32_t drizzle_pipeline_count(const drizzle_st *con)
+{
+  if (con == NULL)
+  {
+    return 0;
+  }
+
+  return con->pipeline_pending + con->pipeline_sending + con->pipeline_queued;
+}
+
+/*
+ * Local Definitions
+ */
+
+void drizzle_pipeline_reset(drizzle_st *con)
+{
+  uint32_t count= con->pipeline_pending + con->pipeline_sending +
+                  con->pipeline_queued;
+  drizzle_result_st *result= con->pipeline_head;
+
+  while (count--)
+  {
+    drizzle_result_st *newer= _pipeline_next(con, result);
+    if (con->result == result)
+    {
+      con->result= NULL;
+    }
+    drizzle_result_free(result);
+    result= newer;
+  }
+
+  con->pipeline_head= NULL;
+  con->pipeline_pending= 0;
+  con->pipeline_sending= 0;
+  con->pipeline_queued= 0;
+  con->pipeline_size= 0;
+  con->pipeline_sent= 0;
+  con->state.pipeline_write= false;
+  con->state.pipeline_read= false;
+}
+
+void drizzle_pipeline_free(drizzle_st *con)
+{
+  free(con->pipeline_buffer);
+  con->pipeline_buffer= NULL;
+  con->pipeline_allocation= 0;
+}
@@ -37,84 +37,39 @@
 
 #pragma once
 
-#define LIBDRIZZLE_LIST_ADD(__list, __obj) { \
-  if (__list ## _list != NULL) \
-    __list ## _list->prev= __obj; \
-  __obj->next= __list ## _list; \
-  __obj->prev= NULL; \
-  __list ## _list= __obj; \
-  __list ## _count++; \
-}
-
-#define LIBDRIZZLE_LIST_DEL(__list, __obj) { \
-  if (__list ## _list == __obj) \
-    __list ## _list= __obj->next; \
-  if (__obj->prev != NULL) \
-    __obj->prev->next= __obj->next; \
-  if (__obj->next != NULL) \
-    __obj->next->prev= __obj->prev; \
-  __list ## _count--; \
-}
-
-class Packet {
-public:
-  Packet():
-    _stack(true),
-    _drizzle(NULL),
-    _func(NULL),
-    next(NULL),
-    prev(NULL)
-  {
-  }
-
-  Packet(drizzle_st* drizzle_, drizzle_state_fn *func_):
-    _stack(false),
-    _drizzle(drizzle_),
-    _func(func_),
-    next(NULL),
-    prev(NULL)
-  {
-  }
-
-  ~Packet()
-  {
-  }
-
-  void init(drizzle_st* drizzle_)
-  {
-    _drizzle= drizzle_;
-  }
+/**
+ * @file
+ * @brief Local Pipeline Declarations
+ */
 
-  void clear()
-  {
-    _func= NULL;
-  }
+#ifdef __cplusplus
+extern "C" {
+#endif
 
-  bool stack() const
-  {
-    return _stack;
-  }
+/**
+ * @addtogroup drizzle_pipeline_local Local Pipeline Declarations
+ * @ingroup drizzle_pipeline
+ * @{
+ */
 
-  void func(drizzle_state_fn* func_)
-  {
-    _func= func_;
-  }
+/**
+ * Drop every pipelined command and free the results that were not returned
+ * yet. Used when the connection is closed, since the server will not answer
+ * them anymore.
+ *
+ * @param[in] con Connection structure.
+ */
+void drizzle_pipeline_reset(drizzle_st *con);
 
-  drizzle_return_t func()
-  {
-    assert(_drizzle);
-    if (_func)
-    {
-      return _func(_drizzle);
-    }
+/**
+ * Release the memory used for queued commands.
+ *
+ * @param[in] con Connection structure.
+ */
+void drizzle_pipeline_free(drizzle_st *con);
 
-    return DRIZZLE_RETURN_INVALID_ARGUMENT;
-  }
+/** @} */
 
-public:
-  const bool _stack;
-  drizzle_st* _drizzle;
-  drizzle_state_fn *_func;
-  Packet *next;
-  Packet *prev;
-};
+#ifdef __cplusplus
+}
+#endif
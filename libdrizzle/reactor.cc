@@ -0,0 +1,703 @@
+/* vim:expandtab:shiftwidth=2:tabstop=2:smarttab:
+ *
+ * Drizzle Client & Protocol Library
+ *
+ * Copyright (C) 2012-2013 Drizzle Developer Group
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following disclaimer
+ * in the documentation and/or other materials provided with the
+ * distribution.
+ *
+ *     * The names of its contributors may not be used to endorse or
+ * promote products derived from this software without specific prior
+ * written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/**
+ * @file
+ * @brief Reactor Definitions
+ */
+
+#include "config.h"
+#include "libdrizzle/common.h"
+
+#include <limits.h>
+
+#if defined(HAVE_SYS_EPOLL_H) && HAVE_SYS_EPOLL_H
+# include <sys/epoll.h>
+# include <time.h>
+# define DRIZZLE_REACTOR_EPOLL 1
+#endif
+
+/* User data of the shared ring operations that are not connection reads,
+   which carry the connection pointer. */
+#define DRIZZLE_REACTOR_URING_EPOLL 1
+#define DRIZZLE_REACTOR_URING_CANCEL 2
+
+/**
+ * @addtogroup drizzle_reactor_static Static Reactor Declarations
+ * @ingroup drizzle_reactor
+ * @{
+ */
+
+/**
+ * Make sure the reactor event array holds at least size entries.
+ *
+ * @param[in] reactor A reactor object
+ * @param[in] size Number of entries needed
+ * @param[in] entry_size Size of one entry in bytes
+ * @return true on success, false if the allocation failed.
+ */
+static bool _reserve_events(drizzle_reactor_st *reactor, size_t size,
+                            size_t entry_size)
+{
+  if (size <= reactor->event_allocation)
+  {
+    return true;
+  }
+
+  void *events= realloc(reactor->events, size * entry_size);
+  if (events == NULL)
+  {
+    return false;
+  }
+
+  reactor->events= events;
+  reactor->event_allocation= size;
+
+  return true;
+}
+
+#ifdef DRIZZLE_REACTOR_EPOLL
+/**
+ * Collect the connections epoll reports as ready.
+ *
+ * @param[in] reactor A reactor object
+ * @param[out] ready Array receiving the connections that are ready for I/O.
+ * @param[in] ready_size Number of entries in ready.
+ * @param[in] timeout Timeout in milliseconds, or -1 to wait forever.
+ * @param[out] ret_ptr Standard drizzle return value, only set on errors.
+ * @return Number of connections stored in ready.
+ */
+static size_t _epoll_collect(drizzle_reactor_st *reactor,
+                             drizzle_st **ready, size_t ready_size,
+                             int timeout, drizzle_return_t *ret_ptr)
+{
+  size_t count= 0;
+
+  if (ready_size > INT_MAX)
+  {
+    ready_size= INT_MAX;
+  }
+
+  if (_reserve_events(reactor, ready_size, sizeof(struct epoll_event)) == false)
+  {
+    *ret_ptr= DRIZZLE_RETURN_MEMORY;
+    return 0;
+  }
+
+  struct epoll_event *events= (struct epoll_event *)reactor->events;
+  int ret;
+  do
+  {
+    ret= epoll_wait(reactor->epoll_fd, events, (int)ready_size, timeout);
+  } while (ret == -1 && errno == EINTR);
+
+  if (ret == -1)
+  {
+    *ret_ptr= DRIZZLE_RETURN_ERRNO;
+    return 0;
+  }
+
+  for (int x= 0; x < ret; x++)
+  {
+    drizzle_st *con= (drizzle_st *)events[x].data.ptr;
+    short revents= 0;
+
+    /* The ring owns the socket until the read queued on it completes. */
+    if (con->uring_reading || con->uring_read_done)
+    {
+      continue;
+    }
+
+    if (events[x].events & EPOLLIN)
+    {
+      revents|= POLLIN;
+    }
+    if (events[x].events & EPOLLOUT)
+    {
+      revents|= POLLOUT;
+    }
+    if (events[x].events & EPOLLERR)
+    {
+      revents|= POLLERR;
+    }
+    if (events[x].events & EPOLLHUP)
+    {
+      revents|= POLLHUP;
+    }
+
+    if (drizzle_set_revents(con, revents) == DRIZZLE_RETURN_OK)
+    {
+      ready[count++]= con;
+    }
+  }
+
+  return count;
+}
+
+/**
+ * Queue the read a connection is about to wait for on the shared ring of
+ * its reactor, into the free part of the connection buffer.
+ *
+ * @param[in] con Connection structure registered with a reactor.
+ * @return true if the ring takes care of the read, false if the connection
+ *  waits for POLLIN through epoll.
+ */
+static bool _uring_read(drizzle_st *con)
+{
+  drizzle_reactor_st *reactor= con->reactor;
+  drizzle_uring_st *ring= reactor->uring;
+
+  if (ring == NULL || con->options.io_uring == false ||
+      con->options.non_blocking == false || con->events != POLLIN ||
+      con->uring != NULL || con->compress != NULL || con->buffer == NULL ||
+      con->ssl_state != DRIZZLE_SSL_STATE_NONE)
+  {
+    return false;
+  }
+
+  if (con->uring_reading || con->uring_read_done)
+  {
+    return true;
+  }
+
+  /* Leave room in the completion queue for the epoll poll and a cancel. */
+  size_t available= drizzle_buffer_available(con);
+  if (available == 0 || reactor->uring_reads + 2 >= ring->cq_entries)
+  {
+    return false;
+  }
+
+  /* Every connection with a read in flight may end up in the ready list. */
+  if (reactor->uring_reads + reactor->uring_ready_count == reactor->uring_ready_allocation)
+  {
+    size_t allocation= reactor->uring_ready_allocation ? reactor->uring_ready_allocation * 2 : 16;
+    drizzle_st **uring_ready= (drizzle_st **)realloc(reactor->uring_ready,
+                                                     allocation * sizeof(drizzle_st *));
+    if (uring_ready == NULL)
+    {
+      return false;
+    }
+    reactor->uring_ready= uring_ready;
+    reactor->uring_ready_allocation= allocation;
+  }
+
+  if (drizzle_uring_queue_recv(ring, con->fd, con->buffer_ptr + con->buffer_size,
+                               available, (uint64_t)(uintptr_t)con) == false)
+  {
+    drizzle_log_debug(con, "io_uring read not queued: %s", strerror(errno));
+    return false;
+  }
+
+  con->uring_reading= true;
+  reactor->uring_reads++;
+
+  return true;
+}
+
+/**
+ * Take every completion off the shared ring. Connections whose read
+ * completed go to the ready list of the reactor.
+ *
+ * @param[in] reactor A reactor object with a ring.
+ */
+static void _uring_reap(drizzle_reactor_st *reactor)
+{
+  uint64_t user_data;
+  int32_t res;
+
+  while (drizzle_uring_reap(reactor->uring, &user_data, &res))
+  {
+    if (user_data == DRIZZLE_REACTOR_URING_EPOLL)
+    {
+      reactor->uring_epoll_armed= false;
+      continue;
+    }
+
+    if (user_data == DRIZZLE_REACTOR_URING_CANCEL)
+    {
+      continue;
+    }
+
+    drizzle_st *con= (drizzle_st *)(uintptr_t)user_data;
+    con->uring_reading= false;
+    con->uring_read_done= true;
+    con->uring_read_result= res;
+    reactor->uring_reads--;
+    reactor->uring_ready[reactor->uring_ready_count++]= con;
+  }
+}
+
+/**
+ * Wait for I/O through the shared ring: the completed reads of the
+ * io_uring connections, and the epoll set of the others, polled through the
+ * ring so that one io_uring_enter() covers both.
+ *
+ * @param[in] reactor A reactor object with a ring.
+ * @param[out] ready Array receiving the connections that are ready for I/O.
+ * @param[in] ready_size Number of entries in ready.
+ * @param[in] timeout Timeout in milliseconds, or -1 to wait forever.
+ * @param[out] ret_ptr Standard drizzle return value.
+ * @return Number of connections stored in ready.
+ */
+static size_t _uring_wait(drizzle_reactor_st *reactor,
+                          drizzle_st **ready, size_t ready_size,
+                          int timeout, drizzle_return_t *ret_ptr)
+{
+  struct timespec deadline;
+  size_t count= 0;
+
+  if (timeout > 0)
+  {
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    deadline.tv_sec+= timeout / 1000;
+    deadline.tv_nsec+= (timeout % 1000) * 1000000;
+  }
+
+  while (1)
+  {
+    _uring_reap(reactor);
+
+    while (count < ready_size && reactor->uring_ready_count != 0)
+    {
+      drizzle_st *con= reactor->uring_ready[--reactor->uring_ready_count];
+      if (drizzle_set_revents(con, POLLIN) == DRIZZLE_RETURN_OK)
+      {
+        ready[count++]= con;
+      }
+    }
+
+    /* The epoll set is only looked at once the ring found it readable. */
+    if (reactor->uring_epoll_armed == false && count < ready_size)
+    {
+      drizzle_return_t ret= DRIZZLE_RETURN_OK;
+      count+= _epoll_collect(reactor, ready + count, ready_size - count, 0, &ret);
+      if (ret != DRIZZLE_RETURN_OK)
+      {
+        *ret_ptr= ret;
+        return count;
+      }
+    }
+
+    if (count != 0)
+    {
+      *ret_ptr= DRIZZLE_RETURN_OK;
+      return count;
+    }
+
+    if (reactor->uring_epoll_armed == false)
+    {
+      if (drizzle_uring_queue_poll(reactor->uring, reactor->epoll_fd,
+                                   DRIZZLE_REACTOR_URING_EPOLL) == false)
+      {
+        *ret_ptr= DRIZZLE_RETURN_ERRNO;
+        return 0;
+      }
+      reactor->uring_epoll_armed= true;
+    }
+
+    if (timeout > 0)
+    {
+      struct timespec now;
+      clock_gettime(CLOCK_MONOTONIC, &now);
+      int64_t remaining= (int64_t)(deadline.tv_sec - now.tv_sec) * 1000 +
+                         (deadline.tv_nsec - now.tv_nsec) / 1000000;
+      timeout= remaining > 0 ? (int)remaining : 0;
+    }
+
+    if (drizzle_uring_wait(reactor->uring, timeout) == -1)
+    {
+      if (errno == ETIME)
+      {
+        *ret_ptr= DRIZZLE_RETURN_TIMEOUT;
+        return 0;
+      }
+      if (errno != EINTR)
+      {
+        *ret_ptr= DRIZZLE_RETURN_ERRNO;
+        return 0;
+      }
+    }
+  }
+}
+
+/**
+ * Take back the read a connection queued on the shared ring, and drop a
+ * completed read that was not consumed.
+ *
+ * @param[in] con Connection structure registered with a reactor.
+ */
+static void _uring_cancel(drizzle_st *con)
+{
+  drizzle_reactor_st *reactor= con->reactor;
+
+  if (con->uring_reading)
+  {
+    if (drizzle_uring_queue_cancel(reactor->uring, (uint64_t)(uintptr_t)con,
+                                   DRIZZLE_REACTOR_URING_CANCEL) == false)
+    {
+      /* A read that cannot be cancelled ends with the socket. */
+      (void)shutdown(con->fd, SHUT_RD);
+    }
+
+    /* The kernel writes into the connection buffer until the read completes. */
+    while (con->uring_reading)
+    {
+      if (drizzle_uring_wait(reactor->uring, -1) == -1 && errno != EINTR)
+      {
+        break;
+      }
+      _uring_reap(reactor);
+    }
+  }
+
+  for (size_t x= 0; x < reactor->uring_ready_count; x++)
+  {
+    if (reactor->uring_ready[x] == con)
+    {
+      reactor->uring_ready[x]= reactor->uring_ready[--reactor->uring_ready_count];
+      break;
+    }
+  }
+
+  con->uring_read_done= false;
+}
+#endif
+
+/** @} */
+
+/*
+ * Common Definitions
+ */
+
+drizzle_reactor_st *drizzle_reactor_create(void)
+{
+  drizzle_reactor_st *reactor= new (std::nothrow) drizzle_reactor_st;
+  if (reactor == NULL)
+  {
+    return NULL;
+  }
+
+#ifdef DRIZZLE_REACTOR_EPOLL
+  reactor->epoll_fd= epoll_create1(EPOLL_CLOEXEC);
+  if (reactor->epoll_fd == -1)
+  {
+    delete reactor;
+    return NULL;
+  }
+#endif
+
+  return reactor;
+}
+
+void drizzle_reactor_free(drizzle_reactor_st *reactor)
+{
+  if (reactor == NULL)
+  {
+    return;
+  }
+
+  while (reactor->connection_count)
+  {
+    drizzle_reactor_remove(reactor, reactor->connections[reactor->connection_count - 1]);
+  }
+
+  /* Closing the ring also cancels the poll of the epoll set. */
+  drizzle_uring_shared_free(reactor->uring);
+
+#ifdef DRIZZLE_REACTOR_EPOLL
+  close(reactor->epoll_fd);
+#endif
+
+  free(reactor->uring_ready);
+  free(reactor->connections);
+  free(reactor->events);
+  delete reactor;
+}
+
+drizzle_return_t drizzle_reactor_add(drizzle_reactor_st *reactor,
+                                     drizzle_st *con)
+{
+  if (reactor == NULL || con == NULL || con->reactor != NULL)
+  {
+    return DRIZZLE_RETURN_INVALID_ARGUMENT;
+  }
+
+  if (reactor->connection_count == reactor->connection_allocation)
+  {
+    size_t allocation= reactor->connection_allocation ? reactor->connection_allocation * 2 : 16;
+    drizzle_st **connections= (drizzle_st **)realloc(reactor->connections,
+                                                     allocation * sizeof(drizzle_st *));
+    if (connections == NULL)
+    {
+      drizzle_set_error(con, __func__, "Failed to allocate memory for reactor");
+      return DRIZZLE_RETURN_MEMORY;
+    }
+    reactor->connections= connections;
+    reactor->connection_allocation= allocation;
+  }
+
+#ifdef DRIZZLE_REACTOR_EPOLL
+  if (con->options.io_uring && reactor->uring == NULL)
+  {
+    reactor->uring= drizzle_uring_shared_create();
+    if (reactor->uring == NULL)
+    {
+      drizzle_log_debug(con, "io_uring unavailable: %s", strerror(errno));
+    }
+  }
+#endif
+
+  con->reactor= reactor;
+  con->reactor_index= reactor->connection_count;
+  con->reactor_fd= INVALID_SOCKET;
+  con->reactor_events= 0;
+  reactor->connections[reactor->connection_count++]= con;
+
+  /* A connection that is already waiting for I/O is registered right away. */
+  if (con->events != 0)
+  {
+    drizzle_return_t ret= drizzle_reactor_update(con);
+    if (ret != DRIZZLE_RETURN_OK)
+    {
+      drizzle_reactor_remove(reactor, con);
+      return ret;
+    }
+  }
+
+  return DRIZZLE_RETURN_OK;
+}
+
+drizzle_return_t drizzle_reactor_remove(drizzle_reactor_st *reactor,
+                                        drizzle_st *con)
+{
+  if (reactor == NULL || con == NULL || con->reactor != reactor)
+  {
+    return DRIZZLE_RETURN_INVALID_ARGUMENT;
+  }
+
+  drizzle_reactor_reset(con);
+
+  /* Move the last connection into the free slot. */
+  drizzle_st *last= reactor->connections[--reactor->connection_count];
+  reactor->connections[con->reactor_index]= last;
+  last->reactor_index= con->reactor_index;
+
+  con->reactor= NULL;
+  con->reactor_index= 0;
+
+  return DRIZZLE_RETURN_OK;
+}
+
+size_t drizzle_reactor_wait(drizzle_reactor_st *reactor,
+                            drizzle_st **ready, size_t ready_size,
+                            int timeout, drizzle_return_t *ret_ptr)
+{
+  drizzle_return_t unused;
+  if (ret_ptr == NULL)
+  {
+    ret_ptr= &unused;
+  }
+
+  if (reactor == NULL || ready == NULL || ready_size == 0)
+  {
+    *ret_ptr= DRIZZLE_RETURN_INVALID_ARGUMENT;
+    return 0;
+  }
+
+  if (reactor->connection_count == 0)
+  {
+    *ret_ptr= DRIZZLE_RETURN_NO_ACTIVE_CONNECTIONS;
+    return 0;
+  }
+
+  size_t count= 0;
+
+#ifdef DRIZZLE_REACTOR_EPOLL
+  if (reactor->uring != NULL)
+  {
+    return _uring_wait(reactor, ready, ready_size, timeout, ret_ptr);
+  }
+
+  drizzle_return_t ret= DRIZZLE_RETURN_OK;
+  count= _epoll_collect(reactor, ready, ready_size, timeout, &ret);
+  if (ret != DRIZZLE_RETURN_OK)
+  {
+    *ret_ptr= ret;
+    return 0;
+  }
+#else
+  if (_reserve_events(reactor, reactor->connection_count, sizeof(pollfd_t)) == false)
+  {
+    *ret_ptr= DRIZZLE_RETURN_MEMORY;
+    return 0;
+  }
+
+  pollfd_t *pfds= (pollfd_t *)reactor->events;
+  drizzle_st **connections= reactor->connections;
+  nfds_t nfds= 0;
+  for (size_t x= 0; x < reactor->connection_count; x++)
+  {
+    if (connections[x]->fd == INVALID_SOCKET || connections[x]->events == 0)
+    {
+      continue;
+    }
+    pfds[nfds].fd= connections[x]->fd;
+    pfds[nfds].events= connections[x]->events;
+    pfds[nfds].revents= 0;
+    nfds++;
+  }
+
+  if (nfds == 0)
+  {
+    *ret_ptr= DRIZZLE_RETURN_NO_ACTIVE_CONNECTIONS;
+    return 0;
+  }
+
+  int ret;
+  do
+  {
+    ret= poll(pfds, nfds, timeout);
+  } while (ret == -1 && errno == EINTR);
+
+  if (ret == -1)
+  {
+    *ret_ptr= DRIZZLE_RETURN_ERRNO;
+    return 0;
+  }
+
+  /* The descriptors were collected in connection order, walk both again. */
+  nfds_t y= 0;
+  for (size_t x= 0; x < reactor->connection_count && count < ready_size && ret > 0; x++)
+  {
+    drizzle_st *con= connections[x];
+    if (con->fd == INVALID_SOCKET || con->events == 0)
+    {
+      continue;
+    }
+
+    if (pfds[y].revents != 0)
+    {
+      ret--;
+      if (drizzle_set_revents(con, pfds[y].revents) == DRIZZLE_RETURN_OK)
+      {
+        ready[count++]= con;
+      }
+    }
+    y++;
+  }
+#endif
+
+  *ret_ptr= count ? DRIZZLE_RETURN_OK : DRIZZLE_RETURN_TIMEOUT;
+
+  return count;
+}
+
+/*
+ * Local Definitions
+ */
+
+drizzle_return_t drizzle_reactor_update(drizzle_st *con)
+{
+  if (con->fd == INVALID_SOCKET)
+  {
+    return DRIZZLE_RETURN_OK;
+  }
+
+#ifdef DRIZZLE_REACTOR_EPOLL
+  if (_uring_read(con))
+  {
+    return DRIZZLE_RETURN_OK;
+  }
+
+  int op;
+  if (con->reactor_fd != con->fd)
+  {
+    op= EPOLL_CTL_ADD;
+  }
+  else if ((con->reactor_events | con->events) == con->reactor_events)
+  {
+    return DRIZZLE_RETURN_OK;
+  }
+  else
+  {
+    op= EPOLL_CTL_MOD;
+  }
+
+  struct epoll_event event;
+  memset(&event, 0, sizeof(event));
+  event.events= EPOLLET;
+  if (con->events & POLLIN)
+  {
+    event.events|= EPOLLIN;
+  }
+  if (con->events & POLLOUT)
+  {
+    event.events|= EPOLLOUT;
+  }
+  event.data.ptr= con;
+
+  if (epoll_ctl(con->reactor->epoll_fd, op, con->fd, &event) == -1)
+  {
+    drizzle_set_error(con, __func__, "epoll_ctl:%s", strerror(errno));
+    con->last_errno= errno;
+    return DRIZZLE_RETURN_ERRNO;
+  }
+#endif
+
+  con->reactor_fd= con->fd;
+  con->reactor_events= con->events;
+
+  return DRIZZLE_RETURN_OK;
+}
+
+void drizzle_reactor_reset(drizzle_st *con)
+{
+#ifdef DRIZZLE_REACTOR_EPOLL
+  if (con->reactor->uring != NULL)
+  {
+    _uring_cancel(con);
+  }
+
+  if (con->reactor_fd != INVALID_SOCKET && con->reactor_fd == con->fd)
+  {
+    (void)epoll_ctl(con->reactor->epoll_fd, EPOLL_CTL_DEL, con->reactor_fd, NULL);
+  }
+#endif
+
+  con->reactor_fd= INVALID_SOCKET;
+  con->reactor_events= 0;
+}
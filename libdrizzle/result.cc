@@ -44,6 +44,63 @@
 #include "config.h"
 #include "libdrizzle/common.h"
 
+/* Rows the lists of a buffered result first have room for, they double
+   whenever they fill up. */
+#define DRIZZLE_ROW_LIST_SIZE 64
+
+/**
+ * @addtogroup drizzle_result_static Static Result Declarations
+ * @ingroup drizzle_result
+ * @{
+ */
+
+/**
+ * Double the room of the row lists of a result that is being buffered.
+ *
+ * @param[in,out] result The result being buffered
+ * @return Standard drizzle return value.
+ */
+static drizzle_return_t _row_list_grow(drizzle_result_st *result)
+{
+  uint64_t rows= result->row_list_size ? result->row_list_size * 2
+                                       : DRIZZLE_ROW_LIST_SIZE;
+
+  drizzle_field_t *row_list= (drizzle_field_t *)realloc(result->row_list,
+                               sizeof(drizzle_field_t) * rows * result->column_count);
+  if (row_list == NULL)
+  {
+    drizzle_set_error(result->con, __func__, "Failed to realloc row_list.");
+    return DRIZZLE_RETURN_MEMORY;
+  }
+  result->row_list= row_list;
+
+  size_t *field_sizes_list= (size_t *)realloc(result->field_sizes_list,
+                              sizeof(size_t) * rows * result->column_count);
+  if (field_sizes_list == NULL)
+  {
+    drizzle_set_error(result->con, __func__, "Failed to realloc field list.");
+    return DRIZZLE_RETURN_MEMORY;
+  }
+  result->field_sizes_list= field_sizes_list;
+
+  if (result->binary_rows)
+  {
+    uint8_t *null_bitmap_list= (uint8_t *)realloc(result->null_bitmap_list,
+                                 rows * result->null_bitmap_length);
+    if (null_bitmap_list == NULL)
+    {
+      drizzle_set_error(result->con, __func__, "Failed to realloc null_bitmap_list.");
+      return DRIZZLE_RETURN_MEMORY;
+    }
+    result->null_bitmap_list= null_bitmap_list;
+  }
+
+  result->row_list_size= rows;
+  return DRIZZLE_RETURN_OK;
+}
+
+/** @} */
+
 /*
  * Common definitions
  */
@@ -64,6 +121,7 @@ drizzle_result_st *drizzle_result_create(drizzle_st *con)
   }
 
   result->con= con;
+  result->column_arena.slab_size= DRIZZLE_COLUMN_ARENA_SLAB_SIZE;
   con->result= result;
 
   if (con->result_list)
@@ -75,6 +133,14 @@ drizzle_result_st *drizzle_result_create(drizzle_st *con)
   return result;
 }
 
+void drizzle_result_set_more_results(drizzle_result_st *result)
+{
+  if (result->con->status & DRIZZLE_CON_STATUS_MORE_RESULTS_EXISTS)
+  {
+    result->options = (drizzle_result_options_t)((int)result->options | (int)DRIZZLE_RESULT_MORE_RESULTS);
+  }
+}
+
 void drizzle_result_free(drizzle_result_st *result)
 {
   drizzle_column_st* column;
@@ -91,30 +157,22 @@ void drizzle_result_free(drizzle_result_st *result)
   }
 
   delete[] result->column_buffer;
+  drizzle_arena_free(&result->column_arena);
+  delete[] result->column_hash;
 
-  if (result->options & DRIZZLE_RESULT_BUFFER_ROW)
-  {
-    uint64_t x;
+  /* Field data of buffered rows lives in the arena, the rest in the row
+     lists. */
+  drizzle_arena_free(&result->row_arena);
+  free(result->null_bitmap_list);
+  free(result->row_list);
+  free(result->field_sizes_list);
+  drizzle_columnar_free(result);
 
-    for (x= 0; x < result->row_count; x++)
-    {
-      for (y= 0; y < (result->column_count - result->null_bitcount); y++)
-      {
-        delete[] result->row_list[x][y];
-      }
-      delete[] result->row_list[x];
-      if (result->null_bitmap_list != NULL)
-      {
-        delete[] result->null_bitmap_list[x];
-      }
-      delete[] result->field_sizes_list[x];
-    }
-    if (result->null_bitmap_list != NULL)
-    {
-      free(result->null_bitmap_list);
-    }
-    free(result->row_list);
-    free(result->field_sizes_list);
+  /* Otherwise these are the scratch arrays of drizzle_row_buffer(). */
+  if (!(result->options & DRIZZLE_RESULT_BUFFER_ROW))
+  {
+    delete[] result->field_sizes;
+    delete[] result->null_bitmap;
   }
 
   if (result->field_buffer)
@@ -133,6 +191,14 @@ void drizzle_result_free(drizzle_result_st *result)
     result->con->result_count--;
     if (result->con->result_list == result)
       result->con->result_list= result->next;
+
+    /* has_state() is true for an empty state stack: a connection that is
+       not in the middle of a command has nothing left to read into a buffer
+       grown for this result. */
+    if (result->con->has_state())
+    {
+      drizzle_buffer_shrink(result->con);
+    }
   }
 
   if (result->prev)
@@ -296,6 +362,57 @@ drizzle_result_st *drizzle_result_read(drizzle_st *con,
   return con->result;
 }
 
+drizzle_result_st *drizzle_result_next(drizzle_result_st *result,
+                                       drizzle_return_t *ret_ptr)
+{
+  drizzle_return_t unused;
+  if (ret_ptr == NULL)
+  {
+    ret_ptr= &unused;
+  }
+
+  if (result == NULL)
+  {
+    *ret_ptr= DRIZZLE_RETURN_INVALID_ARGUMENT;
+    return NULL;
+  }
+
+  drizzle_st *con= result->con;
+
+  /* Resume a read of the next result interrupted by DRIZZLE_RETURN_IO_WAIT. */
+  if (!con->has_state() && con->result != result)
+  {
+    *ret_ptr= drizzle_state_loop(con);
+    return con->result;
+  }
+
+  if (!(result->options & DRIZZLE_RESULT_MORE_RESULTS))
+  {
+    if (con->result == result && result->column_count > 0 &&
+        result->row_eof == false)
+    {
+      drizzle_set_error(con, __func__,
+                        "rows of the current result have not been read");
+      *ret_ptr= DRIZZLE_RETURN_NOT_READY;
+      return NULL;
+    }
+
+    *ret_ptr= DRIZZLE_RETURN_OK;
+    return NULL;
+  }
+
+  if (!con->has_state())
+  {
+    drizzle_set_error(con, __func__, "connection is busy");
+    *ret_ptr= DRIZZLE_RETURN_NOT_READY;
+    return NULL;
+  }
+
+  /* The next result continues the response, so the packet sequence is kept. */
+  result->options = (drizzle_result_options_t)((int)result->options & (int)~DRIZZLE_RESULT_MORE_RESULTS);
+  return drizzle_result_read(con, ret_ptr);
+}
+
 drizzle_return_t drizzle_result_buffer(drizzle_result_st *result)
 {
   if (result == NULL)
@@ -305,8 +422,12 @@ drizzle_return_t drizzle_result_buffer(drizzle_result_st *result)
 
   drizzle_return_t ret;
   drizzle_row_t row;
-  drizzle_row_t *row_list;
-  size_t **field_sizes_list;
+
+  if (result->options & DRIZZLE_RESULT_BUFFER_COLUMNAR)
+  {
+    drizzle_set_error(result->con, __func__, "rows have already been buffered by column");
+    return DRIZZLE_RETURN_UNEXPECTED_DATA;
+  }
 
   if (!(result->options & DRIZZLE_RESULT_BUFFER_COLUMN))
   {
@@ -333,58 +454,54 @@ drizzle_return_t drizzle_result_buffer(drizzle_result_st *result)
 
     if (result->row_list_size < result->row_count)
     {
-      size_t new_row_list_size = result->row_list_size + DRIZZLE_ROW_GROW_SIZE;
-
-      row_list= (drizzle_row_t *)realloc(result->row_list, sizeof(drizzle_row_t) * new_row_list_size);
-      if (row_list == NULL)
+      ret= _row_list_grow(result);
+      if (ret != DRIZZLE_RETURN_OK)
       {
         drizzle_row_free(result, row);
-        drizzle_set_error(result->con, __func__, "Failed to realloc row_list.");
-        return DRIZZLE_RETURN_MEMORY;
+        return ret;
       }
-      result->row_list= row_list;
-
-      if (result->binary_rows)
-      {
-        uint8_t **null_bitmap_list= (uint8_t **)realloc(result->null_bitmap_list, sizeof(uint8_t *) * new_row_list_size);
-        if (null_bitmap_list == NULL)
-        {
-          drizzle_row_free(result, row);
-          drizzle_set_error(result->con, __func__, "Failed to realloc null_bitmap_list.");
-          return DRIZZLE_RETURN_MEMORY;
-        }
-        result->null_bitmap_list= null_bitmap_list;
-      }
-
-      field_sizes_list= (size_t **)realloc(result->field_sizes_list, sizeof(size_t *) * new_row_list_size);
-      if (field_sizes_list == NULL)
-      {
-        drizzle_row_free(result, row);
-        drizzle_set_error(result->con, "drizzle_result_buffer", "Failed to realloc field list.");
-        return DRIZZLE_RETURN_MEMORY;
-      }
-      result->field_sizes_list= field_sizes_list;
-
-      result->row_list_size= new_row_list_size;
     }
 
+    /* Copy the row out of the scratch arrays drizzle_row_buffer() reuses
+       for the next one. */
+    size_t first= (size_t)(result->row_current - 1) * result->column_count;
+    drizzle_row_t row_copy= result->row_list + first;
+
     if (result->binary_rows)
     {
-      result->null_bitmap_list[result->row_current - 1]= result->null_bitmap;
+      memcpy(result->null_bitmap_list +
+             (size_t)(result->row_current - 1) * result->null_bitmap_length,
+             result->null_bitmap, result->null_bitmap_length);
     }
 
-    result->row_list[result->row_current - 1]= new drizzle_field_t[result->column_count]();
     for (x= 0; x < result->column_count; x++)
     {
+      row_copy[x]= NULL;
       if (result->field_sizes[x] > 0)
       {
-        result->row_list[result->row_current - 1][x]= new char[result->field_sizes[x]+1]();
-        memcpy(result->row_list[result->row_current - 1][x], row[x], result->field_sizes[x]);
+        row_copy[x]= (drizzle_field_t)drizzle_arena_alloc(&result->row_arena,
+                                                          result->field_sizes[x] + 1);
+        if (row_copy[x] == NULL)
+        {
+          drizzle_set_error(result->con, __func__, "Failed to allocate.");
+          return DRIZZLE_RETURN_MEMORY;
+        }
+        memcpy(row_copy[x], row[x], result->field_sizes[x]);
+        row_copy[x][result->field_sizes[x]]= 0;
       }
     }
-    result->field_sizes_list[result->row_current - 1]= result->field_sizes;
+    memcpy(result->field_sizes_list + first, result->field_sizes,
+           sizeof(size_t) * result->column_count);
   }
 
+  /* From now on field_sizes and null_bitmap point into the row lists. */
+  delete[] result->row;
+  result->row= NULL;
+  delete[] result->field_sizes;
+  result->field_sizes= NULL;
+  delete[] result->null_bitmap;
+  result->null_bitmap= NULL;
+
   result->options = (drizzle_result_options_t)((int)result->options | (int)DRIZZLE_RESULT_BUFFER_ROW);
   return DRIZZLE_RETURN_OK;
 }
@@ -434,6 +551,11 @@ drizzle_return_t drizzle_state_result_read(drizzle_st *con)
       con->buffer_ptr+= 11;
       con->buffer_size-= 12;
       con->packet_size-= 12;
+      if ((con->capabilities & DRIZZLE_CAPABILITIES_OPTIONAL_RESULTSET_METADATA) &&
+          con->packet_size > 0 && con->buffer_ptr[0] == 0)
+      {
+        con->result->no_metadata= true;
+      }
     }
     else
     {
@@ -441,6 +563,7 @@ drizzle_return_t drizzle_state_result_read(drizzle_st *con)
       con->result->insert_id= drizzle_unpack_length(con, &ret);
       con->status= (drizzle_status_t)drizzle_get_byte2(con->buffer_ptr);
       con->result->warning_count= drizzle_get_byte2(con->buffer_ptr +2);
+      drizzle_result_set_more_results(con->result);
       con->buffer_ptr+= 4;
       con->buffer_size-= 5;
       con->packet_size-= 5;
@@ -466,6 +589,9 @@ drizzle_return_t drizzle_state_result_read(drizzle_st *con)
   }
   else if (drizzle_check_unpack_error(con))
   {
+    /* An error ends the response, whatever the previous result announced. */
+    con->status= (drizzle_status_t)((int)con->status & (int)~DRIZZLE_CON_STATUS_MORE_RESULTS_EXISTS);
+    con->result->error_code= con->error_code;
     memcpy(con->result->sqlstate, con->sqlstate,
            DRIZZLE_MAX_SQLSTATE_SIZE);
     con->result->sqlstate[DRIZZLE_MAX_SQLSTATE_SIZE]= 0;
@@ -476,13 +602,27 @@ drizzle_return_t drizzle_state_result_read(drizzle_st *con)
     /* We can ignore the return since we've buffered the entire packet. */
     con->result->column_count= (uint16_t)drizzle_unpack_length(con, &ret);
     ret= DRIZZLE_RETURN_OK;
+
+    /* Followed by whether the column definitions are sent. */
+    if ((con->capabilities & DRIZZLE_CAPABILITIES_OPTIONAL_RESULTSET_METADATA) &&
+        con->packet_size > 0)
+    {
+      con->result->no_metadata= (con->buffer_ptr[0] == 0);
+      con->buffer_ptr++;
+      con->buffer_size--;
+      con->packet_size--;
+    }
   }
 
   if (con->packet_size > 0)
   {
-    snprintf(con->last_error, DRIZZLE_MAX_ERROR_SIZE, "%.*s",
-             (int)con->packet_size, con->buffer_ptr);
-    con->last_error[DRIZZLE_MAX_ERROR_SIZE-1]= 0;
+    char *last_error= drizzle_error_buffer(con);
+    if (last_error != NULL)
+    {
+      snprintf(last_error, DRIZZLE_MAX_ERROR_SIZE, "%.*s",
+               (int)con->packet_size, con->buffer_ptr);
+      last_error[DRIZZLE_MAX_ERROR_SIZE-1]= 0;
+    }
     snprintf(con->result->info, DRIZZLE_MAX_INFO_SIZE, "%.*s",
              (int)con->packet_size, con->buffer_ptr);
     con->result->info[DRIZZLE_MAX_INFO_SIZE-1]= 0;
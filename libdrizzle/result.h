@@ -60,6 +60,9 @@ struct drizzle_result_st
   drizzle_column_st *column_list;
   drizzle_column_st *column;
   drizzle_column_st *column_buffer;
+  drizzle_arena_st column_arena;  /* names and default values of columns */
+  uint16_t *column_hash;          /* column index + 1 by name, 0 if empty */
+  uint32_t column_hash_size;      /* slots in column_hash, a power of two */
 
   uint64_t row_count;
   uint64_t row_current;
@@ -68,22 +71,31 @@ struct drizzle_result_st
   uint64_t field_total;           /* total length of the field currently being read */
   uint64_t field_offset;          /* offset within field of most recently read field fragment (0 if first/only fragment) */
   uint32_t field_size;            /* size of most recently read field value or fragment of field value; max 2^24 */
+  uint16_t field_column;          /* column of the next field of a binary row */
   drizzle_field_t field;
   drizzle_field_t *field_buffer;
   size_t *field_buffer_sizes;
 
-  size_t row_list_size;
+  /* Buffered rows one after the other, column_count entries or
+     null_bitmap_length bytes per row, with the field data in row_arena. */
+  uint64_t row_list_size;         /* rows the lists have room for */
   drizzle_row_t row;
-  drizzle_row_t *row_list;
+  drizzle_field_t *row_list;
   size_t *field_sizes;
-  size_t **field_sizes_list;
+  size_t *field_sizes_list;
   drizzle_binlog_st *binlog_event;
   bool binlog_checksums;
-  uint8_t **null_bitmap_list;
+  uint8_t *null_bitmap_list;
+  drizzle_arena_st row_arena;
+  drizzle_columnar_st *columnar;  /* rows buffered by column instead */
   uint8_t *null_bitmap;
   uint16_t null_bitmap_length;
   uint16_t null_bitcount;
   bool binary_rows;
+  drizzle_stmt_st *stmt;          /* statement of a pipelined execute */
+  bool pipelined;                 /* waiting in the pipeline queue */
+  bool row_eof;                   /* the end of the rows has been read */
+  bool no_metadata;               /* the server left out the column definitions */
 
   drizzle_result_st() :
     con(NULL),
@@ -99,12 +111,15 @@ struct drizzle_result_st
     column_list(NULL),
     column(NULL),
     column_buffer(NULL),
+    column_hash(NULL),
+    column_hash_size(0),
     row_count(0),
     row_current(0),
     field_current(0),
     field_total(0),
     field_offset(0),
     field_size(0),
+    field_column(0),
     field(NULL),
     field_buffer(NULL),
     row_list_size(0),
@@ -115,10 +130,15 @@ struct drizzle_result_st
     binlog_event(NULL),
     binlog_checksums(false),
     null_bitmap_list(NULL),
+    columnar(NULL),
     null_bitmap(NULL),
     null_bitmap_length(0),
     null_bitcount(0),
-    binary_rows(false)
+    binary_rows(false),
+    stmt(NULL),
+    pipelined(false),
+    row_eof(false),
+    no_metadata(false)
   {
     info[0]= '\0';
     sqlstate[0]= '\0';
@@ -44,6 +44,392 @@
 #include "config.h"
 #include "libdrizzle/common.h"
 
+/**
+ * @addtogroup drizzle_row_static Static Row Declarations
+ * @ingroup drizzle_row
+ * @{
+ */
+
+/**
+ * Unpack a length encoded integer of a row packet.
+ *
+ * @param[in,out] ptr Position in the packet, moved past the integer.
+ * @param[in] end End of the packet.
+ * @param[out] length The integer.
+ * @return false if the integer does not fit in the packet, or is the NULL
+ *  marker and @p allow_null is not set.
+ */
+static inline bool _row_length(uint8_t **ptr, uint8_t *end,
+                                      uint64_t *length, bool allow_null)
+{
+  uint8_t *p= *ptr;
+  if (p == end)
+  {
+    return false;
+  }
+
+  if (*p < 251)
+  {
+    *length= *p;
+    *ptr= p + 1;
+    return true;
+  }
+
+  switch (*p)
+  {
+  case 251:
+    if (!allow_null)
+    {
+      return false;
+    }
+    *length= UINT64_MAX;
+    *ptr= p + 1;
+    return true;
+
+  case 252:
+    if (end - p < 3)
+    {
+      return false;
+    }
+    *length= drizzle_get_byte2(p + 1);
+    *ptr= p + 3;
+    return true;
+
+  case 253:
+    if (end - p < 4)
+    {
+      return false;
+    }
+    *length= drizzle_get_byte3(p + 1);
+    *ptr= p + 4;
+    return true;
+
+  case 254:
+    if (end - p < 9)
+    {
+      return false;
+    }
+    *length= drizzle_get_byte8(p + 1);
+    *ptr= p + 9;
+    return true;
+
+  default:
+    return false;
+  }
+}
+
+/**
+ * Parse the next row of a result straight out of the receive buffer,
+ * without going through the state machine. Only a row packet that has been
+ * received whole is parsed, anything else is left for the state machine.
+ * The NULL bitmap of a binary row is copied to the result as
+ * drizzle_state_binary_null_read() does.
+ *
+ * @param[in,out] result pointer to the result structure to read from.
+ * @param[out] fields One field per column, pointing into the receive buffer.
+ * @param[out] sizes One field size per column.
+ * @param[out] ret_ptr Standard drizzle return value, only set on errors.
+ * @return true if a row was parsed.
+ */
+static bool _row_parse(drizzle_result_st *result, drizzle_field_t *fields,
+                       size_t *sizes, drizzle_return_t *ret_ptr)
+{
+  drizzle_st *con= result->con;
+
+  /* Only between the rows of the result the connection is reading, a row
+     the state machine has started is finished by it. */
+  if (con->result != result || result->row_eof ||
+      result->column_buffer == NULL || !result->has_state() ||
+      con->packet_size != 0 || con->state.raw_packet || con->buffer_size < 4)
+  {
+    return false;
+  }
+
+  uint32_t packet_size= drizzle_get_byte3(con->buffer_ptr);
+  if (packet_size == 0 || packet_size >= 0xFFFFFF ||
+      con->buffer_size < (size_t)packet_size + 4 ||
+      con->buffer_ptr[3] != con->packet_number ||
+      con->buffer_ptr[4] == 254 || con->buffer_ptr[4] == 255)
+  {
+    /* End of the rows, an error, a row of several packets or one that is
+       not complete, the state machine knows what to do with all of them. */
+    return false;
+  }
+
+  uint8_t *ptr= con->buffer_ptr + 4;
+  uint8_t *end= ptr + packet_size;
+  uint16_t column_count= result->column_count;
+  uint16_t null_count= 0;
+  uint64_t length;
+
+  if (result->binary_rows)
+  {
+    uint16_t bitmap_length= (uint16_t)((column_count + 7 + 2) / 8);
+    if (*ptr != 0 || end - ptr < 1 + bitmap_length)
+    {
+      goto bad_row;
+    }
+
+    if (result->null_bitmap == NULL)
+    {
+      result->null_bitmap= new (std::nothrow) uint8_t[bitmap_length];
+      if (result->null_bitmap == NULL)
+      {
+        drizzle_set_error(con, __func__, "Failed to allocate.");
+        *ret_ptr= DRIZZLE_RETURN_MEMORY;
+        return false;
+      }
+    }
+    result->null_bitmap_length= bitmap_length;
+
+    uint8_t *bitmap= ptr + 1;
+    ptr+= 1 + bitmap_length;
+    for (uint16_t column= 0; column < column_count; column++)
+    {
+      if (bitmap[(column + 2) / 8] & (1 << ((column + 2) % 8)))
+      {
+        fields[column]= NULL;
+        sizes[column]= 0;
+        null_count++;
+        continue;
+      }
+
+      uint32_t size;
+      if (drizzle_column_binary_size(result->column_buffer[column].type,
+                                     &size) != DRIZZLE_RETURN_OK)
+      {
+        /* Leave the error to the state machine. */
+        return false;
+      }
+
+      if (size ||
+          result->column_buffer[column].type == DRIZZLE_COLUMN_TYPE_NULL)
+      {
+        length= size;
+      }
+      else if (!_row_length(&ptr, end, &length, false))
+      {
+        goto bad_row;
+      }
+
+      if ((uint64_t)(end - ptr) < length)
+      {
+        goto bad_row;
+      }
+
+      fields[column]= (drizzle_field_t)ptr;
+      sizes[column]= (size_t)length;
+      ptr+= length;
+    }
+  }
+  else
+  {
+    for (uint16_t column= 0; column < column_count; column++)
+    {
+      if (!_row_length(&ptr, end, &length, true))
+      {
+        goto bad_row;
+      }
+
+      if (length == UINT64_MAX)
+      {
+        fields[column]= NULL;
+        sizes[column]= 0;
+        continue;
+      }
+
+      if ((uint64_t)(end - ptr) < length)
+      {
+        goto bad_row;
+      }
+
+      if (result->column_buffer[column].size < length)
+      {
+        result->column_buffer[column].size= (uint32_t)length;
+      }
+
+      fields[column]= (drizzle_field_t)ptr;
+      sizes[column]= (size_t)length;
+      ptr+= length;
+    }
+  }
+
+  if (ptr != end)
+  {
+    goto bad_row;
+  }
+
+  if (result->binary_rows)
+  {
+    memcpy(result->null_bitmap, con->buffer_ptr + 5, result->null_bitmap_length);
+  }
+
+  con->buffer_ptr+= (size_t)packet_size + 4;
+  con->buffer_size-= (size_t)packet_size + 4;
+  con->packet_number++;
+  con->packet_size= 0;
+
+  result->row_count++;
+  result->row_current++;
+  result->null_bitcount= null_count;
+  result->field_current= (uint16_t)(column_count - null_count);
+  return true;
+
+bad_row:
+  drizzle_set_error(con, __func__, "row does not match its columns");
+  *ret_ptr= DRIZZLE_RETURN_UNEXPECTED_DATA;
+  return false;
+}
+
+/**
+ * Read one row into the row and field size arrays of a result.
+ *
+ * @param[in,out] result pointer to the result structure to read from.
+ * @param[in] view Point the fields into the receive buffer instead of copying
+ *  them when the row is a single packet that has been received whole.
+ * @param[out] ret_ptr Standard drizzle return value.
+ * @return the row that was read, or NULL if there are no more rows.
+ */
+static drizzle_row_t _row_fields(drizzle_result_st *result, bool view,
+                                 drizzle_return_t *ret_ptr)
+{
+  size_t total;
+  uint64_t wire_size;
+  drizzle_field_t field;
+  drizzle_row_t row;
+
+  /* The arrays are reused for every row until the result is freed. */
+  if (result->row == NULL)
+  {
+    result->row= new (std::nothrow) drizzle_field_t[result->column_count];
+    if (result->row == NULL)
+    {
+      drizzle_set_error(result->con, __func__, "Failed to allocate.");
+      *ret_ptr= DRIZZLE_RETURN_MEMORY;
+      return NULL;
+    }
+  }
+
+  if (result->field_sizes == NULL)
+  {
+    result->field_sizes= new (std::nothrow) size_t[result->column_count];
+    if (result->field_sizes == NULL)
+    {
+      drizzle_set_error(result->con, __func__, "Failed to allocate.");
+      *ret_ptr= DRIZZLE_RETURN_MEMORY;
+      return NULL;
+    }
+  }
+
+  /* A row that has been received whole is parsed straight away. */
+  row= result->row;
+  *ret_ptr= DRIZZLE_RETURN_OK;
+  if (_row_parse(result, row, result->field_sizes, ret_ptr))
+  {
+    /* Like the state machine, keep only the fields of binary rows that are
+       not NULL, in order. */
+    uint16_t field_count= result->column_count;
+    if (result->binary_rows)
+    {
+      field_count= 0;
+      for (uint16_t column= 0; column < result->column_count; column++)
+      {
+        if (!(result->null_bitmap[(column + 2) / 8] & (1 << ((column + 2) % 8))))
+        {
+          row[field_count]= row[column];
+          result->field_sizes[field_count]= result->field_sizes[column];
+          field_count++;
+        }
+      }
+
+      for (uint16_t column= field_count; column < result->column_count; column++)
+      {
+        row[column]= NULL;
+        result->field_sizes[column]= 0;
+      }
+    }
+
+    for (uint16_t it= 0; it < field_count && !view; it++)
+    {
+      if (row[it] == NULL)
+      {
+        continue;
+      }
+
+      drizzle_field_t buffer= drizzle_field_buffer_reserve(result, it,
+                                                           result->field_sizes[it],
+                                                           ret_ptr);
+      if (buffer == NULL)
+      {
+        return NULL;
+      }
+
+      memcpy(buffer, row[it], result->field_sizes[it]);
+      buffer[result->field_sizes[it]]= 0;
+      row[it]= buffer;
+    }
+
+    return row;
+  }
+
+  if (*ret_ptr != DRIZZLE_RETURN_OK)
+  {
+    return NULL;
+  }
+
+  if (drizzle_row_read(result, ret_ptr) == 0 || *ret_ptr != DRIZZLE_RETURN_OK)
+  {
+    return NULL;
+  }
+
+  /* Reading the fields of a packet that is already in the buffer never reads
+     from the socket, so nothing moves the bytes the fields point to. A row
+     of several packets is copied, as reading its next packet may. */
+  drizzle_st *con= result->con;
+  view= view && con->packet_size < 0xFFFFFF &&
+        con->buffer_size >= con->packet_size;
+
+  memset(result->field_sizes, 0, sizeof(size_t) * result->column_count);
+  while (1)
+  {
+    if (view)
+    {
+      field= drizzle_field_read(result, NULL, NULL, &wire_size, ret_ptr);
+      total= (size_t)wire_size;
+    }
+    else
+    {
+      field= drizzle_field_buffer(result, &total, ret_ptr);
+    }
+
+    if (*ret_ptr == DRIZZLE_RETURN_ROW_END)
+      break;
+
+    if (*ret_ptr != DRIZZLE_RETURN_OK)
+    {
+      if (*ret_ptr != DRIZZLE_RETURN_IO_WAIT)
+      {
+        delete[] result->row;
+        delete[] result->field_sizes;
+        result->row= NULL;
+        result->field_sizes= NULL;
+      }
+
+      return NULL;
+    }
+
+    result->row[result->field_current - 1]= field;
+    result->field_sizes[result->field_current - 1]= field ? total : 0;
+  }
+
+  *ret_ptr= DRIZZLE_RETURN_OK;
+  row= result->row;
+
+  return row;
+}
+
+/** @} */
+
 /*
  * Client definitions
  */
@@ -95,99 +481,221 @@ drizzle_row_t drizzle_row_buffer(drizzle_result_st *result,
     return 0;
   }
 
-  size_t total;
-  drizzle_field_t field;
-  drizzle_row_t row;
+  return _row_fields(result, false, ret_ptr);
+}
 
-  if (result->row)
+drizzle_row_t drizzle_row_view(drizzle_result_st *result,
+                               drizzle_return_t *ret_ptr)
+{
+  drizzle_return_t unused_ret;
+  if (ret_ptr == NULL)
   {
-    delete[] result->row;
-    result->row= NULL;
+    ret_ptr= &unused_ret;
   }
 
-  if (drizzle_row_read(result, ret_ptr) == 0 || *ret_ptr != DRIZZLE_RETURN_OK)
+  if (result == NULL)
   {
-    return NULL;
+    *ret_ptr= DRIZZLE_RETURN_INVALID_ARGUMENT;
+    return 0;
   }
 
-  result->row= new (std::nothrow) drizzle_field_t[result->column_count];
-  if (result->row == NULL)
+  return _row_fields(result, true, ret_ptr);
+}
+
+drizzle_return_t drizzle_result_stream(drizzle_result_st *result,
+                                       uint32_t batch_rows,
+                                       drizzle_row_batch_fn *row_batch_fn,
+                                       void *context)
+{
+  drizzle_return_t ret;
+
+  if (result == NULL || row_batch_fn == NULL)
   {
-    drizzle_set_error(result->con, __func__, "Failed to allocate.");
-    *ret_ptr= DRIZZLE_RETURN_MEMORY;
-    return NULL;
+    return DRIZZLE_RETURN_INVALID_ARGUMENT;
   }
 
-  result->field_sizes= new (std::nothrow) size_t[result->column_count];
-  if (result->field_sizes == NULL)
+  if (result->options & (DRIZZLE_RESULT_BUFFER_ROW | DRIZZLE_RESULT_BUFFER_COLUMNAR))
+  {
+    drizzle_set_error(result->con, __func__, "result is already buffered");
+    return DRIZZLE_RETURN_UNEXPECTED_DATA;
+  }
+
+  if (!(result->options & DRIZZLE_RESULT_BUFFER_COLUMN))
+  {
+    ret= drizzle_column_buffer(result);
+    if (ret != DRIZZLE_RETURN_OK)
+    {
+      return ret;
+    }
+  }
+
+  if (result->column_count == 0 || result->row_eof)
   {
+    return DRIZZLE_RETURN_OK;
+  }
+
+  if (batch_rows == 0)
+  {
+    batch_rows= DRIZZLE_DEFAULT_ROW_BATCH_ROWS;
+  }
+
+  /* All the memory of the batches is allocated once, the rows of a batch
+     point into the receive buffer. */
+  uint16_t column_count= result->column_count;
+  size_t cells= (size_t)batch_rows * column_count;
+  drizzle_field_t *fields= new (std::nothrow) drizzle_field_t[cells];
+  size_t *sizes= new (std::nothrow) size_t[cells];
+  drizzle_row_t *rows= new (std::nothrow) drizzle_row_t[batch_rows];
+  size_t **row_sizes= new (std::nothrow) size_t*[batch_rows];
+  if (fields == NULL || sizes == NULL || rows == NULL || row_sizes == NULL)
+  {
+    delete[] fields;
+    delete[] sizes;
+    delete[] rows;
+    delete[] row_sizes;
     drizzle_set_error(result->con, __func__, "Failed to allocate.");
-    *ret_ptr= DRIZZLE_RETURN_MEMORY;
-    return NULL;
+    return DRIZZLE_RETURN_MEMORY;
   }
 
-  memset(result->field_sizes, 0, sizeof(size_t) * result->column_count);
-  while (1)
+  for (uint32_t it= 0; it < batch_rows; it++)
   {
-    field= drizzle_field_buffer(result, &total, ret_ptr);
-    if (*ret_ptr == DRIZZLE_RETURN_ROW_END)
+    rows[it]= fields + (size_t)it * column_count;
+    row_sizes[it]= sizes + (size_t)it * column_count;
+  }
+
+  ret= DRIZZLE_RETURN_OK;
+  uint32_t count= 0;
+  while (ret == DRIZZLE_RETURN_OK)
+  {
+    if (count == batch_rows)
+    {
+      ret= row_batch_fn(result, rows, row_sizes, count, context);
+      count= 0;
+      continue;
+    }
+
+    /* Rows that are already in the receive buffer are parsed in place. */
+    if (_row_parse(result, rows[count], row_sizes[count], &ret))
+    {
+      count++;
+      continue;
+    }
+
+    if (ret != DRIZZLE_RETURN_OK)
+    {
       break;
+    }
 
-    if (*ret_ptr != DRIZZLE_RETURN_OK)
+    /* Reading more of the socket may move the buffered data, so the batch
+       is handed over before the state machine runs. */
+    if (count > 0)
     {
-      if (*ret_ptr != DRIZZLE_RETURN_IO_WAIT)
+      ret= row_batch_fn(result, rows, row_sizes, count, context);
+      count= 0;
+      continue;
+    }
+
+    drizzle_row_t row= _row_fields(result, true, &ret);
+    if (row == NULL)
+    {
+      break;
+    }
+
+    if (result->binary_rows)
+    {
+      /* Only the fields that are not NULL are in the row. */
+      uint16_t field= 0;
+      for (uint16_t column= 0; column < column_count; column++)
       {
-        delete[] result->row;
-        delete[] result->field_sizes;
-        result->row= NULL;
-        result->field_sizes= NULL;
+        if (result->null_bitmap[(column + 2) / 8] & (1 << ((column + 2) % 8)))
+        {
+          rows[0][column]= NULL;
+          row_sizes[0][column]= 0;
+        }
+        else
+        {
+          rows[0][column]= row[field];
+          row_sizes[0][column]= result->field_sizes[field];
+          field++;
+        }
       }
-
-      return NULL;
+    }
+    else
+    {
+      memcpy(rows[0], row, sizeof(drizzle_field_t) * column_count);
+      memcpy(row_sizes[0], result->field_sizes, sizeof(size_t) * column_count);
     }
 
-    result->row[result->field_current - 1]= field;
-    result->field_sizes[result->field_current - 1]= total;
+    /* Its fields stay where they are until the state machine runs again,
+       which is only once this batch has been handed over. */
+    count= 1;
   }
 
-  *ret_ptr= DRIZZLE_RETURN_OK;
-  row= result->row;
+  delete[] fields;
+  delete[] sizes;
+  delete[] rows;
+  delete[] row_sizes;
 
-  return row;
+  return ret;
 }
 
 void drizzle_row_free(drizzle_result_st *result, drizzle_row_t row)
+{
+  /* Buffered rows live in the row lists and unbuffered rows in the arrays
+     drizzle_row_buffer() reuses for every row, both are freed with the
+     result. */
+  (void)result;
+  (void)row;
+}
+
+size_t *drizzle_row_field_sizes(drizzle_result_st *result)
 {
   if (result == NULL)
   {
-    return;
+    return NULL;
   }
 
-  delete[] row;
-  if (!(result->options & DRIZZLE_RESULT_BUFFER_ROW))
+  return result->field_sizes;
+}
+
+drizzle_field_t drizzle_row_field_by_name(drizzle_result_st *result,
+                                          drizzle_row_t row,
+                                          const char *column_name,
+                                          drizzle_return_t *ret_ptr)
+{
+  drizzle_return_t unused_ret;
+  if (ret_ptr == NULL)
   {
-    delete[] result->null_bitmap;
-    result->null_bitmap= NULL;
-    delete[] result->field_sizes;
-    result->field_sizes= NULL;
-    result->row= NULL;
+    ret_ptr= &unused_ret;
   }
 
-}
+  if (result == NULL || row == NULL || column_name == NULL)
+  {
+    *ret_ptr= DRIZZLE_RETURN_INVALID_ARGUMENT;
+    return NULL;
+  }
 
-size_t *drizzle_row_field_sizes(drizzle_result_st *result)
-{
-  if (result == NULL)
+  /* Binary rows only hold their fields that are not NULL. */
+  if (result->binary_rows)
   {
+    drizzle_set_error(result->con, __func__,
+                      "use drizzle_stmt_get_*_from_name() for statement results");
+    *ret_ptr= DRIZZLE_RETURN_INVALID_ARGUMENT;
     return NULL;
   }
 
-  return result->field_sizes;
+  uint16_t column= drizzle_column_lookup(result, column_name, ret_ptr);
+  if (*ret_ptr != DRIZZLE_RETURN_OK)
+  {
+    return NULL;
+  }
+
+  return row[column];
 }
 
 drizzle_row_t drizzle_row_next(drizzle_result_st *result)
 {
-  if (result == NULL)
+  if (result == NULL || !(result->options & DRIZZLE_RESULT_BUFFER_ROW))
   {
     return NULL;
   }
@@ -197,18 +705,20 @@ drizzle_row_t drizzle_row_next(drizzle_result_st *result)
     return NULL;
   }
 
-  result->field_sizes= result->field_sizes_list[result->row_current];
+  size_t first= (size_t)result->row_current * result->column_count;
+  result->field_sizes= result->field_sizes_list + first;
   if (result->binary_rows)
   {
-    result->null_bitmap= result->null_bitmap_list[result->row_current];
+    result->null_bitmap= result->null_bitmap_list +
+                         (size_t)result->row_current * result->null_bitmap_length;
   }
   result->row_current++;
-  return result->row_list[result->row_current - 1];
+  return result->row_list + first;
 }
 
 drizzle_row_t drizzle_row_prev(drizzle_result_st *result)
 {
-  if (result == NULL)
+  if (result == NULL || !(result->options & DRIZZLE_RESULT_BUFFER_ROW))
   {
     return NULL;
   }
@@ -217,12 +727,14 @@ drizzle_row_t drizzle_row_prev(drizzle_result_st *result)
     return NULL;
 
   result->row_current--;
-  result->field_sizes= result->field_sizes_list[result->row_current];
+  size_t first= (size_t)result->row_current * result->column_count;
+  result->field_sizes= result->field_sizes_list + first;
   if (result->binary_rows)
   {
-    result->null_bitmap= result->null_bitmap_list[result->row_current];
+    result->null_bitmap= result->null_bitmap_list +
+                         (size_t)result->row_current * result->null_bitmap_length;
   }
-  return result->row_list[result->row_current];
+  return result->row_list + first;
 }
 
 void drizzle_row_seek(drizzle_result_st *result, uint64_t row)
@@ -238,7 +750,7 @@ void drizzle_row_seek(drizzle_result_st *result, uint64_t row)
 
 drizzle_row_t drizzle_row_index(drizzle_result_st *result, uint64_t row)
 {
-  if (result == NULL)
+  if (result == NULL || !(result->options & DRIZZLE_RESULT_BUFFER_ROW))
   {
     return NULL;
   }
@@ -246,7 +758,7 @@ drizzle_row_t drizzle_row_index(drizzle_result_st *result, uint64_t row)
   if (row >= result->row_count)
     return NULL;
 
-  return result->row_list[row];
+  return result->row_list + (size_t)row * result->column_count;
 }
 
 uint64_t drizzle_row_current(drizzle_result_st *result)
@@ -279,17 +791,29 @@ drizzle_return_t drizzle_state_row_read(drizzle_st *con)
     return DRIZZLE_RETURN_OK;
   }
 
-  if (con->packet_size == 5 && con->buffer_ptr[0] == 254)
+  /* The OK packet replacing EOF has to be buffered entirely. A row starting
+     with 0xFE fills a whole packet, see drizzle_check_unpack_eof(). */
+  if (con->buffer_ptr[0] == 254 && con->packet_size < 0xFFFFFF &&
+      con->buffer_size < con->packet_size &&
+      !(con->result->options & DRIZZLE_RESULT_ROW_BREAK) &&
+      (con->capabilities & DRIZZLE_CAPABILITIES_DEPRECATE_EOF))
+  {
+    con->push_state(drizzle_state_read);
+    return DRIZZLE_RETURN_OK;
+  }
+
+  if (!(con->result->options & DRIZZLE_RESULT_ROW_BREAK) &&
+      drizzle_check_unpack_eof(con, &con->result->warning_count))
   {
     /* Got EOF packet, no more rows. */
     con->result->row_current= 0;
-    con->result->warning_count= drizzle_get_byte2(con->buffer_ptr + 1);
-    con->status= (drizzle_status_t)drizzle_get_byte2(con->buffer_ptr + 3);
-    con->buffer_ptr+= 5;
-    con->buffer_size-= 5;
+    con->result->row_eof= true;
+    drizzle_result_set_more_results(con->result);
+    drizzle_buffer_shrink(con);
   }
   else if (con->buffer_ptr[0] == 255)
   {
+    con->result->row_eof= true;
     con->pop_state();
     con->push_state(drizzle_state_result_read);
     return DRIZZLE_RETURN_OK;
@@ -54,8 +54,16 @@ drizzle_return_t drizzle_state_loop(drizzle_st *con)
   while (con->has_state() == false)
   {
     drizzle_return_t ret= con->current_state();
-    if (ret != DRIZZLE_RETURN_OK)
+    if (ret != DRIZZLE_RETURN_OK || con->state_stack_overflow())
     {
+      if (ret == DRIZZLE_RETURN_OK)
+      {
+        /* The states left are incomplete, nothing can resume them. */
+        con->clear_state();
+        drizzle_set_error(con, __func__, "state stack overflow");
+        ret= DRIZZLE_RETURN_INTERNAL_ERROR;
+      }
+
       if (ret != DRIZZLE_RETURN_IO_WAIT && ret != DRIZZLE_RETURN_PAUSE &&
           ret != DRIZZLE_RETURN_ERROR_CODE)
       {
@@ -88,6 +96,12 @@ drizzle_return_t drizzle_state_packet_read(drizzle_st *con)
 
   if (con->buffer_size < (con->packet_size + 4))
   {
+    drizzle_return_t ret= drizzle_buffer_reserve(con, con->packet_size + 4);
+    if (ret != DRIZZLE_RETURN_OK)
+    {
+      return ret;
+    }
+
     con->push_state(drizzle_state_read);
     return DRIZZLE_RETURN_OK;
   }
@@ -38,6 +38,10 @@
 #include "config.h"
 #include "libdrizzle/common.h"
 
+/* Amount of queued execute packets drizzle_stmt_execute_array() sends
+   before reading their results. */
+#define DRIZZLE_STMT_ARRAY_BATCH_SIZE 65536
+
 drizzle_stmt_st *drizzle_stmt_prepare(drizzle_st *con, const char *statement, size_t size, drizzle_return_t *ret_ptr)
 {
   drizzle_stmt_st *stmt= new (std::nothrow) drizzle_stmt_st;
@@ -60,11 +64,21 @@ drizzle_stmt_st *drizzle_stmt_prepare(drizzle_st *con, const char *statement, si
   }
 
   /* Don't get the unused parameter packets.  Format is the same as column
-   * packets.  Deliberate off-by-one for the EOF packet */
+   * packets.  Deliberate off-by-one for the EOF packet, unless the server
+   * leaves it out */
   if (stmt->param_count)
   {
     uint16_t param_num;
-    for (param_num= 0; param_num <= stmt->param_count; param_num++)
+    uint16_t packet_count= stmt->param_count;
+    if (stmt->prepare_result->no_metadata)
+    {
+      packet_count= 0;
+    }
+    if (!(con->capabilities & DRIZZLE_CAPABILITIES_DEPRECATE_EOF))
+    {
+      packet_count++;
+    }
+    for (param_num= 0; param_num < packet_count; param_num++)
     {
       *ret_ptr= drizzle_column_skip(stmt->prepare_result);
       if ((*ret_ptr != DRIZZLE_RETURN_OK) && (*ret_ptr != DRIZZLE_RETURN_EOF))
@@ -85,14 +99,6 @@ drizzle_stmt_st *drizzle_stmt_prepare(drizzle_st *con, const char *statement, si
    * bitmap mask */
 
   stmt->null_bitmap_length= (stmt->param_count + 7) / 8;
-  stmt->null_bitmap= new (std::nothrow) uint8_t[stmt->null_bitmap_length]();
-  if (stmt->null_bitmap == NULL)
-  {
-    delete stmt;
-    *ret_ptr= DRIZZLE_RETURN_MEMORY;
-    drizzle_set_error(con, __func__, "new");
-    return NULL;
-  }
 
   /* Also use the parameter count to allocate the parameters */
   stmt->query_params= new (std::nothrow) drizzle_bind_st[stmt->param_count];
@@ -102,104 +108,324 @@ drizzle_stmt_st *drizzle_stmt_prepare(drizzle_st *con, const char *statement, si
   return stmt;
 }
 
-drizzle_return_t drizzle_stmt_execute(drizzle_stmt_st *stmt)
+/**
+ * Free the bind structures that describe the result columns of a statement.
+ *
+ * @param[in,out] stmt A prepared statement object
+ */
+static void _result_binds_free(drizzle_stmt_st *stmt)
 {
-  uint16_t current_param;
-  uint16_t param_count = stmt->param_count;
-  drizzle_bind_st *param_ptr;
-  size_t param_lengths= 0;
-  size_t buffer_size= 0;
-  unsigned char *buffer;
-  unsigned char *buffer_pos;
-  unsigned char *data_pos;
-  drizzle_return_t ret;
+  if (stmt->result_binds == NULL)
+  {
+    return;
+  }
 
-  /* Calculate param lengths */
-  for (current_param= 0; current_param < stmt->param_count; current_param++)
+  for (uint16_t x= 0; x < stmt->result_bind_count; x++)
+  {
+    delete[] stmt->result_binds[x].data_buffer;
+  }
+  delete[] stmt->result_binds;
+  stmt->result_binds= NULL;
+  stmt->result_bind_count= 0;
+}
+
+/**
+ * Free the current execute result of a statement. Its columns are kept for
+ * the next execution, see _execute_result_columns().
+ *
+ * @param[in,out] stmt A prepared statement object
+ */
+static void _execute_result_free(drizzle_stmt_st *stmt)
+{
+  drizzle_result_st *result= stmt->execute_result;
+  if (result == NULL)
+  {
+    return;
+  }
+
+  stmt->result_params= NULL;
+
+  if (result->column_buffer != NULL &&
+      (result->options & DRIZZLE_RESULT_BUFFER_COLUMN))
+  {
+    delete[] stmt->column_cache;
+    drizzle_arena_free(&stmt->column_cache_arena);
+
+    stmt->column_cache= result->column_buffer;
+    stmt->column_cache_count= result->column_count;
+    stmt->column_cache_arena= result->column_arena;
+    result->column_buffer= NULL;
+    result->column_arena= drizzle_arena_st();
+  }
+
+  drizzle_result_free(result);
+  stmt->execute_result= NULL;
+}
+
+/**
+ * Give the execute result of a statement the columns of the previous one
+ * when it has as many, so that buffering its columns only compares the
+ * definitions the server sends again with them. If the server left the
+ * definitions out and there are none, the columns of the prepare result are
+ * copied instead.
+ *
+ * @param[in,out] stmt A prepared statement object
+ * @return Standard drizzle return value.
+ */
+static drizzle_return_t _execute_result_columns(drizzle_stmt_st *stmt)
+{
+  drizzle_result_st *result= stmt->execute_result;
+
+  if (result->column_buffer != NULL)
   {
-    if (!stmt->query_params[current_param].is_bound)
+    return DRIZZLE_RETURN_OK;
+  }
+
+  if (stmt->column_cache != NULL &&
+      stmt->column_cache_count == result->column_count)
+  {
+    drizzle_arena_free(&result->column_arena);
+    result->column_buffer= stmt->column_cache;
+    result->column_arena= stmt->column_cache_arena;
+    stmt->column_cache= NULL;
+    stmt->column_cache_count= 0;
+    stmt->column_cache_arena= drizzle_arena_st();
+  }
+  else if (result->no_metadata && stmt->fields != NULL &&
+           stmt->prepare_result->column_count == result->column_count)
+  {
+    result->column_buffer= new (std::nothrow) drizzle_column_st[result->column_count];
+    if (result->column_buffer == NULL)
     {
-      drizzle_set_error(stmt->con, __func__, "parameter %d has not been bound", current_param);
-      return DRIZZLE_RETURN_STMT_ERROR;
+      drizzle_set_error(stmt->con, __func__, "Failed to allocate.");
+      return DRIZZLE_RETURN_MEMORY;
     }
-    /* Don't count NULLs */
-    if (stmt->query_params[current_param].type == DRIZZLE_COLUMN_TYPE_NULL)
+
+    for (uint16_t x= 0; x < result->column_count; x++)
     {
-      param_count--;
-      continue;
+      result->column_buffer[x]= stmt->fields[x];
     }
-    /* parameter length + 8 byte header */
-    param_lengths+= stmt->query_params[current_param].length + 8;
+  }
+  else
+  {
+    return DRIZZLE_RETURN_OK;
   }
 
-  buffer_size= 4 /* Statement ID */
-             + 1 /* Flags */
-             + 4 /* Reserved (always set to 1) */
-             + stmt->null_bitmap_length /* Null bitmap length */
-             + 1 /* New parameters bound flag */
-             + (param_count * 2) /* Parameter type data */
-             + param_lengths; /* Parameter data */
+  for (uint16_t x= 0; x < result->column_count; x++)
+  {
+    result->column_buffer[x].result= result;
+  }
+
+  return DRIZZLE_RETURN_OK;
+}
+
+/**
+ * Make sure the execute buffer of a statement can hold size bytes. The buffer
+ * only ever grows, and what it already holds is kept.
+ *
+ * @param[in,out] stmt A prepared statement object
+ * @param[in] size The number of bytes needed
+ * @return Standard drizzle return value
+ */
+static drizzle_return_t _execute_buffer_reserve(drizzle_stmt_st *stmt,
+                                                size_t size)
+{
+  if (size <= stmt->execute_buffer_size)
+  {
+    return DRIZZLE_RETURN_OK;
+  }
 
-  buffer = new (std::nothrow) unsigned char[buffer_size];
+  size_t new_size= stmt->execute_buffer_size * 2;
+  if (new_size < size)
+  {
+    new_size= size;
+  }
+
+  unsigned char *buffer= (unsigned char *)realloc(stmt->execute_buffer, new_size);
   if (buffer == NULL)
   {
-    drizzle_set_error(stmt->con, __func__, "new");
+    drizzle_set_error(stmt->con, __func__, "Failed to realloc execute buffer.");
     return DRIZZLE_RETURN_MEMORY;
   }
-  buffer_pos= buffer;
 
-  /* Statement ID */
-  drizzle_set_byte4(buffer, stmt->id);
-  /* Flags (not currently used) */
-  buffer[4]= 0;
-  /* Reserved, protocol specifies set to 1 */
-  drizzle_set_byte4(&buffer[5], 1);
-  buffer_pos+= 9;
-  /* Null bitmap */
-  buffer_pos+= stmt->null_bitmap_length;
+  stmt->execute_buffer= buffer;
+  stmt->execute_buffer_size= new_size;
+
+  return DRIZZLE_RETURN_OK;
+}
+
+/**
+ * Forget which parameters are still packed in the execute buffer, after
+ * packing stopped part way and may have overwritten some of them.
+ *
+ * @param[in,out] stmt A prepared statement object
+ */
+static void _execute_buffer_invalidate(drizzle_stmt_st *stmt)
+{
+  for (uint16_t x= 0; x < stmt->param_count; x++)
+  {
+    stmt->query_params[x].is_dirty= true;
+  }
+}
+
+/**
+ * The most bytes a parameter can take in the execute packet.
+ *
+ * @param[in] param A bound parameter
+ * @return Size in bytes
+ */
+static size_t _param_packed_size(const drizzle_bind_st *param)
+{
+  switch (param->type)
+  {
+    case DRIZZLE_COLUMN_TYPE_TINY:
+      return 1;
+    case DRIZZLE_COLUMN_TYPE_SHORT:
+      return 2;
+    case DRIZZLE_COLUMN_TYPE_LONG:
+    case DRIZZLE_COLUMN_TYPE_FLOAT:
+      return 4;
+    case DRIZZLE_COLUMN_TYPE_LONGLONG:
+    case DRIZZLE_COLUMN_TYPE_DOUBLE:
+      return 8;
+    case DRIZZLE_COLUMN_TYPE_TIME:
+      return 13;
+    case DRIZZLE_COLUMN_TYPE_DATE:
+    case DRIZZLE_COLUMN_TYPE_DATETIME:
+    case DRIZZLE_COLUMN_TYPE_TIMESTAMP:
+      return 12;
+    case DRIZZLE_COLUMN_TYPE_TINY_BLOB:
+    case DRIZZLE_COLUMN_TYPE_MEDIUM_BLOB:
+    case DRIZZLE_COLUMN_TYPE_LONG_BLOB:
+    case DRIZZLE_COLUMN_TYPE_BLOB:
+    case DRIZZLE_COLUMN_TYPE_VARCHAR:
+    case DRIZZLE_COLUMN_TYPE_VAR_STRING:
+    case DRIZZLE_COLUMN_TYPE_STRING:
+    case DRIZZLE_COLUMN_TYPE_DECIMAL:
+    case DRIZZLE_COLUMN_TYPE_NEWDECIMAL:
+      /* Length encoded string */
+      return param->length + 9;
+    case DRIZZLE_COLUMN_TYPE_NULL:
+    case DRIZZLE_COLUMN_TYPE_INT24:
+    case DRIZZLE_COLUMN_TYPE_YEAR:
+    case DRIZZLE_COLUMN_TYPE_NEWDATE:
+    case DRIZZLE_COLUMN_TYPE_ENUM:
+    case DRIZZLE_COLUMN_TYPE_SET:
+    case DRIZZLE_COLUMN_TYPE_GEOMETRY:
+    case DRIZZLE_COLUMN_TYPE_BIT:
+    case DRIZZLE_COLUMN_TYPE_TIMESTAMP2:
+    case DRIZZLE_COLUMN_TYPE_DATETIME2:
+    case DRIZZLE_COLUMN_TYPE_TIME2:
+    default:
+      /* Not packed */
+      return 0;
+  }
+}
+
+drizzle_return_t drizzle_stmt_execute(drizzle_stmt_st *stmt)
+{
+  unsigned char *buffer;
+  size_t buffer_size;
+  drizzle_result_st *result;
+  drizzle_return_t ret;
+
+  ret= drizzle_stmt_execute_pack(stmt, &buffer, &buffer_size);
+  if (ret != DRIZZLE_RETURN_OK)
+  {
+    return ret;
+  }
+
+  _execute_result_free(stmt);
+
+  /* The packet stays in the statement, so a large one can be sent straight
+     from it even if the write has to wait for the socket. */
+  result= drizzle_command_write(stmt->con, NULL, DRIZZLE_COMMAND_STMT_EXECUTE, buffer, buffer_size, buffer_size, &ret);
+
+  if (ret == DRIZZLE_RETURN_OK)
+  {
+    stmt->new_bind= false;
+  }
+
+  return drizzle_stmt_execute_result(stmt, result, ret);
+}
+
+drizzle_return_t drizzle_stmt_execute_pack(drizzle_stmt_st *stmt,
+                                           unsigned char **buffer_ptr,
+                                           size_t *size_ptr)
+{
+  uint16_t current_param;
+  drizzle_bind_st *param_ptr;
+  size_t header_size;
+  size_t type_pos;
+  size_t data_pos;
+  unsigned char *buffer;
+  drizzle_return_t ret;
+
+  header_size= 4 /* Statement ID */
+             + 1 /* Flags */
+             + 4 /* Reserved (always set to 1) */
+             + stmt->null_bitmap_length /* Null bitmap length */
+             + 1; /* New parameters bound flag */
+
   /* New parameters bound flag
    * If set to 1 then we need to leave a gap between the parameters type data
-   * and the actually data, so we keep track of a second pointer in the
+   * and the actually data, so we keep track of a second position in the
    * buffer for this
    * */
+  type_pos= header_size;
+  data_pos= header_size;
   if (stmt->new_bind)
   {
-    *buffer_pos= 1;
-    buffer_pos++;
-    /* Each param has a 2 byte data type header so the data pointer should be
-     * moved to this */
-    data_pos= buffer_pos + (param_count * 2);
+    /* Each param has a 2 byte data type header */
+    data_pos+= (size_t)stmt->param_count * 2;
   }
-  else
+
+  ret= _execute_buffer_reserve(stmt, data_pos);
+  if (ret != DRIZZLE_RETURN_OK)
   {
-    *buffer_pos= 0;
-    buffer_pos++;
-    data_pos= buffer_pos;
+    return ret;
   }
-  memset(stmt->null_bitmap, 0, stmt->null_bitmap_length);
-  /* Go through each param copying to buffer
-   * In an ideal world we would do this without the copy
+  buffer= stmt->execute_buffer;
+
+  /* Statement ID */
+  drizzle_set_byte4(buffer, stmt->id);
+  /* Flags (not currently used) */
+  buffer[4]= 0;
+  /* Reserved, protocol specifies set to 1 */
+  drizzle_set_byte4(&buffer[5], 1);
+  memset(&buffer[9], 0, stmt->null_bitmap_length);
+  buffer[header_size - 1]= stmt->new_bind ? 1 : 0;
+
+  /* Go through each param copying to buffer. A value held in the parameter's
+   * own data_buffer only changes through drizzle_stmt_set_*(), so if it was
+   * not set again and everything before it kept its size, the bytes from the
+   * previous execution are still in place.
    * */
   for (current_param= 0; current_param < stmt->param_count; current_param++)
   {
     uint16_t short_value;
     uint32_t long_value;
     uint64_t longlong_value;
+    unsigned char *pos;
     param_ptr= &stmt->query_params[current_param];
 
+    if (!param_ptr->is_bound)
+    {
+      drizzle_set_error(stmt->con, __func__, "parameter %d has not been bound", current_param);
+      _execute_buffer_invalidate(stmt);
+      return DRIZZLE_RETURN_STMT_ERROR;
+    }
+
     if (stmt->new_bind)
     {
       uint16_t type= (uint16_t)param_ptr->type;
-      if (type != DRIZZLE_COLUMN_TYPE_NULL)
+      if (param_ptr->options.is_unsigned)
       {
-        if (param_ptr->options.is_unsigned)
-        {
-          /* Set the unsigned bit flag on the type data */
-          type |= 0x8000;
-        }
-        drizzle_set_byte2(buffer_pos, type);
-        buffer_pos+= 2;
+        /* Set the unsigned bit flag on the type data */
+        type |= 0x8000;
       }
+      drizzle_set_byte2(&stmt->execute_buffer[type_pos], type);
+      type_pos+= 2;
     }
 
     if (param_ptr->options.is_long_data)
@@ -208,47 +434,65 @@ drizzle_return_t drizzle_stmt_execute(drizzle_stmt_st *stmt)
       continue;
     }
 
+    if (param_ptr->options.is_null || param_ptr->type == DRIZZLE_COLUMN_TYPE_NULL)
+    {
+      /* Toggle the bit for this column in the bitmap */
+      stmt->execute_buffer[9 + current_param/8] |= (uint8_t)(1 << (current_param % 8));
+      continue;
+    }
+
+    if (!param_ptr->is_dirty && param_ptr->packed_offset == data_pos &&
+        param_ptr->data == param_ptr->data_buffer)
+    {
+      data_pos+= param_ptr->packed_length;
+      continue;
+    }
+
+    ret= _execute_buffer_reserve(stmt, data_pos + _param_packed_size(param_ptr));
+    if (ret != DRIZZLE_RETURN_OK)
+    {
+      _execute_buffer_invalidate(stmt);
+      return ret;
+    }
+    pos= &stmt->execute_buffer[data_pos];
+
     switch(param_ptr->type)
     {
-      case DRIZZLE_COLUMN_TYPE_NULL:
-        /* Toggle the bit for this column in the bitmap */
-        stmt->null_bitmap[current_param/8] |= (1 << (current_param % 8));
-        break;
       case DRIZZLE_COLUMN_TYPE_TINY:
-        *data_pos= *(uint8_t*)param_ptr->data;
-        data_pos++;
+        *pos= *(uint8_t*)param_ptr->data;
+        pos++;
         break;
       case DRIZZLE_COLUMN_TYPE_SHORT:
         short_value= *(uint16_t*)param_ptr->data;
-        drizzle_set_byte2(data_pos, short_value);
-        data_pos+= 2;
+        drizzle_set_byte2(pos, short_value);
+        pos+= 2;
         break;
       case DRIZZLE_COLUMN_TYPE_LONG:
         long_value= *(uint32_t*)param_ptr->data;
-        drizzle_set_byte4(data_pos, long_value);
-        data_pos+= 4;
+        drizzle_set_byte4(pos, long_value);
+        pos+= 4;
         break;
       case DRIZZLE_COLUMN_TYPE_LONGLONG:
         longlong_value= *(uint64_t*)param_ptr->data;
-        drizzle_set_byte8(data_pos, longlong_value);
-        data_pos+= 8;
+        drizzle_set_byte8(pos, longlong_value);
+        pos+= 8;
         break;
       case DRIZZLE_COLUMN_TYPE_FLOAT:
         /* Float and double don't need to be packed apparently */
-        memcpy(data_pos, param_ptr->data, 4);
-        data_pos+= 4;
+        memcpy(pos, param_ptr->data, 4);
+        pos+= 4;
         break;
       case DRIZZLE_COLUMN_TYPE_DOUBLE:
-        memcpy(data_pos, param_ptr->data, 8);
-        data_pos+= 8;
+        memcpy(pos, param_ptr->data, 8);
+        pos+= 8;
         break;
       case DRIZZLE_COLUMN_TYPE_TIME:
-        data_pos= drizzle_pack_time((drizzle_datetime_st*)param_ptr->data, data_pos);
+        pos= drizzle_pack_time((drizzle_datetime_st*)param_ptr->data, pos);
         break;
       case DRIZZLE_COLUMN_TYPE_DATE:
       case DRIZZLE_COLUMN_TYPE_DATETIME:
       case DRIZZLE_COLUMN_TYPE_TIMESTAMP:
-        data_pos= drizzle_pack_datetime((drizzle_datetime_st*)param_ptr->data, data_pos);
+        pos= drizzle_pack_datetime((drizzle_datetime_st*)param_ptr->data, pos);
         break;
       case DRIZZLE_COLUMN_TYPE_TINY_BLOB:
       case DRIZZLE_COLUMN_TYPE_MEDIUM_BLOB:
@@ -259,7 +503,7 @@ drizzle_return_t drizzle_stmt_execute(drizzle_stmt_st *stmt)
       case DRIZZLE_COLUMN_TYPE_STRING:
       case DRIZZLE_COLUMN_TYPE_DECIMAL:
       case DRIZZLE_COLUMN_TYPE_NEWDECIMAL:
-        data_pos= drizzle_pack_binary((unsigned char*)param_ptr->data, param_ptr->length, data_pos);
+        pos= drizzle_pack_binary((unsigned char*)param_ptr->data, param_ptr->length, pos);
         break;
       /* These types aren't handled yet, most are for older MySQL versions */
       case DRIZZLE_COLUMN_TYPE_INT24:
@@ -273,49 +517,234 @@ drizzle_return_t drizzle_stmt_execute(drizzle_stmt_st *stmt)
       case DRIZZLE_COLUMN_TYPE_TIMESTAMP2:
       case DRIZZLE_COLUMN_TYPE_DATETIME2:
       case DRIZZLE_COLUMN_TYPE_TIME2:
+      case DRIZZLE_COLUMN_TYPE_NULL:
       default:
         drizzle_set_error(stmt->con, __func__, "unknown type when filling buffer");
-        delete[] buffer;
+        _execute_buffer_invalidate(stmt);
         return DRIZZLE_RETURN_UNEXPECTED_DATA;
         break;
     }
+
+    param_ptr->packed_offset= data_pos;
+    param_ptr->packed_length= (size_t)(pos - &stmt->execute_buffer[data_pos]);
+    param_ptr->is_dirty= false;
+    data_pos+= param_ptr->packed_length;
   }
-  /* Copy NULL bitmap */
-  memcpy(&buffer[9], stmt->null_bitmap, stmt->null_bitmap_length);
-  if (stmt->execute_result)
+
+  /* Set buffer size to what we actually used */
+  *buffer_ptr= stmt->execute_buffer;
+  *size_ptr= data_pos;
+
+  return DRIZZLE_RETURN_OK;
+}
+
+/**
+ * Set the parameters of a statement that are bound to arrays to their
+ * values for one row.
+ *
+ * @param[in,out] stmt A prepared statement object
+ * @param[in] row The row number
+ * @return Standard drizzle return value
+ */
+static drizzle_return_t _array_row_set(drizzle_stmt_st *stmt, uint32_t row)
+{
+  drizzle_return_t ret;
+
+  if (stmt->array_params == NULL)
   {
-    drizzle_result_free(stmt->execute_result);
-    stmt->execute_result= NULL;
+    return DRIZZLE_RETURN_OK;
   }
 
-  /* Set buffer size to what we actually used */
-  buffer_size= data_pos - buffer;
+  for (uint16_t x= 0; x < stmt->param_count; x++)
+  {
+    drizzle_array_bind_st *array= &stmt->array_params[x];
+    if (array->data == NULL)
+    {
+      continue;
+    }
 
-  stmt->execute_result= drizzle_command_write(stmt->con, stmt->execute_result, DRIZZLE_COMMAND_STMT_EXECUTE, buffer, buffer_size, buffer_size, &ret);
+    /* A NULL row keeps the declared type, so the types are not sent again. */
+    bool is_null= array->nulls != NULL && array->nulls[row];
+    ret= drizzle_stmt_set_param(stmt, x, array->type,
+                                array->data + (size_t)row * array->stride,
+                                is_null ? 0 : (array->size ? array->size : array->lengths[row]),
+                                array->is_unsigned);
+    if (ret != DRIZZLE_RETURN_OK)
+    {
+      return ret;
+    }
+    stmt->query_params[x].options.is_null= is_null;
+  }
 
-  if (ret == DRIZZLE_RETURN_OK)
+  return DRIZZLE_RETURN_OK;
+}
+
+/**
+ * Read the results of the executions drizzle_stmt_execute_array() has
+ * pipelined so far.
+ *
+ * @param[in,out] stmt A prepared statement object
+ * @param[in,out] row The row of the oldest result, moved past those read
+ * @param[out] affected_rows Affected rows of each row, or NULL
+ * @param[out] error_codes Server error code of each row, or NULL
+ * @param[out] failed Set when the server returned an error for a row
+ * @return Standard drizzle return value
+ */
+static drizzle_return_t _array_results_read(drizzle_stmt_st *stmt,
+                                            uint32_t *row,
+                                            uint64_t *affected_rows,
+                                            uint16_t *error_codes,
+                                            bool *failed)
+{
+  drizzle_result_st *result;
+  drizzle_return_t ret;
+
+  while (drizzle_pipeline_count(stmt->con) > 0)
   {
-    stmt->state= DRIZZLE_STMT_EXECUTED;
+    result= drizzle_pipeline_result(stmt->con, &ret);
+    if (ret != DRIZZLE_RETURN_OK && ret != DRIZZLE_RETURN_ERROR_CODE)
+    {
+      return ret;
+    }
+
+    if (affected_rows != NULL)
+    {
+      affected_rows[*row]= drizzle_result_affected_rows(result);
+    }
+    if (error_codes != NULL)
+    {
+      error_codes[*row]= drizzle_result_error_code(result);
+    }
+    if (ret == DRIZZLE_RETURN_ERROR_CODE)
+    {
+      *failed= true;
+    }
+    (*row)++;
   }
-  else
+
+  return DRIZZLE_RETURN_OK;
+}
+
+drizzle_return_t drizzle_stmt_execute_array(drizzle_stmt_st *stmt,
+                                            uint32_t rows,
+                                            uint64_t *affected_rows,
+                                            uint16_t *error_codes)
+{
+  drizzle_return_t ret;
+  uint32_t read_row= 0;
+  bool failed= false;
+
+  if (stmt == NULL)
+  {
+    return DRIZZLE_RETURN_INVALID_ARGUMENT;
+  }
+
+  if (stmt->state < DRIZZLE_STMT_PREPARED)
+  {
+    drizzle_set_error(stmt->con, __func__, "stmt object has not been prepared");
+    return DRIZZLE_RETURN_STMT_ERROR;
+  }
+
+  if (stmt->prepare_result->column_count > 0)
+  {
+    drizzle_set_error(stmt->con, __func__,
+                      "statements that return rows can not be executed for an array");
+    return DRIZZLE_RETURN_INVALID_ARGUMENT;
+  }
+
+  if (stmt->con->options.non_blocking)
+  {
+    drizzle_set_error(stmt->con, __func__,
+                      "array execution is not supported on non-blocking connections");
+    return DRIZZLE_RETURN_NOT_READY;
+  }
+
+  /* The results read below must all be ours */
+  if (drizzle_pipeline_count(stmt->con) > 0)
+  {
+    drizzle_set_error(stmt->con, __func__,
+                      "pipelined results must be read first");
+    return DRIZZLE_RETURN_NOT_READY;
+  }
+
+  for (uint32_t row= 0; row < rows; row++)
+  {
+    ret= _array_row_set(stmt, row);
+    if (ret == DRIZZLE_RETURN_OK)
+    {
+      ret= drizzle_pipeline_stmt_execute(stmt);
+    }
+
+    if (ret != DRIZZLE_RETURN_OK)
+    {
+      /* Still read what was sent, so the connection can be used again */
+      (void)_array_results_read(stmt, &read_row, affected_rows, error_codes,
+                                &failed);
+      return ret;
+    }
+
+    /* The server answers while the batch is being sent, so keep the batch
+       small enough for its answers to fit in the socket buffers. */
+    if (stmt->con->pipeline_size >= DRIZZLE_STMT_ARRAY_BATCH_SIZE ||
+        row + 1 == rows)
+    {
+      ret= _array_results_read(stmt, &read_row, affected_rows, error_codes,
+                               &failed);
+      if (ret != DRIZZLE_RETURN_OK)
+      {
+        return ret;
+      }
+    }
+  }
+
+  return failed ? DRIZZLE_RETURN_ERROR_CODE : DRIZZLE_RETURN_OK;
+}
+
+drizzle_return_t drizzle_stmt_execute_result(drizzle_stmt_st *stmt,
+                                             drizzle_result_st *result,
+                                             drizzle_return_t ret)
+{
+  if (stmt->execute_result != result)
+  {
+    _execute_result_free(stmt);
+    stmt->execute_result= result;
+  }
+
+  if (ret != DRIZZLE_RETURN_OK)
   {
-    delete[] buffer;
     return ret;
   }
 
-  stmt->new_bind= false;
+  stmt->state= DRIZZLE_STMT_EXECUTED;
 
   stmt->execute_result->binary_rows= true;
 
-  stmt->execute_result->options= (drizzle_result_options_t)((uint8_t)stmt->execute_result->options | (uint8_t)DRIZZLE_RESULT_BINARY_ROWS);
+  stmt->execute_result->options= (drizzle_result_options_t)((int)stmt->execute_result->options | (int)DRIZZLE_RESULT_BINARY_ROWS);
 
   if (stmt->execute_result->column_count > 0)
   {
+    ret= _execute_result_columns(stmt);
+    if (ret != DRIZZLE_RETURN_OK)
+    {
+      return ret;
+    }
+
     ret= drizzle_column_buffer(stmt->execute_result);
-    stmt->result_params= new (std::nothrow) drizzle_bind_st[stmt->execute_result->column_count];
+
+    if (stmt->result_bind_count != stmt->execute_result->column_count)
+    {
+      _result_binds_free(stmt);
+      stmt->result_binds= new (std::nothrow) drizzle_bind_st[stmt->execute_result->column_count];
+      if (stmt->result_binds == NULL)
+      {
+        drizzle_set_error(stmt->con, __func__, "Failed to allocate.");
+        return DRIZZLE_RETURN_MEMORY;
+      }
+      stmt->result_bind_count= stmt->execute_result->column_count;
+    }
+    stmt->result_params= stmt->result_binds;
   }
 
-  delete[] buffer;
   return ret;
 }
 
@@ -350,6 +779,7 @@ drizzle_return_t drizzle_stmt_send_long_data(drizzle_stmt_st *stmt, uint16_t par
                         buffer, len+6, len+6, &ret);
   stmt->con->state.no_result_read= false;
   stmt->query_params[param_num].options.is_long_data= true;
+  stmt->query_params[param_num].is_dirty= true;
 
   delete[] buffer;
   return ret;
@@ -376,13 +806,8 @@ drizzle_return_t drizzle_stmt_reset(drizzle_stmt_st *stmt)
   drizzle_command_write(stmt->con, NULL, DRIZZLE_COMMAND_STMT_RESET, buffer, 4,
                         4, &ret);
   stmt->con->state.no_result_read= false;
-  if (stmt->execute_result)
-  {
-    drizzle_result_free(stmt->execute_result);
-    stmt->execute_result= NULL;
-  }
+  _execute_result_free(stmt);
   stmt->state= DRIZZLE_STMT_PREPARED;
-  delete[] stmt->result_params;
 
   return ret;
 }
@@ -409,7 +834,11 @@ drizzle_return_t drizzle_stmt_fetch(drizzle_stmt_st *stmt)
   /* Determine how to read the row based on whether or not it is already
    * buffered */
 
-  if (stmt->execute_result->options & DRIZZLE_RESULT_BUFFER_ROW)
+  if (stmt->execute_result->options & DRIZZLE_RESULT_BUFFER_COLUMNAR)
+  {
+    return DRIZZLE_RETURN_ROW_END;
+  }
+  else if (stmt->execute_result->options & DRIZZLE_RESULT_BUFFER_ROW)
   {
     row= drizzle_row_next(stmt->execute_result);
   }
@@ -443,10 +872,7 @@ drizzle_return_t drizzle_stmt_fetch(drizzle_stmt_st *stmt)
       param->type= column->type;
       param->options.is_null= false;
       param->length= stmt->execute_result->field_sizes[current_column];
-      if (column->flags & DRIZZLE_COLUMN_FLAGS_UNSIGNED)
-      {
-        param->options.is_unsigned= true;
-      }
+      param->options.is_unsigned= (column->flags & DRIZZLE_COLUMN_FLAGS_UNSIGNED);
 
       switch(column->type)
       {
@@ -564,21 +990,17 @@ drizzle_return_t drizzle_stmt_close(drizzle_stmt_st *stmt)
     return DRIZZLE_RETURN_INVALID_ARGUMENT;
   }
 
-  delete[] stmt->null_bitmap;
+  free(stmt->execute_buffer);
   for (uint16_t x= 0; x < stmt->param_count; x++)
   {
     delete[] stmt->query_params[x].data_buffer;
   }
   delete[] stmt->query_params;
-  if (stmt->execute_result)
-  {
-    for (uint16_t x= 0; x < stmt->execute_result->column_count; x++)
-    {
-      delete[] stmt->result_params[x].data_buffer;
-    }
-    delete[] stmt->result_params;
-    drizzle_result_free(stmt->execute_result);
-  }
+  _execute_result_free(stmt);
+  _result_binds_free(stmt);
+  delete[] stmt->array_params;
+  delete[] stmt->column_cache;
+  drizzle_arena_free(&stmt->column_cache_arena);
   if (stmt->prepare_result)
   {
     drizzle_result_free(stmt->prepare_result);
@@ -642,3 +1064,13 @@ uint64_t drizzle_stmt_row_count(drizzle_stmt_st *stmt)
 
   return UINT64_MAX;
 }
+
+drizzle_result_st *drizzle_stmt_result(drizzle_stmt_st *stmt)
+{
+  if (stmt == NULL)
+  {
+    return NULL;
+  }
+
+  return stmt->execute_result;
+}
@@ -53,7 +53,10 @@ char *time_to_string(drizzle_bind_st *param, drizzle_datetime_st *time);
 
 char *timestamp_to_string(drizzle_bind_st *param, drizzle_datetime_st *timestamp);
 
-uint16_t drizzle_stmt_column_lookup(drizzle_result_st *result, const char *column_name, drizzle_return_t *ret_ptr);
+/* The packet is left in stmt->execute_buffer, which the statement owns */
+drizzle_return_t drizzle_stmt_execute_pack(drizzle_stmt_st *stmt, unsigned char **buffer_ptr, size_t *size_ptr);
+
+drizzle_return_t drizzle_stmt_execute_result(drizzle_stmt_st *stmt, drizzle_result_st *result, drizzle_return_t ret);
 
 #ifdef __cplusplus
 }
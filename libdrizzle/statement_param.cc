@@ -55,11 +55,21 @@ drizzle_return_t drizzle_stmt_set_param(drizzle_stmt_st *stmt, uint16_t param_nu
     return DRIZZLE_RETURN_STMT_ERROR;
   }
 
-  stmt->query_params[param_num].type= type;
-  stmt->query_params[param_num].data= (void*)data;
-  stmt->query_params[param_num].length= length;
-  stmt->query_params[param_num].options.is_unsigned= is_unsigned;
-  stmt->query_params[param_num].is_bound= true;
+  drizzle_bind_st *param= &stmt->query_params[param_num];
+
+  /* The server has to be sent the parameter types again if they change */
+  if (param->type != type || param->options.is_unsigned != is_unsigned)
+  {
+    stmt->new_bind= true;
+  }
+
+  param->type= type;
+  param->data= (void*)data;
+  param->length= length;
+  param->options.is_unsigned= is_unsigned;
+  param->options.is_null= false;
+  param->is_bound= true;
+  param->is_dirty= true;
 
   return DRIZZLE_RETURN_OK;
 }
@@ -174,6 +184,96 @@ drizzle_return_t drizzle_stmt_set_timestamp(drizzle_stmt_st *stmt, uint16_t para
   return drizzle_stmt_set_param(stmt, param_num, DRIZZLE_COLUMN_TYPE_TIMESTAMP, timestamp, 0, false);
 }
 
+drizzle_return_t drizzle_stmt_set_array(drizzle_stmt_st *stmt, uint16_t param_num, drizzle_column_type_t type, const void *data, size_t stride, const size_t *lengths, const bool *nulls, bool is_unsigned)
+{
+  size_t size;
+
+  if ((stmt == NULL) || (param_num >= stmt->param_count))
+  {
+    return DRIZZLE_RETURN_INVALID_ARGUMENT;
+  }
+  if (stmt->state < DRIZZLE_STMT_PREPARED)
+  {
+    drizzle_set_error(stmt->con, __func__, "stmt object has not been prepared");
+    return DRIZZLE_RETURN_STMT_ERROR;
+  }
+
+  switch (type)
+  {
+    case DRIZZLE_COLUMN_TYPE_TINY:
+      size= 1;
+      break;
+    case DRIZZLE_COLUMN_TYPE_SHORT:
+      size= 2;
+      break;
+    case DRIZZLE_COLUMN_TYPE_LONG:
+    case DRIZZLE_COLUMN_TYPE_FLOAT:
+      size= 4;
+      break;
+    case DRIZZLE_COLUMN_TYPE_LONGLONG:
+    case DRIZZLE_COLUMN_TYPE_DOUBLE:
+      size= 8;
+      break;
+    case DRIZZLE_COLUMN_TYPE_TINY_BLOB:
+    case DRIZZLE_COLUMN_TYPE_MEDIUM_BLOB:
+    case DRIZZLE_COLUMN_TYPE_LONG_BLOB:
+    case DRIZZLE_COLUMN_TYPE_BLOB:
+    case DRIZZLE_COLUMN_TYPE_VARCHAR:
+    case DRIZZLE_COLUMN_TYPE_VAR_STRING:
+    case DRIZZLE_COLUMN_TYPE_STRING:
+    case DRIZZLE_COLUMN_TYPE_DECIMAL:
+    case DRIZZLE_COLUMN_TYPE_NEWDECIMAL:
+      size= 0;
+      break;
+    case DRIZZLE_COLUMN_TYPE_NULL:
+    case DRIZZLE_COLUMN_TYPE_TIMESTAMP:
+    case DRIZZLE_COLUMN_TYPE_INT24:
+    case DRIZZLE_COLUMN_TYPE_DATE:
+    case DRIZZLE_COLUMN_TYPE_TIME:
+    case DRIZZLE_COLUMN_TYPE_DATETIME:
+    case DRIZZLE_COLUMN_TYPE_YEAR:
+    case DRIZZLE_COLUMN_TYPE_NEWDATE:
+    case DRIZZLE_COLUMN_TYPE_BIT:
+    case DRIZZLE_COLUMN_TYPE_TIMESTAMP2:
+    case DRIZZLE_COLUMN_TYPE_DATETIME2:
+    case DRIZZLE_COLUMN_TYPE_TIME2:
+    case DRIZZLE_COLUMN_TYPE_ENUM:
+    case DRIZZLE_COLUMN_TYPE_SET:
+    case DRIZZLE_COLUMN_TYPE_GEOMETRY:
+    default:
+      drizzle_set_error(stmt->con, __func__, "type can not be bound to an array");
+      return DRIZZLE_RETURN_INVALID_ARGUMENT;
+  }
+
+  /* Strings sit in slots of stride bytes, with their lengths alongside */
+  if (data != NULL && size == 0 && (stride == 0 || lengths == NULL))
+  {
+    drizzle_set_error(stmt->con, __func__, "string arrays need a stride and lengths");
+    return DRIZZLE_RETURN_INVALID_ARGUMENT;
+  }
+
+  if (stmt->array_params == NULL)
+  {
+    stmt->array_params= new (std::nothrow) drizzle_array_bind_st[stmt->param_count];
+    if (stmt->array_params == NULL)
+    {
+      drizzle_set_error(stmt->con, __func__, "Failed to allocate.");
+      return DRIZZLE_RETURN_MEMORY;
+    }
+  }
+
+  drizzle_array_bind_st *array= &stmt->array_params[param_num];
+  array->type= type;
+  array->data= (const unsigned char *)data;
+  array->stride= stride ? stride : size;
+  array->size= size;
+  array->lengths= lengths;
+  array->nulls= nulls;
+  array->is_unsigned= is_unsigned;
+
+  return DRIZZLE_RETURN_OK;
+}
+
 bool drizzle_stmt_get_is_null_from_name(drizzle_stmt_st *stmt, const char *column_name, drizzle_return_t *ret_ptr)
 {
   uint16_t column_number;
@@ -182,7 +282,7 @@ bool drizzle_stmt_get_is_null_from_name(drizzle_stmt_st *stmt, const char *colum
     *ret_ptr= DRIZZLE_RETURN_INVALID_ARGUMENT;
     return 0;
   }
-  column_number=  drizzle_stmt_column_lookup(stmt->prepare_result, column_name, ret_ptr);
+  column_number=  drizzle_column_lookup(stmt->prepare_result, column_name, ret_ptr);
   if (*ret_ptr != DRIZZLE_RETURN_OK)
   {
     return 0;
@@ -210,7 +310,7 @@ bool drizzle_stmt_get_is_unsigned_from_name(drizzle_stmt_st *stmt, const char *c
     *ret_ptr= DRIZZLE_RETURN_INVALID_ARGUMENT;
     return 0;
   }
-  column_number=  drizzle_stmt_column_lookup(stmt->prepare_result, column_name, ret_ptr);
+  column_number=  drizzle_column_lookup(stmt->prepare_result, column_name, ret_ptr);
   if (*ret_ptr != DRIZZLE_RETURN_OK)
   {
     return 0;
@@ -238,7 +338,7 @@ const char *drizzle_stmt_get_string_from_name(drizzle_stmt_st *stmt, const char
     *ret_ptr= DRIZZLE_RETURN_INVALID_ARGUMENT;
     return 0;
   }
-  column_number=  drizzle_stmt_column_lookup(stmt->prepare_result, column_name, ret_ptr);
+  column_number=  drizzle_column_lookup(stmt->prepare_result, column_name, ret_ptr);
   if (*ret_ptr != DRIZZLE_RETURN_OK)
   {
     return 0;
@@ -342,7 +442,7 @@ uint32_t drizzle_stmt_get_int_from_name(drizzle_stmt_st *stmt, const char *colum
     *ret_ptr= DRIZZLE_RETURN_INVALID_ARGUMENT;
     return 0;
   }
-  column_number=  drizzle_stmt_column_lookup(stmt->prepare_result, column_name, ret_ptr);
+  column_number=  drizzle_column_lookup(stmt->prepare_result, column_name, ret_ptr);
   if (*ret_ptr != DRIZZLE_RETURN_OK)
   {
     return 0;
@@ -432,7 +532,7 @@ uint64_t drizzle_stmt_get_bigint_from_name(drizzle_stmt_st *stmt, const char *co
     *ret_ptr= DRIZZLE_RETURN_INVALID_ARGUMENT;
     return 0;
   }
-  column_number=  drizzle_stmt_column_lookup(stmt->prepare_result, column_name, ret_ptr);
+  column_number=  drizzle_column_lookup(stmt->prepare_result, column_name, ret_ptr);
   if (*ret_ptr != DRIZZLE_RETURN_OK)
   {
     return 0;
@@ -518,7 +618,7 @@ double drizzle_stmt_get_double_from_name(drizzle_stmt_st *stmt, const char *colu
     *ret_ptr= DRIZZLE_RETURN_INVALID_ARGUMENT;
     return 0;
   }
-  column_number=  drizzle_stmt_column_lookup(stmt->prepare_result, column_name, ret_ptr);
+  column_number=  drizzle_column_lookup(stmt->prepare_result, column_name, ret_ptr);
   if (*ret_ptr != DRIZZLE_RETURN_OK)
   {
     return 0;
@@ -679,18 +779,3 @@ char *timestamp_to_string(drizzle_bind_st *param, drizzle_datetime_st *timestamp
 
   return buffer;
 }
-
-uint16_t drizzle_stmt_column_lookup(drizzle_result_st *result, const char *column_name, drizzle_return_t *ret_ptr)
-{
-  uint16_t current_column;
-  for (current_column= 0; current_column < result->column_count; current_column++)
-  {
-    if (strncmp(column_name, result->column_buffer[current_column].name, DRIZZLE_MAX_COLUMN_NAME_SIZE) == 0)
-    {
-      *ret_ptr= DRIZZLE_RETURN_OK;
-      return current_column;
-    }
-  }
-  *ret_ptr= DRIZZLE_RETURN_NOT_FOUND;
-  return 0;
-}
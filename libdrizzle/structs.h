@@ -65,7 +65,6 @@ extern "C" {
 #endif
 
 #include "libdrizzle/datetime.h"
-#include "libdrizzle/packet.h"
 
 #if defined _WIN32 || defined __CYGWIN__
 typedef SOCKET socket_t;
@@ -159,7 +158,12 @@ struct drizzle_options_st
   bool interactive;
   bool multi_statements;
   bool auth_plugin;
+  bool low_footprint;
+  bool io_uring;
   drizzle_socket_owner socket_owner;
+  drizzle_compression_t compression;
+  int compression_level;          /* 0 selects the default of the algorithm */
+  size_t compression_threshold;   /* smaller packets are sent uncompressed */
   int wait_timeout;
   int keepidle;  // default value under linux: 7200
   int keepcnt;   // default value under linux: 75
@@ -172,7 +176,12 @@ struct drizzle_options_st
     interactive(false),
     multi_statements(false),
     auth_plugin(false),
+    low_footprint(false),
+    io_uring(false),
     socket_owner(DRIZZLE_SOCKET_OWNER_NATIVE),
+    compression(DRIZZLE_COMPRESSION_NONE),
+    compression_level(0),
+    compression_threshold(DRIZZLE_DEFAULT_COMPRESSION_THRESHOLD),
     wait_timeout(DRIZZLE_DEFAULT_SOCKET_TIMEOUT),
     keepidle(7200),
     keepcnt(75),
@@ -202,12 +211,16 @@ struct drizzle_st
     bool no_result_read;
     bool io_ready;
     bool raw_packet;
+    bool pipeline_write;  /* queued pipelined commands are being sent */
+    bool pipeline_read;   /* the oldest pipelined result is being read */
 
     state_t() :
       ready(false),
       no_result_read(false),
       io_ready(false),
-      raw_packet(false)
+      raw_packet(false),
+      pipeline_write(false),
+      pipeline_read(false)
     { }
   } state;
 
@@ -228,6 +241,8 @@ struct drizzle_st
   unsigned char *buffer_ptr;       /* cursor pointing into 'buffer' */
   unsigned char *command_buffer;
   unsigned char *command_data;
+  unsigned char *write_data;       /* caller data sent after 'buffer_ptr' without copying */
+  size_t write_data_size;          /* amount of data left to send from 'write_data' */
   void *context;
   drizzle_context_free_fn *context_free_fn;
   void *event_watch_context; /* context for custom callback function  */
@@ -242,6 +257,8 @@ struct drizzle_st
   } socket;
   unsigned char *buffer;
   size_t buffer_allocation; /* total allocated size of 'buffer' */
+  bool buffer_mirrored;     /* 'buffer' is mapped twice in a row, see libdrizzle/buffer.h */
+  uint32_t buffer_small_reads; /* reads in a row that left no more than the resting size in 'buffer' */
   char db[DRIZZLE_MAX_DB_SIZE];
   char password[DRIZZLE_MAX_PASSWORD_SIZE];
   unsigned char scramble_buffer[DRIZZLE_MAX_SCRAMBLE_SIZE];
@@ -264,15 +281,32 @@ struct drizzle_st
   void *log_context;
   pollfd_t pfds[1];
   char sqlstate[DRIZZLE_MAX_SQLSTATE_SIZE + 1];
-  char last_error[DRIZZLE_MAX_ERROR_SIZE];
+  char *last_error;               /* allocated on first use, see drizzle_error_buffer() */
   drizzle_stmt_st *stmt;
   drizzle_binlog_st *binlog;
+  drizzle_reactor_st *reactor;     /* reactor this connection is registered with */
+  size_t reactor_index;            /* position in the reactor connection list */
+  socket_t reactor_fd;             /* descriptor currently known to the reactor */
+  short reactor_events;            /* events currently registered with the reactor */
+  struct drizzle_uring_st *uring;  /* private io_uring, see libdrizzle/uring.h */
+  bool uring_reading;              /* a read into 'buffer' is queued on the reactor ring */
+  bool uring_read_done;            /* the reactor ring completed that read */
+  int32_t uring_read_result;       /* its byte count, or a negative errno */
+  drizzle_compression_t compression; /* algorithm negotiated during the handshake */
+  struct drizzle_compress_st *compress; /* compressed protocol state once it is in effect */
+  unsigned char *pipeline_buffer;  /* pipelined command packets not sent yet */
+  size_t pipeline_size;            /* amount of data in 'pipeline_buffer' */
+  size_t pipeline_sent;            /* leading bytes of 'pipeline_buffer' handed to a write */
+  size_t pipeline_allocation;      /* total allocated size of 'pipeline_buffer' */
+  uint32_t pipeline_queued;        /* pipelined commands waiting in 'pipeline_buffer' */
+  uint32_t pipeline_sending;       /* pipelined commands of the write in progress */
+  uint32_t pipeline_pending;       /* pipelined commands sent whose result was not read */
+  drizzle_result_st *pipeline_head; /* oldest pipelined result, newer ones follow through 'prev' */
 private:
+  /* States still to run, the last one runs next. */
   size_t _state_stack_count;
-  Packet *_state_stack_list;
-  Packet _stack_packets[DRIZZLE_STATE_STACK_SIZE];
-  size_t _free_packet_count;
-  Packet *_free_packet_list;
+  drizzle_state_fn *_state_stack[DRIZZLE_STATE_STACK_SIZE];
+  bool _state_stack_overflow;      /* a state did not fit on the stack */
 public:
 
   drizzle_st() :
@@ -298,6 +332,8 @@ public:
     addrinfo_next(NULL),
     command_buffer(NULL),
     command_data(NULL),
+    write_data(NULL),
+    write_data_size(0),
     context(NULL),
     context_free_fn(NULL),
     event_watch_context(NULL),
@@ -305,7 +341,9 @@ public:
     result(NULL),
     result_list(NULL),
     scramble(NULL),
-    buffer_allocation(DRIZZLE_DEFAULT_BUFFER_SIZE),
+    buffer_allocation(0),
+    buffer_mirrored(false),
+    buffer_small_reads(0),
     ssl_context(NULL),
     ssl(NULL),
     ssl_state(DRIZZLE_SSL_STATE_NONE),
@@ -315,58 +353,58 @@ public:
     timeout(-1),
     log_fn(NULL),
     log_context(NULL),
+    last_error(NULL),
     stmt(NULL),
     binlog(NULL),
+    reactor(NULL),
+    reactor_index(0),
+    reactor_fd(-1),
+    reactor_events(0),
+    uring(NULL),
+    uring_reading(false),
+    uring_read_done(false),
+    uring_read_result(0),
+    compression(DRIZZLE_COMPRESSION_NONE),
+    compress(NULL),
+    pipeline_buffer(NULL),
+    pipeline_size(0),
+    pipeline_sent(0),
+    pipeline_allocation(0),
+    pipeline_queued(0),
+    pipeline_sending(0),
+    pipeline_pending(0),
+    pipeline_head(NULL),
     _state_stack_count(0),
-    _state_stack_list(NULL),
-    _free_packet_count(0),
-    _free_packet_list(NULL)
+    _state_stack_overflow(false)
   {
     db[0]= '\0';
     password[0]= '\0';
     server_version[0]= '\0';
     user[0]= '\0';
     sqlstate[0]= '\0';
-    last_error[0]= '\0';
-    buffer= (unsigned char*)malloc(DRIZZLE_DEFAULT_BUFFER_SIZE);
-    buffer_ptr= buffer;
-
-    assert(DRIZZLE_STATE_STACK_SIZE);
-    for (size_t x= 0; x < DRIZZLE_STATE_STACK_SIZE; ++x)
-    {
-      Packet *packet= &(_stack_packets[x]);
-      packet->init(this);
-      LIBDRIZZLE_LIST_ADD(_free_packet, packet);
-      assert(_free_packet_list);
-    }
+    buffer= NULL;
+    buffer_ptr= NULL;
   }
 
   ~drizzle_st()
   {
     clear_state();
+    free(last_error);
   }
 
+  /* The stack has a fixed size deep enough for every nesting of states
+     there is, a state that does not fit fails the connection in
+     drizzle_state_loop(). */
   bool push_state(drizzle_state_fn* func_)
   {
-    Packet *tmp;
-    if (_free_packet_count)
-    {
-      tmp= _free_packet_list;
-      LIBDRIZZLE_LIST_DEL(_free_packet, tmp);
-      tmp->func(func_);
-    }
-    else
+    if (_state_stack_count == DRIZZLE_STATE_STACK_SIZE)
     {
-      tmp= new (std::nothrow) Packet(this, func_);
+      _state_stack_overflow= true;
+      return false;
     }
 
-    if (tmp)
-    {
-      LIBDRIZZLE_LIST_ADD(_state_stack, tmp);
-      return true;
-    }
-
-    return false;
+    _state_stack[_state_stack_count++]= func_;
+    return true;
   }
 
   bool has_state() const
@@ -374,36 +412,28 @@ public:
     return _state_stack_count == 0;
   }
 
+  bool state_stack_overflow() const
+  {
+    return _state_stack_overflow;
+  }
+
   drizzle_return_t current_state()
   {
-    return _state_stack_list->func();
+    return _state_stack[_state_stack_count - 1](this);
   }
 
   void pop_state()
   {
-    Packet* tmp= _state_stack_list;
-    if (tmp)
+    if (_state_stack_count)
     {
-      LIBDRIZZLE_LIST_DEL(_state_stack, tmp);
-
-      if (tmp->stack())
-      {
-        tmp->clear();
-        LIBDRIZZLE_LIST_ADD(_free_packet, tmp);
-      }
-      else
-      {
-        delete tmp;
-      }
+      _state_stack_count--;
     }
   }
 
   void clear_state()
   {
-    while(_state_stack_list)
-    {
-      pop_state();
-    }
+    _state_stack_count= 0;
+    _state_stack_overflow= false;
   }
 };
 
@@ -463,19 +493,24 @@ struct drizzle_column_st
   drizzle_column_st *next;
   drizzle_column_st *prev;
   drizzle_column_options_t options;
-  char catalog[DRIZZLE_MAX_CATALOG_SIZE];
-  char db[DRIZZLE_MAX_DB_SIZE];
-  char table[DRIZZLE_MAX_TABLE_SIZE];
-  char orig_table[DRIZZLE_MAX_TABLE_SIZE];
-  char name[DRIZZLE_MAX_COLUMN_NAME_SIZE];
-  char orig_name[DRIZZLE_MAX_COLUMN_NAME_SIZE];
+  /* The six names as received, length encoded, in the column_arena of the
+     result. They are decoded in place into the pointers below the first
+     time one of them is asked for. */
+  unsigned char *names;
+  uint32_t names_size;
+  const char *catalog;
+  const char *db;
+  const char *table;
+  const char *orig_table;
+  const char *name;
+  const char *orig_name;
   drizzle_charset_t charset;
   uint32_t size;
   size_t max_size;
   drizzle_column_type_t type;
   int flags;
   uint8_t decimals;
-  unsigned char default_value[DRIZZLE_MAX_DEFAULT_VALUE_SIZE];
+  unsigned char *default_value;
   size_t default_value_size;
 
   drizzle_column_st() :
@@ -483,20 +518,23 @@ struct drizzle_column_st
     next(NULL),
     prev(NULL),
     options(DRIZZLE_COLUMN_UNUSED),
+    names(NULL),
+    names_size(0),
+    catalog(NULL),
+    db(NULL),
+    table(NULL),
+    orig_table(NULL),
+    name(NULL),
+    orig_name(NULL),
     charset(DRIZZLE_CHARSET_NONE),
     size(0),
     max_size(0),
     type(DRIZZLE_COLUMN_TYPE_NONE),
     flags(DRIZZLE_COLUMN_FLAGS_NONE),
     decimals(0),
+    default_value(NULL),
     default_value_size(0)
-  {
-    catalog[0]= '\0';
-    db[0]= '\0';
-    table[0]= '\0';
-    orig_table[0] ='\0';
-    name[0]= '\0';
-  }
+  { }
 };
 
 struct drizzle_stmt_st
@@ -508,11 +546,23 @@ struct drizzle_stmt_st
   drizzle_bind_st *query_params;
   drizzle_bind_st *result_params;
   uint16_t null_bitmap_length;
-  uint8_t *null_bitmap;
   bool new_bind;
+  /* The COM_STMT_EXECUTE packet, kept between executions */
+  unsigned char *execute_buffer;
+  size_t execute_buffer_size;
   drizzle_result_st *prepare_result;
   drizzle_result_st *execute_result;
   drizzle_column_st *fields;
+  /* Kept from the last execute result for the next one, which usually has
+     the same columns. result_params points to result_binds while a result
+     is being read. */
+  drizzle_column_st *column_cache;
+  uint16_t column_cache_count;
+  drizzle_arena_st column_cache_arena;
+  drizzle_bind_st *result_binds;
+  uint16_t result_bind_count;
+  /* Arrays bound for drizzle_stmt_execute_array(), NULL until one is */
+  drizzle_array_bind_st *array_params;
 
   drizzle_stmt_st() :
     con(NULL),
@@ -522,11 +572,122 @@ struct drizzle_stmt_st
     query_params(NULL),
     result_params(NULL),
     null_bitmap_length(0),
-    null_bitmap(NULL),
     new_bind(true),
+    execute_buffer(NULL),
+    execute_buffer_size(0),
     prepare_result(NULL),
     execute_result(NULL),
-    fields(NULL)
+    fields(NULL),
+    column_cache(NULL),
+    column_cache_count(0),
+    result_binds(NULL),
+    result_bind_count(0),
+    array_params(NULL)
+  { }
+};
+
+struct drizzle_reactor_st
+{
+  int epoll_fd;
+  drizzle_st **connections;
+  size_t connection_count;
+  size_t connection_allocation;
+  void *events;        /* epoll_event or pollfd array used while waiting */
+  size_t event_allocation;
+  struct drizzle_uring_st *uring; /* ring shared by the io_uring connections */
+  size_t uring_reads;             /* reads queued on 'uring' and not completed */
+  bool uring_epoll_armed;         /* 'epoll_fd' is polled through 'uring' */
+  drizzle_st **uring_ready;       /* connections whose read completed, not reported yet */
+  size_t uring_ready_count;
+  size_t uring_ready_allocation;
+
+  drizzle_reactor_st() :
+    epoll_fd(-1),
+    connections(NULL),
+    connection_count(0),
+    connection_allocation(0),
+    events(NULL),
+    event_allocation(0),
+    uring(NULL),
+    uring_reads(0),
+    uring_epoll_armed(false),
+    uring_ready(NULL),
+    uring_ready_count(0),
+    uring_ready_allocation(0)
+  { }
+};
+
+struct drizzle_uring_st
+{
+  int fd;
+  void *sq_ring;
+  size_t sq_ring_size;
+  void *cq_ring;
+  size_t cq_ring_size;
+  void *sqes;                 /* io_uring_sqe array */
+  size_t sqes_size;
+  unsigned *sq_head;
+  unsigned *sq_tail;
+  unsigned *sq_mask;
+  unsigned *sq_array;
+  unsigned *cq_head;
+  unsigned *cq_tail;
+  unsigned *cq_mask;
+  void *cqes;                 /* io_uring_cqe array */
+  unsigned char *registered;  /* start of the range registered as fixed buffer 0 */
+  size_t registered_size;
+  bool fixed_read;            /* false once registering or reading fixed buffers failed */
+  unsigned sq_entries;
+  unsigned cq_entries;
+  bool ext_arg;               /* waits can be bounded with IORING_ENTER_EXT_ARG */
+
+  drizzle_uring_st() :
+    fd(-1),
+    sq_ring(NULL),
+    sq_ring_size(0),
+    cq_ring(NULL),
+    cq_ring_size(0),
+    sqes(NULL),
+    sqes_size(0),
+    sq_head(NULL),
+    sq_tail(NULL),
+    sq_mask(NULL),
+    sq_array(NULL),
+    cq_head(NULL),
+    cq_tail(NULL),
+    cq_mask(NULL),
+    cqes(NULL),
+    registered(NULL),
+    registered_size(0),
+    fixed_read(true),
+    sq_entries(0),
+    cq_entries(0),
+    ext_arg(false)
+  { }
+};
+
+struct drizzle_compress_st
+{
+  uint8_t packet_number;    /* sequence number of the next compressed packet */
+  unsigned char *in;        /* compressed packets received from the socket */
+  size_t in_offset;         /* start of the first unprocessed packet in 'in' */
+  size_t in_size;           /* end of the received data in 'in' */
+  size_t in_allocation;
+  unsigned char *out;       /* compressed packets waiting to be sent */
+  size_t out_allocation;
+  void *deflate_stream;     /* z_stream or ZSTD_CCtx, created on first use */
+  void *inflate_stream;     /* z_stream or ZSTD_DCtx, created on first use */
+
+  drizzle_compress_st() :
+    packet_number(0),
+    in(NULL),
+    in_offset(0),
+    in_size(0),
+    in_allocation(0),
+    out(NULL),
+    out_allocation(0),
+    deflate_stream(NULL),
+    inflate_stream(NULL)
   { }
 };
 
@@ -537,9 +698,13 @@ struct drizzle_bind_st
   char *data_buffer;
   size_t length;  /* amount of data in 'data' */
   bool is_bound;
+  bool is_dirty;  /* value changed since it was last packed */
+  /* Where the value was last packed in the execute buffer */
+  size_t packed_offset;
+  size_t packed_length;
   struct options_t
   {
-    bool is_null;
+    bool is_null;       /* NULL value, a parameter keeps its type */
     bool is_unsigned;
     bool is_long_data;
 
@@ -553,12 +718,36 @@ struct drizzle_bind_st
     type(DRIZZLE_COLUMN_TYPE_NONE),
     data(NULL),
     length(0),
-    is_bound(false)
+    is_bound(false),
+    is_dirty(true),
+    packed_offset(0),
+    packed_length(0)
   {
     data_buffer= new (std::nothrow) char[128];
   }
 };
 
+struct drizzle_array_bind_st
+{
+  drizzle_column_type_t type;
+  const unsigned char *data;  /* value of the first row, NULL if not bound */
+  size_t stride;              /* distance between the values of two rows */
+  size_t size;                /* size of a fixed width value, 0 for strings */
+  const size_t *lengths;      /* lengths of the string values */
+  const bool *nulls;          /* rows where the value is NULL, may be NULL */
+  bool is_unsigned;
+
+  drizzle_array_bind_st() :
+    type(DRIZZLE_COLUMN_TYPE_NONE),
+    data(NULL),
+    stride(0),
+    size(0),
+    lengths(NULL),
+    nulls(NULL),
+    is_unsigned(false)
+  { }
+};
+
 #ifdef __cplusplus
 }
 #endif
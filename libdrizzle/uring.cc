@@ -0,0 +1,680 @@
+/* vim:expandtab:shiftwidth=2:tabstop=2:smarttab:
+ *
+ * Drizzle Client & Protocol Library
+ *
+ * Copyright (C) 2012-2013 Drizzle Developer Group
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following disclaimer
+ * in the documentation and/or other materials provided with the
+ * distribution.
+ *
+ *     * The names of its contributors may not be used to endorse or
+ * promote products derived from this software without specific prior
+ * written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/**
+ * @file
+ * @brief io_uring Socket I/O Definitions
+ */
+
+#include "config.h"
+#include "libdrizzle/common.h"
+
+#if defined(HAVE_LINUX_IO_URING_H) && HAVE_LINUX_IO_URING_H
+# include <linux/io_uring.h>
+# include <sys/mman.h>
+# include <sys/syscall.h>
+/* IORING_FEAT_FAST_POLL comes with the kernel headers that also know
+   IORING_OP_RECV, IORING_OP_SENDMSG and IORING_OP_LINK_TIMEOUT. */
+# if defined(IORING_FEAT_FAST_POLL) && defined(__NR_io_uring_setup)
+#  define DRIZZLE_URING 1
+# endif
+#endif
+
+#ifdef DRIZZLE_URING
+
+/* Room for one operation and its linked timeout. */
+#define DRIZZLE_URING_ENTRIES 4
+
+/* Reads of the connections of a reactor queued between two waits. */
+#define DRIZZLE_URING_SHARED_ENTRIES 256
+
+#define DRIZZLE_URING_DATA_IO 1
+#define DRIZZLE_URING_DATA_TIMEOUT 2
+
+/**
+ * @addtogroup drizzle_uring_static Static io_uring Socket I/O Declarations
+ * @ingroup drizzle_uring
+ * @{
+ */
+
+/**
+ * Unmap the rings and close the ring descriptor.
+ *
+ * @param[in] ring A ring, possibly partially set up.
+ */
+static void _ring_release(drizzle_uring_st *ring)
+{
+  if (ring->sqes != NULL)
+  {
+    munmap(ring->sqes, ring->sqes_size);
+  }
+  if (ring->cq_ring != NULL)
+  {
+    munmap(ring->cq_ring, ring->cq_ring_size);
+  }
+  if (ring->sq_ring != NULL)
+  {
+    munmap(ring->sq_ring, ring->sq_ring_size);
+  }
+  if (ring->fd != -1)
+  {
+    close(ring->fd);
+  }
+}
+
+/**
+ * Map one of the ring regions.
+ *
+ * @param[in] fd Ring descriptor.
+ * @param[in] size Size of the region.
+ * @param[in] offset One of the IORING_OFF_* offsets.
+ * @return Start of the mapping, or NULL on failure.
+ */
+static void *_ring_map(int fd, size_t size, off_t offset)
+{
+  void *ptr= mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                  fd, offset);
+  if (ptr == MAP_FAILED)
+  {
+    return NULL;
+  }
+
+  return ptr;
+}
+
+/**
+ * Set up a ring and map its queues.
+ *
+ * @param[in] entries Number of submission queue entries.
+ * @param[in] single_issuer Only the thread creating the ring submits to it
+ *  and reaps its completions.
+ * @return A new ring, or NULL with errno set.
+ */
+static drizzle_uring_st *_ring_create(unsigned entries, bool single_issuer)
+{
+  struct io_uring_params params;
+  drizzle_uring_st *ring= new (std::nothrow) drizzle_uring_st;
+  if (ring == NULL)
+  {
+    errno= ENOMEM;
+    return NULL;
+  }
+
+  memset(&params, 0, sizeof(params));
+#if defined(IORING_SETUP_SINGLE_ISSUER) && defined(IORING_SETUP_DEFER_TASKRUN)
+  if (single_issuer)
+  {
+    /* Completions are only ever reaped by the thread waiting for them. */
+    params.flags= IORING_SETUP_SINGLE_ISSUER | IORING_SETUP_DEFER_TASKRUN;
+    ring->fd= (int)syscall(__NR_io_uring_setup, entries, &params);
+    if (ring->fd == -1 && errno == EINVAL)
+    {
+      memset(&params, 0, sizeof(params));
+    }
+  }
+#else
+  (void)single_issuer;
+#endif
+  if (ring->fd == -1)
+  {
+    ring->fd= (int)syscall(__NR_io_uring_setup, entries, &params);
+  }
+  if (ring->fd == -1 || (params.features & IORING_FEAT_FAST_POLL) == 0)
+  {
+    /* Without fast poll socket operations are punted to kernel threads. */
+    int saved_errno= (ring->fd == -1) ? errno : ENOTSUP;
+    _ring_release(ring);
+    delete ring;
+    errno= saved_errno;
+    return NULL;
+  }
+
+  ring->sq_entries= params.sq_entries;
+  ring->cq_entries= params.cq_entries;
+#ifdef IORING_FEAT_EXT_ARG
+  ring->ext_arg= (params.features & IORING_FEAT_EXT_ARG) != 0;
+#endif
+  ring->sq_ring_size= params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  ring->cq_ring_size= params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+  ring->sqes_size= params.sq_entries * sizeof(struct io_uring_sqe);
+
+  ring->sq_ring= _ring_map(ring->fd, ring->sq_ring_size, IORING_OFF_SQ_RING);
+  ring->cq_ring= _ring_map(ring->fd, ring->cq_ring_size, IORING_OFF_CQ_RING);
+  ring->sqes= _ring_map(ring->fd, ring->sqes_size, IORING_OFF_SQES);
+  if (ring->sq_ring == NULL || ring->cq_ring == NULL || ring->sqes == NULL)
+  {
+    int saved_errno= errno;
+    _ring_release(ring);
+    delete ring;
+    errno= saved_errno;
+    return NULL;
+  }
+
+  unsigned char *sq= (unsigned char *)ring->sq_ring;
+  unsigned char *cq= (unsigned char *)ring->cq_ring;
+  ring->sq_head= (unsigned *)(sq + params.sq_off.head);
+  ring->sq_tail= (unsigned *)(sq + params.sq_off.tail);
+  ring->sq_mask= (unsigned *)(sq + params.sq_off.ring_mask);
+  ring->sq_array= (unsigned *)(sq + params.sq_off.array);
+  ring->cq_head= (unsigned *)(cq + params.cq_off.head);
+  ring->cq_tail= (unsigned *)(cq + params.cq_off.tail);
+  ring->cq_mask= (unsigned *)(cq + params.cq_off.ring_mask);
+  ring->cqes= cq + params.cq_off.cqes;
+
+  return ring;
+}
+
+/**
+ * Submit the queued operations and optionally wait for completions.
+ *
+ * @param[in] ring A ring.
+ * @param[in] wait_nr Number of completions to wait for.
+ * @param[in] timeout Longest wait in milliseconds, or -1 to wait forever.
+ *  Needs IORING_FEAT_EXT_ARG.
+ * @return 0 on success, or -1 with errno set, ETIME if the timeout expired.
+ */
+static int _ring_enter(drizzle_uring_st *ring, unsigned wait_nr, int timeout)
+{
+  unsigned submit= *ring->sq_tail - __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE);
+  unsigned flags= 0;
+  void *arg= NULL;
+  size_t arg_size= 0;
+
+  if (wait_nr != 0)
+  {
+    flags|= IORING_ENTER_GETEVENTS;
+  }
+
+#ifdef IORING_ENTER_EXT_ARG
+  struct io_uring_getevents_arg getevents;
+  struct __kernel_timespec ts;
+
+  if (wait_nr != 0 && timeout >= 0)
+  {
+    ts.tv_sec= timeout / 1000;
+    ts.tv_nsec= (timeout % 1000) * 1000000;
+    memset(&getevents, 0, sizeof(getevents));
+    getevents.ts= (uint64_t)(uintptr_t)&ts;
+    flags|= IORING_ENTER_EXT_ARG;
+    arg= &getevents;
+    arg_size= sizeof(getevents);
+  }
+#else
+  (void)timeout;
+#endif
+
+  if (syscall(__NR_io_uring_enter, ring->fd, submit, wait_nr, flags, arg, arg_size) == -1)
+  {
+    return -1;
+  }
+
+  return 0;
+}
+
+/**
+ * Take the next submission queue entry. The ring is only used for one
+ * operation at a time, so there is always room.
+ *
+ * @param[in] ring A ring.
+ * @return A cleared submission queue entry.
+ */
+static struct io_uring_sqe *_ring_next_sqe(drizzle_uring_st *ring)
+{
+  unsigned tail= *ring->sq_tail;
+  unsigned index= tail & *ring->sq_mask;
+  struct io_uring_sqe *sqe= (struct io_uring_sqe *)ring->sqes + index;
+
+  memset(sqe, 0, sizeof(*sqe));
+  ring->sq_array[index]= index;
+  __atomic_store_n(ring->sq_tail, tail + 1, __ATOMIC_RELEASE);
+
+  return sqe;
+}
+
+/**
+ * Submit the operation queued with _ring_next_sqe(), bounded by the
+ * connection timeout, and wait for it to complete.
+ *
+ * @param[in] con Connection structure with a ring.
+ * @param[in] sqe The queued operation.
+ * @return The operation result, or -1 with errno set.
+ */
+static ssize_t _ring_complete(drizzle_st *con, struct io_uring_sqe *sqe)
+{
+  drizzle_uring_st *ring= con->uring;
+  struct __kernel_timespec timeout;
+  unsigned expected= 1;
+  int result= -ECANCELED;
+  bool timed_out= false;
+
+  sqe->user_data= DRIZZLE_URING_DATA_IO;
+
+  if (con->timeout >= 0)
+  {
+    timeout.tv_sec= con->timeout / 1000;
+    timeout.tv_nsec= (con->timeout % 1000) * 1000000;
+
+    sqe->flags|= IOSQE_IO_LINK;
+
+    struct io_uring_sqe *link= _ring_next_sqe(ring);
+    link->opcode= IORING_OP_LINK_TIMEOUT;
+    link->addr= (uint64_t)(uintptr_t)&timeout;
+    link->len= 1;
+    link->user_data= DRIZZLE_URING_DATA_TIMEOUT;
+    expected= 2;
+  }
+
+  while (expected != 0)
+  {
+    unsigned submit= *ring->sq_tail - __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE);
+
+    if (syscall(__NR_io_uring_enter, ring->fd, submit, expected,
+                IORING_ENTER_GETEVENTS, NULL, 0) == -1)
+    {
+      if (errno == EINTR)
+      {
+        continue;
+      }
+
+      /* Drop whatever the kernel did not take so the next operation
+         starts from an empty queue. */
+      int saved_errno= errno;
+      __atomic_store_n(ring->sq_tail, __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE),
+                       __ATOMIC_RELEASE);
+      errno= saved_errno;
+      return -1;
+    }
+
+    unsigned head= *ring->cq_head;
+    unsigned tail= __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE);
+
+    while (head != tail && expected != 0)
+    {
+      struct io_uring_cqe *cqe= (struct io_uring_cqe *)ring->cqes + (head & *ring->cq_mask);
+
+      if (cqe->user_data == DRIZZLE_URING_DATA_IO)
+      {
+        result= cqe->res;
+      }
+      else if (cqe->res == -ETIME)
+      {
+        timed_out= true;
+      }
+
+      head++;
+      expected--;
+    }
+
+    __atomic_store_n(ring->cq_head, head, __ATOMIC_RELEASE);
+  }
+
+  if (result >= 0)
+  {
+    return result;
+  }
+
+  errno= (timed_out && result == -ECANCELED) ? ETIME : -result;
+
+  return -1;
+}
+
+/**
+ * Register the connection buffer as fixed buffer 0, unless it already is.
+ * The whole mirror is registered so reads may wrap around the ring.
+ *
+ * @param[in] con Connection structure with a ring.
+ * @return true if reads can use the fixed buffer.
+ */
+static bool _ring_register(drizzle_st *con)
+{
+  drizzle_uring_st *ring= con->uring;
+  size_t size= con->buffer_allocation;
+
+  if (con->buffer_mirrored)
+  {
+    size*= 2;
+  }
+
+  if (ring->registered == con->buffer && ring->registered_size == size)
+  {
+    return true;
+  }
+
+  drizzle_uring_unregister(con);
+
+  struct iovec iov;
+  iov.iov_base= con->buffer;
+  iov.iov_len= size;
+
+  /* Pinned pages count against RLIMIT_MEMLOCK on many systems, fall back
+     to plain receives rather than failing. */
+  if (syscall(__NR_io_uring_register, ring->fd, IORING_REGISTER_BUFFERS, &iov, 1) == -1)
+  {
+    drizzle_log_debug(con, "io_uring buffer registration failed: %s", strerror(errno));
+    ring->fixed_read= false;
+    return false;
+  }
+
+  ring->registered= con->buffer;
+  ring->registered_size= size;
+
+  return true;
+}
+
+/**
+ * Take the next submission queue entry of a shared ring, submitting the
+ * queued operations first if the queue is full.
+ *
+ * @param[in] ring A shared ring.
+ * @return A cleared submission queue entry, or NULL with errno set.
+ */
+static struct io_uring_sqe *_ring_queue(drizzle_uring_st *ring)
+{
+  while (*ring->sq_tail - __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE) >= ring->sq_entries)
+  {
+    if (_ring_enter(ring, 0, -1) == -1 && errno != EINTR)
+    {
+      return NULL;
+    }
+  }
+
+  return _ring_next_sqe(ring);
+}
+
+/** @} */
+
+#endif // DRIZZLE_URING
+
+/*
+ * Local Definitions
+ */
+
+bool drizzle_uring_create(drizzle_st *con)
+{
+#ifdef DRIZZLE_URING
+  con->uring= _ring_create(DRIZZLE_URING_ENTRIES, true);
+
+  return con->uring != NULL;
+#else
+  (void)con;
+  errno= ENOSYS;
+  return false;
+#endif
+}
+
+void drizzle_uring_free(drizzle_st *con)
+{
+  if (con == NULL || con->uring == NULL)
+  {
+    return;
+  }
+
+  /* Closing the ring also drops the buffer registration. */
+  drizzle_uring_shared_free(con->uring);
+  con->uring= NULL;
+}
+
+void drizzle_uring_unregister(drizzle_st *con)
+{
+#ifdef DRIZZLE_URING
+  drizzle_uring_st *ring= con->uring;
+
+  if (ring->registered != NULL)
+  {
+    (void)syscall(__NR_io_uring_register, ring->fd, IORING_UNREGISTER_BUFFERS, NULL, 0);
+    ring->registered= NULL;
+    ring->registered_size= 0;
+  }
+#else
+  (void)con;
+#endif
+}
+
+ssize_t drizzle_uring_recv(drizzle_st *con, unsigned char *data, size_t size)
+{
+#ifdef DRIZZLE_URING
+  drizzle_uring_st *ring= con->uring;
+  /* Compressed packets are received outside the connection buffer. */
+  bool fixed= ring->fixed_read && data >= con->buffer &&
+              data < con->buffer + con->buffer_allocation && _ring_register(con);
+  struct io_uring_sqe *sqe= _ring_next_sqe(ring);
+
+  if (fixed)
+  {
+    sqe->opcode= IORING_OP_READ_FIXED;
+    sqe->off= (uint64_t)-1;
+    sqe->buf_index= 0;
+  }
+  else
+  {
+    sqe->opcode= IORING_OP_RECV;
+  }
+  sqe->fd= con->fd;
+  sqe->addr= (uint64_t)(uintptr_t)data;
+  sqe->len= (uint32_t)(size > UINT32_MAX ? UINT32_MAX : size);
+
+  ssize_t ret= _ring_complete(con, sqe);
+  if (ret == -1 && fixed &&
+      (errno == EINVAL || errno == EOPNOTSUPP))
+  {
+    /* Kernels that cannot read sockets into fixed buffers. */
+    drizzle_uring_unregister(con);
+    ring->fixed_read= false;
+    return drizzle_uring_recv(con, data, size);
+  }
+
+  return ret;
+#else
+  (void)con;
+  (void)data;
+  (void)size;
+  errno= ENOSYS;
+  return -1;
+#endif
+}
+
+ssize_t drizzle_uring_sendmsg(drizzle_st *con, const struct msghdr *msg)
+{
+#ifdef DRIZZLE_URING
+  struct io_uring_sqe *sqe= _ring_next_sqe(con->uring);
+
+  sqe->opcode= IORING_OP_SENDMSG;
+  sqe->fd= con->fd;
+  sqe->addr= (uint64_t)(uintptr_t)msg;
+  sqe->len= 1;
+  sqe->msg_flags= MSG_NOSIGNAL;
+
+  return _ring_complete(con, sqe);
+#else
+  (void)con;
+  (void)msg;
+  errno= ENOSYS;
+  return -1;
+#endif
+}
+
+drizzle_uring_st *drizzle_uring_shared_create(void)
+{
+#ifdef DRIZZLE_URING
+  drizzle_uring_st *ring= _ring_create(DRIZZLE_URING_SHARED_ENTRIES, false);
+  if (ring != NULL && ring->ext_arg == false)
+  {
+    /* Waiting with a timeout needs IORING_ENTER_EXT_ARG. */
+    drizzle_uring_shared_free(ring);
+    errno= ENOTSUP;
+    return NULL;
+  }
+
+  return ring;
+#else
+  errno= ENOSYS;
+  return NULL;
+#endif
+}
+
+void drizzle_uring_shared_free(drizzle_uring_st *ring)
+{
+  if (ring == NULL)
+  {
+    return;
+  }
+
+#ifdef DRIZZLE_URING
+  _ring_release(ring);
+#endif
+  delete ring;
+}
+
+size_t drizzle_uring_memory(const drizzle_uring_st *ring)
+{
+  return sizeof(drizzle_uring_st) + ring->sq_ring_size + ring->cq_ring_size +
+         ring->sqes_size;
+}
+
+bool drizzle_uring_queue_recv(drizzle_uring_st *ring, socket_t fd,
+                              unsigned char *data, size_t size,
+                              uint64_t user_data)
+{
+#ifdef DRIZZLE_URING
+  struct io_uring_sqe *sqe= _ring_queue(ring);
+  if (sqe == NULL)
+  {
+    return false;
+  }
+
+  sqe->opcode= IORING_OP_RECV;
+  sqe->fd= fd;
+  sqe->addr= (uint64_t)(uintptr_t)data;
+  sqe->len= (uint32_t)(size > UINT32_MAX ? UINT32_MAX : size);
+  sqe->user_data= user_data;
+
+  return true;
+#else
+  (void)ring;
+  (void)fd;
+  (void)data;
+  (void)size;
+  (void)user_data;
+  errno= ENOSYS;
+  return false;
+#endif
+}
+
+bool drizzle_uring_queue_poll(drizzle_uring_st *ring, int fd, uint64_t user_data)
+{
+#ifdef DRIZZLE_URING
+  struct io_uring_sqe *sqe= _ring_queue(ring);
+  if (sqe == NULL)
+  {
+    return false;
+  }
+
+  sqe->opcode= IORING_OP_POLL_ADD;
+  sqe->fd= fd;
+  sqe->poll_events= POLLIN;
+  sqe->user_data= user_data;
+
+  return true;
+#else
+  (void)ring;
+  (void)fd;
+  (void)user_data;
+  errno= ENOSYS;
+  return false;
+#endif
+}
+
+bool drizzle_uring_queue_cancel(drizzle_uring_st *ring, uint64_t target,
+                                uint64_t user_data)
+{
+#ifdef DRIZZLE_URING
+  struct io_uring_sqe *sqe= _ring_queue(ring);
+  if (sqe == NULL)
+  {
+    return false;
+  }
+
+  sqe->opcode= IORING_OP_ASYNC_CANCEL;
+  sqe->fd= -1;
+  sqe->addr= target;
+  sqe->user_data= user_data;
+
+  return true;
+#else
+  (void)ring;
+  (void)target;
+  (void)user_data;
+  errno= ENOSYS;
+  return false;
+#endif
+}
+
+int drizzle_uring_wait(drizzle_uring_st *ring, int timeout)
+{
+#ifdef DRIZZLE_URING
+  return _ring_enter(ring, 1, timeout);
+#else
+  (void)ring;
+  (void)timeout;
+  errno= ENOSYS;
+  return -1;
+#endif
+}
+
+bool drizzle_uring_reap(drizzle_uring_st *ring, uint64_t *user_data, int32_t *res)
+{
+#ifdef DRIZZLE_URING
+  unsigned head= *ring->cq_head;
+
+  if (head == __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE))
+  {
+    return false;
+  }
+
+  struct io_uring_cqe *cqe= (struct io_uring_cqe *)ring->cqes + (head & *ring->cq_mask);
+  *user_data= cqe->user_data;
+  *res= cqe->res;
+  __atomic_store_n(ring->cq_head, head + 1, __ATOMIC_RELEASE);
+
+  return true;
+#else
+  (void)ring;
+  (void)user_data;
+  (void)res;
+  return false;
+#endif
+}
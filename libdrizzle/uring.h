@@ -0,0 +1,202 @@
+/* vim:expandtab:shiftwidth=2:tabstop=2:smarttab:
+ *
+ * Drizzle Client & Protocol Library
+ *
+ * Copyright (C) 2012-2013 Drizzle Developer Group
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following disclaimer
+ * in the documentation and/or other materials provided with the
+ * distribution.
+ *
+ *     * The names of its contributors may not be used to endorse or
+ * promote products derived from this software without specific prior
+ * written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#pragma once
+
+/**
+ * @file
+ * @brief io_uring Socket I/O Declarations
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @addtogroup drizzle_uring io_uring Socket I/O Declarations
+ * @ingroup drizzle_con
+ *
+ * Blocking connections created with drizzle_options_set_io_uring() move
+ * their socket reads and writes onto a small private io_uring. Submitting
+ * an operation and waiting for it is a single io_uring_enter() call, where
+ * the socket calls cost a recv() returning EAGAIN, a poll() and a second
+ * recv(). Reads go into the connection buffer registered as a fixed buffer
+ * when the kernel allows it. The functions mirror recv() and sendmsg(): they
+ * return the byte count, or -1 with errno set, so the callers keep their
+ * error handling. ETIME reports that the connection timeout expired.
+ *
+ * A reactor owns one larger ring shared by its non-blocking io_uring
+ * connections. Instead of waiting for POLLIN and then calling recv(), a
+ * connection queues its read into the free part of the connection buffer,
+ * and drizzle_reactor_wait() submits all queued reads and reaps their
+ * completions with a single io_uring_enter(). The epoll set of the other
+ * connections is polled through the same ring. The shared ring functions
+ * take the ring itself, the reactor decides what the user data of each
+ * operation means.
+ * @{
+ */
+
+/**
+ * Set up the ring of a connection.
+ *
+ * @param[in] con Connection structure previously initialized with
+ *  drizzle_create(), drizzle_clone(), or related functions.
+ * @return true on success, false with errno set if io_uring is not
+ *  available, in which case the plain socket calls keep being used.
+ */
+bool drizzle_uring_create(drizzle_st *con);
+
+/**
+ * Tear down the ring of a connection, if any.
+ *
+ * @param[in] con Connection structure previously initialized with
+ *  drizzle_create(), drizzle_clone(), or related functions.
+ */
+void drizzle_uring_free(drizzle_st *con);
+
+/**
+ * Drop the fixed buffer registration. Must be called before the connection
+ * buffer is released or replaced.
+ *
+ * @param[in] con Connection structure with a ring.
+ */
+void drizzle_uring_unregister(drizzle_st *con);
+
+/**
+ * Receive data on the connection socket.
+ *
+ * @param[in] con Connection structure with a ring.
+ * @param[out] data Where to store the data, inside the connection buffer.
+ * @param[in] size Maximum number of bytes to read.
+ * @return Number of bytes read, 0 at end of stream, or -1 with errno set.
+ */
+ssize_t drizzle_uring_recv(drizzle_st *con, unsigned char *data, size_t size);
+
+/**
+ * Send a message on the connection socket.
+ *
+ * @param[in] con Connection structure with a ring.
+ * @param[in] msg Message to send, as for sendmsg().
+ * @return Number of bytes sent, or -1 with errno set.
+ */
+ssize_t drizzle_uring_sendmsg(drizzle_st *con, const struct msghdr *msg);
+
+/**
+ * Set up a ring shared by the connections of a reactor.
+ *
+ * @return A new ring, or NULL with errno set if io_uring is not available.
+ */
+drizzle_uring_st *drizzle_uring_shared_create(void);
+
+/**
+ * Tear down a ring.
+ *
+ * @param[in] ring A ring, or NULL.
+ */
+void drizzle_uring_shared_free(drizzle_uring_st *ring);
+
+/**
+ * Get the memory held by a ring: its structure and the mapped queues.
+ *
+ * @param[in] ring A ring.
+ * @return Size in bytes.
+ */
+size_t drizzle_uring_memory(const drizzle_uring_st *ring);
+
+/**
+ * Queue a receive on a shared ring. It is submitted by the next call to
+ * drizzle_uring_wait(), or earlier if the submission queue fills up.
+ *
+ * @param[in] ring A shared ring.
+ * @param[in] fd Socket to read from.
+ * @param[out] data Where to store the data.
+ * @param[in] size Maximum number of bytes to read.
+ * @param[in] user_data Value reported with the completion.
+ * @return true on success, false with errno set.
+ */
+bool drizzle_uring_queue_recv(drizzle_uring_st *ring, socket_t fd,
+                              unsigned char *data, size_t size,
+                              uint64_t user_data);
+
+/**
+ * Queue a one-shot POLLIN poll of a descriptor on a shared ring.
+ *
+ * @param[in] ring A shared ring.
+ * @param[in] fd Descriptor to poll.
+ * @param[in] user_data Value reported with the completion.
+ * @return true on success, false with errno set.
+ */
+bool drizzle_uring_queue_poll(drizzle_uring_st *ring, int fd, uint64_t user_data);
+
+/**
+ * Queue the cancellation of an operation on a shared ring. The cancelled
+ * operation still reports a completion, usually with -ECANCELED.
+ *
+ * @param[in] ring A shared ring.
+ * @param[in] target User data of the operation to cancel.
+ * @param[in] user_data Value reported with the completion of the
+ *  cancellation itself.
+ * @return true on success, false with errno set.
+ */
+bool drizzle_uring_queue_cancel(drizzle_uring_st *ring, uint64_t target,
+                                uint64_t user_data);
+
+/**
+ * Submit the queued operations of a shared ring and wait until at least
+ * one completion is available.
+ *
+ * @param[in] ring A shared ring.
+ * @param[in] timeout Timeout in milliseconds, or -1 to wait forever.
+ * @return 0 on success, or -1 with errno set, ETIME if the timeout expired.
+ */
+int drizzle_uring_wait(drizzle_uring_st *ring, int timeout);
+
+/**
+ * Take the next completion of a shared ring.
+ *
+ * @param[in] ring A shared ring.
+ * @param[out] user_data User data of the completed operation.
+ * @param[out] res Its result, a negative errno on failure.
+ * @return false if no completion is available.
+ */
+bool drizzle_uring_reap(drizzle_uring_st *ring, uint64_t *user_data, int32_t *res);
+
+/** @} */
+
+#ifdef __cplusplus
+}
+#endif
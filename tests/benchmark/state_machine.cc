@@ -0,0 +1,163 @@
+/* vim:expandtab:shiftwidth=2:tabstop=2:smarttab:
+ *
+ * Drizzle Client & Protocol Library
+ *
+ * Copyright (C) 2013 Drizzle Developer Group
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following disclaimer
+ * in the documentation and/or other materials provided with the
+ * distribution.
+ *
+ *     * The names of its contributors may not be used to endorse or
+ * promote products derived from this software without specific prior
+ * written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/*
+ * Runs synthetic states through drizzle_state_loop() the way reading a
+ * result does: a result state that stays at the bottom of the stack, and
+ * for every row a row state and a packet state, then a field state per
+ * column pushed one after the other. The states do no work of their own,
+ * so the time is that of pushing, popping and dispatching, reported as
+ * state transitions per second.
+ *
+ * BENCH_ROWS sets the number of rows (default 10000000), BENCH_COLUMNS the
+ * number of fields per row (default 4). No server is needed, the states
+ * only use the connection structure. Exits with a failure if the loop does
+ * not run the expected number of states.
+ */
+
+#include "config.h"
+#include "libdrizzle/common.h"
+
+#include <inttypes.h>
+#include <time.h>
+
+static uint64_t bench_rows;
+static uint64_t bench_columns;
+static uint64_t rows_left;
+static uint64_t fields_left;
+static uint64_t transitions;
+
+static double now(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec / 1000000000;
+}
+
+static drizzle_return_t bench_state_field(drizzle_st *con)
+{
+  transitions++;
+  con->pop_state();
+  if (--fields_left)
+  {
+    con->push_state(bench_state_field);
+  }
+
+  return DRIZZLE_RETURN_OK;
+}
+
+static drizzle_return_t bench_state_packet(drizzle_st *con)
+{
+  transitions++;
+  con->pop_state();
+  return DRIZZLE_RETURN_OK;
+}
+
+static drizzle_return_t bench_state_row(drizzle_st *con)
+{
+  transitions++;
+  con->pop_state();
+  fields_left= bench_columns;
+  con->push_state(bench_state_field);
+  return DRIZZLE_RETURN_OK;
+}
+
+static drizzle_return_t bench_state_result(drizzle_st *con)
+{
+  transitions++;
+  if (rows_left == 0)
+  {
+    con->pop_state();
+    return DRIZZLE_RETURN_OK;
+  }
+
+  rows_left--;
+  con->push_state(bench_state_row);
+  con->push_state(bench_state_packet);
+  return DRIZZLE_RETURN_OK;
+}
+
+int main(void)
+{
+  bench_rows= getenv("BENCH_ROWS") ? strtoull(getenv("BENCH_ROWS"), NULL, 10)
+                                   : 10000000;
+  bench_columns= getenv("BENCH_COLUMNS") ? strtoull(getenv("BENCH_COLUMNS"), NULL, 10)
+                                         : 4;
+  if (bench_columns == 0)
+  {
+    bench_columns= 1;
+  }
+
+  drizzle_st *con= drizzle_create(NULL, 0, NULL, NULL, NULL, NULL);
+  if (con == NULL)
+  {
+    fprintf(stderr, "drizzle_create() failed\n");
+    return EXIT_FAILURE;
+  }
+
+  double best= 0;
+  for (int run= 0; run < 3; run++)
+  {
+    rows_left= bench_rows;
+    transitions= 0;
+
+    double start= now();
+    con->push_state(bench_state_result);
+    drizzle_return_t ret= drizzle_state_loop(con);
+    double elapsed= now() - start;
+
+    uint64_t expected= bench_rows * (bench_columns + 3) + 1;
+    if (ret != DRIZZLE_RETURN_OK || transitions != expected)
+    {
+      fprintf(stderr, "ran %" PRIu64 " states instead of %" PRIu64 " (%s)\n",
+              transitions, expected, drizzle_strerror(ret));
+      return EXIT_FAILURE;
+    }
+
+    if (run == 0 || elapsed < best)
+    {
+      best= elapsed;
+    }
+  }
+
+  printf("%" PRIu64 " rows of %" PRIu64 " fields: %.1f million state transitions per second\n",
+         bench_rows, bench_columns,
+         (double)(bench_rows * (bench_columns + 3) + 1) / best / 1000000);
+
+  drizzle_free(con);
+  return EXIT_SUCCESS;
+}
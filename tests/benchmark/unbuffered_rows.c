@@ -0,0 +1,254 @@
+/* vim:expandtab:shiftwidth=2:tabstop=2:smarttab:
+ *
+ * Drizzle Client & Protocol Library
+ *
+ * Copyright (C) 2013 Drizzle Developer Group
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following disclaimer
+ * in the documentation and/or other materials provided with the
+ * distribution.
+ *
+ *     * The names of its contributors may not be used to endorse or
+ * promote products derived from this software without specific prior
+ * written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/*
+ * Reads the rows of a result one at a time with drizzle_row_buffer(),
+ * drizzle_row_view() and drizzle_stmt_fetch(), and reports the time and the
+ * number of heap allocations per row once the first row has been read.
+ *
+ * BENCH_ROWS sets the number of rows (default 100000), the connection is
+ * set up from MYSQL_SERVER, MYSQL_PORT, MYSQL_USER and MYSQL_PASSWORD as for
+ * the unit tests. Exits with a failure if reading a row allocates memory.
+ */
+
+#include <libdrizzle-5.1/libdrizzle.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef __GLIBC__
+/* Count every allocation made by the library and the C++ runtime. The
+   counting functions must be visible to the library when the program is
+   built with hidden symbols. */
+#define BENCH_EXPORT __attribute__((visibility("default")))
+
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t count, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+
+static uint64_t allocations= 0;
+
+BENCH_EXPORT void *malloc(size_t size)
+{
+  allocations++;
+  return __libc_malloc(size);
+}
+
+BENCH_EXPORT void *calloc(size_t count, size_t size)
+{
+  allocations++;
+  return __libc_calloc(count, size);
+}
+
+BENCH_EXPORT void *realloc(void *ptr, size_t size)
+{
+  allocations++;
+  return __libc_realloc(ptr, size);
+}
+#define ALLOCATIONS_COUNTED 1
+#else
+static uint64_t allocations= 0;
+#define ALLOCATIONS_COUNTED 0
+#endif
+
+#define BENCH_QUERY_SIZE 256
+
+enum bench_mode_t
+{
+  BENCH_ROW_BUFFER,
+  BENCH_ROW_VIEW,
+  BENCH_STMT_FETCH
+};
+
+static const char *bench_mode_name[]= {
+  "drizzle_row_buffer",
+  "drizzle_row_view",
+  "drizzle_stmt_fetch"
+};
+
+static double now(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec / 1000000000;
+}
+
+static void fail(drizzle_st *con, const char *what, drizzle_return_t ret)
+{
+  fprintf(stderr, "%s: %s (%s)\n", what, drizzle_error(con),
+          drizzle_strerror(ret));
+  exit(EXIT_FAILURE);
+}
+
+/* Read every row, return the allocations made after the first one. */
+static uint64_t bench(drizzle_st *con, enum bench_mode_t mode,
+                      const char *query, uint64_t rows)
+{
+  drizzle_return_t ret;
+  drizzle_result_st *result= NULL;
+  drizzle_stmt_st *stmt= NULL;
+  uint64_t count= 0;
+  uint64_t first_allocations= 0;
+  size_t bytes= 0;
+
+  if (mode == BENCH_STMT_FETCH)
+  {
+    stmt= drizzle_stmt_prepare(con, query, strlen(query), &ret);
+    if (ret != DRIZZLE_RETURN_OK)
+      fail(con, "drizzle_stmt_prepare", ret);
+    ret= drizzle_stmt_execute(stmt);
+    if (ret != DRIZZLE_RETURN_OK)
+      fail(con, "drizzle_stmt_execute", ret);
+  }
+  else
+  {
+    result= drizzle_query(con, query, 0, &ret);
+    if (ret != DRIZZLE_RETURN_OK)
+      fail(con, "drizzle_query", ret);
+    ret= drizzle_column_buffer(result);
+    if (ret != DRIZZLE_RETURN_OK)
+      fail(con, "drizzle_column_buffer", ret);
+  }
+
+  double start= now();
+  while (1)
+  {
+    if (mode == BENCH_STMT_FETCH)
+    {
+      ret= drizzle_stmt_fetch(stmt);
+      if (ret == DRIZZLE_RETURN_ROW_END)
+        break;
+      if (ret != DRIZZLE_RETURN_OK)
+        fail(con, "drizzle_stmt_fetch", ret);
+      bytes+= (size_t)drizzle_stmt_get_bigint(stmt, 0, &ret);
+    }
+    else
+    {
+      drizzle_row_t row= mode == BENCH_ROW_VIEW ? drizzle_row_view(result, &ret)
+                                                : drizzle_row_buffer(result, &ret);
+      if (ret != DRIZZLE_RETURN_OK)
+        fail(con, bench_mode_name[mode], ret);
+      if (row == NULL)
+        break;
+      bytes+= drizzle_row_field_sizes(result)[1];
+      drizzle_row_free(result, row);
+    }
+
+    if (count++ == 0)
+    {
+      first_allocations= allocations;
+    }
+  }
+  double elapsed= now() - start;
+  uint64_t steady= allocations - first_allocations;
+
+  if (count != rows)
+  {
+    fprintf(stderr, "%s: read %" PRIu64 " rows, expected %" PRIu64 "\n",
+            bench_mode_name[mode], count, rows);
+    exit(EXIT_FAILURE);
+  }
+
+  printf("%-20s %8.1f ns/row %12" PRIu64 " allocations after the first row "
+         "(%zu bytes)\n", bench_mode_name[mode],
+         elapsed * 1000000000 / (double)(count ? count : 1), steady, bytes);
+
+  if (stmt)
+  {
+    drizzle_stmt_close(stmt);
+  }
+  else
+  {
+    drizzle_result_free(result);
+  }
+
+  return steady;
+}
+
+int main(int argc, char *argv[])
+{
+  (void)argc;
+  (void)argv;
+  drizzle_return_t ret;
+  uint64_t rows= getenv("BENCH_ROWS") ? strtoull(getenv("BENCH_ROWS"), NULL, 10)
+                                      : 100000;
+  char query[BENCH_QUERY_SIZE];
+  char setting[BENCH_QUERY_SIZE];
+
+  drizzle_st *con= drizzle_create(getenv("MYSQL_SERVER"),
+                                  getenv("MYSQL_PORT") ? atoi(getenv("MYSQL_PORT"))
+                                                       : DRIZZLE_DEFAULT_TCP_PORT,
+                                  getenv("MYSQL_USER"),
+                                  getenv("MYSQL_PASSWORD"),
+                                  getenv("MYSQL_SCHEMA"), 0);
+  if (con == NULL)
+  {
+    fprintf(stderr, "drizzle_create failed\n");
+    return EXIT_FAILURE;
+  }
+
+  ret= drizzle_connect(con);
+  if (ret != DRIZZLE_RETURN_OK)
+    fail(con, "drizzle_connect", ret);
+
+  /* Narrow rows of a counter and a short string, generated by the server. */
+  snprintf(setting, sizeof(setting),
+           "SET SESSION cte_max_recursion_depth= %" PRIu64, rows + 1);
+  drizzle_result_free(drizzle_query(con, setting, 0, &ret));
+  if (ret != DRIZZLE_RETURN_OK)
+    fail(con, "drizzle_query", ret);
+  snprintf(query, sizeof(query),
+           "WITH RECURSIVE seq (n) AS (SELECT 1 UNION ALL SELECT n + 1 FROM seq "
+           "WHERE n < %" PRIu64 ") SELECT n, IF(n %% 7 = 3, NULL, 'narrow') "
+           "FROM seq", rows);
+
+  uint64_t steady= 0;
+  steady+= bench(con, BENCH_ROW_BUFFER, query, rows);
+  steady+= bench(con, BENCH_ROW_VIEW, query, rows);
+  steady+= bench(con, BENCH_STMT_FETCH, query, rows);
+
+  drizzle_quit(con);
+
+  if (!ALLOCATIONS_COUNTED)
+  {
+    printf("allocations are only counted with glibc\n");
+  }
+
+  return steady ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,207 @@
+/* vim:expandtab:shiftwidth=2:tabstop=2:smarttab:
+ *
+ * Drizzle Client & Protocol Library
+ *
+ * Copyright (C) 2013 Drizzle Developer Group
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following disclaimer
+ * in the documentation and/or other materials provided with the
+ * distribution.
+ *
+ *     * The names of its contributors may not be used to endorse or
+ * promote products derived from this software without specific prior
+ * written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <yatl/lite.h>
+
+#include <libdrizzle-5.1/libdrizzle.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CHECKED_QUERY(cmd) \
+  result = drizzle_query(con, cmd, 0, &ret); \
+  ASSERT_EQ_(ret, DRIZZLE_RETURN_OK, "Error (%s): %s, from \"%s\"", \
+             drizzle_strerror(ret), drizzle_error(con), cmd);
+
+#define SELECT_ALL "SELECT id, a, b, c, d FROM test_arrow.t1 ORDER BY id"
+
+static uint32_t get4(const unsigned char *ptr)
+{
+  return (uint32_t)ptr[0] | (uint32_t)ptr[1] << 8 |
+         (uint32_t)ptr[2] << 16 | (uint32_t)ptr[3] << 24;
+}
+
+static uint64_t get8(const unsigned char *ptr)
+{
+  return (uint64_t)get4(ptr) | (uint64_t)get4(ptr + 4) << 32;
+}
+
+/*
+ * Walk the messages of a stream and count its record batches. Each message
+ * is a continuation marker, the metadata size, a flatbuffer Message whose
+ * fields 1 and 3 are the header type and the body size, then the body.
+ */
+static int count_batches(const unsigned char *data, size_t size)
+{
+  size_t pos= 0;
+  int batches= 0;
+  bool schema= false;
+
+  while (1)
+  {
+    ASSERT_TRUE(pos + 8 <= size);
+    ASSERT_EQ(0xFFFFFFFF, get4(data + pos));
+    uint32_t meta_size= get4(data + pos + 4);
+    pos+= 8;
+    if (meta_size == 0)
+    {
+      break;
+    }
+    ASSERT_EQ(0, (pos + meta_size) % 8);
+    ASSERT_TRUE(pos + meta_size <= size);
+
+    const unsigned char *meta= data + pos;
+    const unsigned char *table= meta + get4(meta);
+    const unsigned char *vtable= table - (int32_t)get4(table);
+    uint16_t header_offset= vtable[6] | vtable[7] << 8;
+    uint16_t body_offset= vtable[10] | vtable[11] << 8;
+    uint8_t header_type= table[header_offset];
+    uint64_t body_size= body_offset ? get8(table + body_offset) : 0;
+
+    if (!schema)
+    {
+      ASSERT_EQ_(1, header_type, "the stream does not start with a schema");
+      schema= true;
+    }
+    else
+    {
+      ASSERT_EQ_(3, header_type, "message is not a record batch");
+      batches++;
+    }
+    pos+= meta_size + body_size;
+  }
+
+  ASSERT_EQ_(size, pos, "bytes after the end of the stream");
+  return batches;
+}
+
+int main(int argc, char* argv[])
+{
+  (void)argc;
+  (void)argv;
+  drizzle_return_t ret;
+  drizzle_result_st *result;
+  void *data;
+  size_t size;
+
+  ASSERT_EQ(DRIZZLE_RETURN_INVALID_ARGUMENT, drizzle_result_arrow_fd(NULL, 1, 0));
+  ASSERT_EQ(DRIZZLE_RETURN_INVALID_ARGUMENT,
+            drizzle_result_arrow_memory(NULL, 0, &data, &size));
+
+  drizzle_st *con= drizzle_create(getenv("MYSQL_SERVER"),
+                                  getenv("MYSQL_PORT") ? atoi(getenv("MYSQL_PORT"))
+                                                       : DRIZZLE_DEFAULT_TCP_PORT,
+                                  getenv("MYSQL_USER"),
+                                  getenv("MYSQL_PASSWORD"),
+                                  getenv("MYSQL_SCHEMA"), 0);
+  ASSERT_NOT_NULL_(con, "Drizzle connection object creation error");
+
+  ret= drizzle_connect(con);
+  if (ret == DRIZZLE_RETURN_COULD_NOT_CONNECT)
+  {
+    char error[DRIZZLE_MAX_ERROR_SIZE];
+    strncpy(error, drizzle_error(con), DRIZZLE_MAX_ERROR_SIZE);
+    drizzle_quit(con);
+    SKIP_IF_(ret == DRIZZLE_RETURN_COULD_NOT_CONNECT, "%s(%s)", error,
+             drizzle_strerror(ret));
+  }
+  ASSERT_EQ_(DRIZZLE_RETURN_OK, ret, "drizzle_connect(): %s(%s)",
+             drizzle_error(con), drizzle_strerror(ret));
+
+  CHECKED_QUERY("DROP SCHEMA IF EXISTS test_arrow");
+  drizzle_result_free(result);
+  CHECKED_QUERY("CREATE SCHEMA test_arrow");
+  drizzle_result_free(result);
+  CHECKED_QUERY("CREATE TABLE test_arrow.t1 (id INT, a INT, b BIGINT, "
+                "c VARCHAR(10), d DOUBLE)");
+  drizzle_result_free(result);
+  CHECKED_QUERY("INSERT INTO test_arrow.t1 VALUES (1, 1, 10, 'one', 1.5), "
+                "(2, 2, NULL, NULL, 2.5), (3, NULL, 30, '', NULL)");
+  drizzle_result_free(result);
+
+  /* Three rows in batches of two rows make two record batches. */
+  CHECKED_QUERY(SELECT_ALL);
+  ret= drizzle_result_arrow_memory(result, 2, &data, &size);
+  ASSERT_EQ_(DRIZZLE_RETURN_OK, ret, "drizzle_result_arrow_memory(): %s",
+             drizzle_error(con));
+  ASSERT_EQ(3, drizzle_result_row_count(result));
+  ASSERT_EQ(2, count_batches((const unsigned char *)data, size));
+  free(data);
+  drizzle_result_free(result);
+
+  /* A buffered result cannot be exported. */
+  CHECKED_QUERY(SELECT_ALL);
+  ret= drizzle_result_buffer(result);
+  ASSERT_EQ_(DRIZZLE_RETURN_OK, ret, "%s", drizzle_error(con));
+  ASSERT_EQ(DRIZZLE_RETURN_UNEXPECTED_DATA,
+            drizzle_result_arrow_memory(result, 0, &data, &size));
+  drizzle_result_free(result);
+
+  /* Binary results, written to a file in a single batch. */
+  drizzle_stmt_st *stmt= drizzle_stmt_prepare(con, SELECT_ALL,
+                                             strlen(SELECT_ALL), &ret);
+  ASSERT_EQ_(DRIZZLE_RETURN_OK, ret, "%s", drizzle_error(con));
+  ret= drizzle_stmt_execute(stmt);
+  ASSERT_EQ_(DRIZZLE_RETURN_OK, ret, "%s", drizzle_error(con));
+
+  FILE *file= tmpfile();
+  ASSERT_NOT_NULL_(file, "tmpfile() failed");
+  ret= drizzle_result_arrow_fd(drizzle_stmt_result(stmt), fileno(file), 0);
+  ASSERT_EQ_(DRIZZLE_RETURN_OK, ret, "drizzle_result_arrow_fd(): %s",
+             drizzle_error(con));
+
+  long file_size= ftell(file);
+  ASSERT_TRUE(file_size > 0);
+  unsigned char *stream= (unsigned char *)malloc((size_t)file_size);
+  ASSERT_NOT_NULL_(stream, "malloc() failed");
+  rewind(file);
+  ASSERT_EQ((size_t)file_size, fread(stream, 1, (size_t)file_size, file));
+  ASSERT_EQ(1, count_batches(stream, (size_t)file_size));
+  free(stream);
+  fclose(file);
+
+  ret= drizzle_stmt_close(stmt);
+  ASSERT_EQ_(DRIZZLE_RETURN_OK, ret, "%s", drizzle_error(con));
+
+  CHECKED_QUERY("DROP SCHEMA IF EXISTS test_arrow");
+  drizzle_result_free(result);
+
+  ret= drizzle_quit(con);
+  ASSERT_EQ_(DRIZZLE_RETURN_OK, ret, "%s", drizzle_strerror(ret));
+
+  return EXIT_SUCCESS;
+}
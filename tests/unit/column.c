@@ -141,6 +141,20 @@ int main(int argc, char *argv[])
 
   drizzle_result_free(result);
 
+  /* Names are decoded on first access and stay put afterwards */
+  CHECKED_QUERY("SELECT a AS x, b FROM test_column.t1 AS u");
+  ASSERT_EQ(drizzle_column_buffer(result), DRIZZLE_RETURN_OK);
+  column= drizzle_column_index(result, 0);
+  const char *name= drizzle_column_name(column);
+  ASSERT_STREQ(name, "x");
+  ASSERT_STREQ(drizzle_column_orig_name(column), "a");
+  ASSERT_STREQ(drizzle_column_table(column), "u");
+  ASSERT_STREQ(drizzle_column_orig_table(column), "t1");
+  ASSERT_STREQ(drizzle_column_catalog(column), "def");
+  ASSERT_EQ_(drizzle_column_name(column), name, "Column name moved");
+  ASSERT_STREQ(drizzle_column_name(drizzle_column_index(result, 1)), "b");
+  drizzle_result_free(result);
+
   CHECKED_QUERY("DROP TABLE test_column.t1");
 
   tear_down_schema("test_column");
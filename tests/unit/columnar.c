@@ -0,0 +1,185 @@
+/* vim:expandtab:shiftwidth=2:tabstop=2:smarttab:
+ *
+ * Drizzle Client & Protocol Library
+ *
+ * Copyright (C) 2013 Drizzle Developer Group
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following disclaimer
+ * in the documentation and/or other materials provided with the
+ * distribution.
+ *
+ *     * The names of its contributors may not be used to endorse or
+ * promote products derived from this software without specific prior
+ * written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <yatl/lite.h>
+
+#include <libdrizzle-5.1/libdrizzle.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CHECKED_QUERY(cmd) \
+  result = drizzle_query(con, cmd, 0, &ret); \
+  ASSERT_EQ_(ret, DRIZZLE_RETURN_OK, "Error (%s): %s, from \"%s\"", \
+             drizzle_strerror(ret), drizzle_error(con), cmd);
+
+#define SELECT_ALL "SELECT id, a, b, c, d FROM test_columnar.t1 ORDER BY id"
+
+static bool is_valid(drizzle_result_st *result, uint16_t column, uint64_t row)
+{
+  const uint8_t *validity= drizzle_result_column_validity(result, column);
+  return validity[row / 8] & (1 << (row % 8));
+}
+
+/* Column c holds 'one', NULL and '' in both text and binary results. */
+static void check_strings(drizzle_result_st *result)
+{
+  const uint64_t *offsets= drizzle_result_column_offsets(result, 3);
+  ASSERT_NOT_NULL_(offsets, "no offsets for column c");
+  ASSERT_EQ(0, drizzle_result_column_width(result, 3));
+  ASSERT_NULL_(drizzle_result_column_values(result, 3), "values for column c");
+  ASSERT_EQ(0, offsets[0]);
+  ASSERT_EQ(3, offsets[1]);
+  ASSERT_EQ(3, offsets[2]);
+  ASSERT_EQ(3, offsets[3]);
+  ASSERT_EQ_(memcmp(drizzle_result_column_data(result, 3), "one", 3), 0,
+             "Retrieved bad value for column c");
+  ASSERT_TRUE(is_valid(result, 3, 0));
+  ASSERT_FALSE(is_valid(result, 3, 1));
+  ASSERT_TRUE(is_valid(result, 3, 2));
+  ASSERT_EQ(1, drizzle_result_column_null_count(result, 3));
+}
+
+int main(int argc, char* argv[])
+{
+  (void)argc;
+  (void)argv;
+  drizzle_return_t ret;
+  drizzle_result_st *result;
+
+  ASSERT_EQ(DRIZZLE_RETURN_INVALID_ARGUMENT, drizzle_result_buffer_columnar(NULL));
+  ASSERT_NULL_(drizzle_result_column_validity(NULL, 0), "validity of a NULL result");
+
+  drizzle_st *con= drizzle_create(getenv("MYSQL_SERVER"),
+                                  getenv("MYSQL_PORT") ? atoi(getenv("MYSQL_PORT"))
+                                                       : DRIZZLE_DEFAULT_TCP_PORT,
+                                  getenv("MYSQL_USER"),
+                                  getenv("MYSQL_PASSWORD"),
+                                  getenv("MYSQL_SCHEMA"), 0);
+  ASSERT_NOT_NULL_(con, "Drizzle connection object creation error");
+
+  ret= drizzle_connect(con);
+  if (ret == DRIZZLE_RETURN_COULD_NOT_CONNECT)
+  {
+    char error[DRIZZLE_MAX_ERROR_SIZE];
+    strncpy(error, drizzle_error(con), DRIZZLE_MAX_ERROR_SIZE);
+    drizzle_quit(con);
+    SKIP_IF_(ret == DRIZZLE_RETURN_COULD_NOT_CONNECT, "%s(%s)", error,
+             drizzle_strerror(ret));
+  }
+  ASSERT_EQ_(DRIZZLE_RETURN_OK, ret, "drizzle_connect(): %s(%s)",
+             drizzle_error(con), drizzle_strerror(ret));
+
+  CHECKED_QUERY("DROP SCHEMA IF EXISTS test_columnar");
+  drizzle_result_free(result);
+  CHECKED_QUERY("CREATE SCHEMA test_columnar");
+  drizzle_result_free(result);
+  CHECKED_QUERY("CREATE TABLE test_columnar.t1 (id INT, a INT, b BIGINT, "
+                "c VARCHAR(10), d DOUBLE)");
+  drizzle_result_free(result);
+  CHECKED_QUERY("INSERT INTO test_columnar.t1 VALUES (1, 1, 10, 'one', 1.5), "
+                "(2, 2, NULL, NULL, 2.5), (3, NULL, 30, '', NULL)");
+  drizzle_result_free(result);
+
+  /* Text results keep every column as variable length values. */
+  CHECKED_QUERY(SELECT_ALL);
+  ret= drizzle_result_buffer_columnar(result);
+  ASSERT_EQ_(DRIZZLE_RETURN_OK, ret, "drizzle_result_buffer_columnar(): %s",
+             drizzle_error(con));
+  ASSERT_EQ(3, drizzle_result_row_count(result));
+  ASSERT_NULL_(drizzle_row_next(result), "row of a result buffered by column");
+  ASSERT_EQ(DRIZZLE_RETURN_UNEXPECTED_DATA, drizzle_result_buffer(result));
+
+  const uint64_t *offsets= drizzle_result_column_offsets(result, 1);
+  ASSERT_EQ(0, drizzle_result_column_width(result, 1));
+  ASSERT_EQ(2, offsets[2]);
+  ASSERT_EQ(2, offsets[3]);
+  ASSERT_EQ_(memcmp(drizzle_result_column_data(result, 1), "12", 2), 0,
+             "Retrieved bad value for column a");
+  ASSERT_FALSE(is_valid(result, 1, 2));
+  ASSERT_EQ(1, drizzle_result_column_null_count(result, 1));
+  check_strings(result);
+  drizzle_result_free(result);
+
+  /* Binary results keep numbers as arrays of their type. */
+  drizzle_stmt_st *stmt= drizzle_stmt_prepare(con, SELECT_ALL,
+                                             strlen(SELECT_ALL), &ret);
+  ASSERT_EQ_(DRIZZLE_RETURN_OK, ret, "%s", drizzle_error(con));
+  ret= drizzle_stmt_execute(stmt);
+  ASSERT_EQ_(DRIZZLE_RETURN_OK, ret, "%s", drizzle_error(con));
+  ret= drizzle_stmt_buffer_columnar(stmt);
+  ASSERT_EQ_(DRIZZLE_RETURN_OK, ret, "drizzle_stmt_buffer_columnar(): %s",
+             drizzle_error(con));
+  ASSERT_EQ(DRIZZLE_RETURN_ROW_END, drizzle_stmt_fetch(stmt));
+
+  result= drizzle_stmt_result(stmt);
+  ASSERT_EQ(3, drizzle_result_row_count(result));
+
+  ASSERT_EQ(4, drizzle_result_column_width(result, 1));
+  const int32_t *a= (const int32_t *)drizzle_result_column_values(result, 1);
+  ASSERT_NOT_NULL_(a, "no values for column a");
+  ASSERT_NULL_(drizzle_result_column_offsets(result, 1), "offsets for column a");
+  ASSERT_EQ(1, a[0]);
+  ASSERT_EQ(2, a[1]);
+  ASSERT_FALSE(is_valid(result, 1, 2));
+
+  ASSERT_EQ(8, drizzle_result_column_width(result, 2));
+  const int64_t *b= (const int64_t *)drizzle_result_column_values(result, 2);
+  ASSERT_EQ(10, b[0]);
+  ASSERT_EQ(30, b[2]);
+  ASSERT_FALSE(is_valid(result, 2, 1));
+  ASSERT_EQ(1, drizzle_result_column_null_count(result, 2));
+
+  check_strings(result);
+
+  ASSERT_EQ(8, drizzle_result_column_width(result, 4));
+  const double *d= (const double *)drizzle_result_column_values(result, 4);
+  const double expected_d[2]= { 1.5f, 2.5f };
+  ASSERT_EQ(0, memcmp(d, expected_d, sizeof(expected_d)));
+  ASSERT_FALSE(is_valid(result, 4, 2));
+
+  ret= drizzle_stmt_close(stmt);
+  ASSERT_EQ_(DRIZZLE_RETURN_OK, ret, "%s", drizzle_error(con));
+
+  CHECKED_QUERY("DROP SCHEMA IF EXISTS test_columnar");
+  drizzle_result_free(result);
+
+  ret= drizzle_quit(con);
+  ASSERT_EQ_(DRIZZLE_RETURN_OK, ret, "%s", drizzle_strerror(ret));
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,107 @@
+/* vim:expandtab:shiftwidth=2:tabstop=2:smarttab:
+ *
+ * Drizzle Client & Protocol Library
+ *
+ * Copyright (C) 2013 Drizzle Developer Group
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following disclaimer
+ * in the documentation and/or other materials provided with the
+ * distribution.
+ *
+ *     * The names of its contributors may not be used to endorse or
+ * promote products derived from this software without specific prior
+ * written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <yatl/lite.h>
+
+#include <libdrizzle-5.1/libdrizzle.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+int main(int argc, char* argv[])
+{
+  (void)argc;
+  (void)argv;
+  drizzle_return_t ret;
+
+  drizzle_options_st *opts= drizzle_options_create();
+  ASSERT_EQ(DRIZZLE_COMPRESSION_NONE, drizzle_options_get_compression(opts));
+  ASSERT_EQ(0, drizzle_options_get_compression_level(opts));
+  ASSERT_EQ(DRIZZLE_DEFAULT_COMPRESSION_THRESHOLD,
+            drizzle_options_get_compression_threshold(opts));
+
+  drizzle_options_set_compression(opts, DRIZZLE_COMPRESSION_ZLIB);
+  drizzle_options_set_compression_level(opts, 1);
+  drizzle_options_set_compression_threshold(opts, 128);
+  ASSERT_EQ(DRIZZLE_COMPRESSION_ZLIB, drizzle_options_get_compression(opts));
+  ASSERT_EQ(1, drizzle_options_get_compression_level(opts));
+  ASSERT_EQ(128, drizzle_options_get_compression_threshold(opts));
+
+  drizzle_st *con= drizzle_create(getenv("MYSQL_SERVER"),
+                                  getenv("MYSQL_PORT") ? atoi(getenv("MYSQL_PORT"))
+                                                       : DRIZZLE_DEFAULT_TCP_PORT,
+                                  getenv("MYSQL_USER"),
+                                  getenv("MYSQL_PASSWORD"),
+                                  getenv("MYSQL_SCHEMA"), opts);
+  ASSERT_NOT_NULL_(con, "Drizzle connection object creation error");
+  drizzle_options_destroy(opts);
+
+  ret= drizzle_connect(con);
+  if (ret == DRIZZLE_RETURN_COULD_NOT_CONNECT)
+  {
+    char error[DRIZZLE_MAX_ERROR_SIZE];
+    strncpy(error, drizzle_error(con), DRIZZLE_MAX_ERROR_SIZE);
+    drizzle_quit(con);
+    SKIP_IF_(ret == DRIZZLE_RETURN_COULD_NOT_CONNECT, "%s(%s)", error,
+             drizzle_strerror(ret));
+  }
+  ASSERT_EQ_(DRIZZLE_RETURN_OK, ret, "drizzle_connect(): %s(%s)",
+             drizzle_error(con), drizzle_strerror(ret));
+
+  /* A short query and result stay below the threshold, a long one is
+     compressed both ways. */
+  drizzle_result_st *result= drizzle_query(con, "SELECT 1", 0, &ret);
+  ASSERT_EQ_(DRIZZLE_RETURN_OK, ret, "SELECT 1 (%s)", drizzle_error(con));
+  ASSERT_EQ(DRIZZLE_RETURN_OK, drizzle_result_buffer(result));
+  drizzle_row_t row= drizzle_row_next(result);
+  ASSERT_NOT_NULL_(row, "no row returned");
+  ASSERT_EQ_(strcmp(row[0], "1"), 0, "Retrieved bad row value");
+  drizzle_result_free(result);
+
+  result= drizzle_query(con, "SELECT REPEAT('a', 100000), 2", 0, &ret);
+  ASSERT_EQ_(DRIZZLE_RETURN_OK, ret, "SELECT REPEAT (%s)", drizzle_error(con));
+  ASSERT_EQ(DRIZZLE_RETURN_OK, drizzle_result_buffer(result));
+  row= drizzle_row_next(result);
+  ASSERT_NOT_NULL_(row, "no row returned");
+  ASSERT_EQ(100000, drizzle_row_field_sizes(result)[0]);
+  ASSERT_EQ_(strcmp(row[1], "2"), 0, "Retrieved bad row value");
+  drizzle_result_free(result);
+
+  drizzle_quit(con);
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,148 @@
+/* vim:expandtab:shiftwidth=2:tabstop=2:smarttab:
+ *
+ * Drizzle Client & Protocol Library
+ *
+ * Copyright (C) 2013 Drizzle Developer Group
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following disclaimer
+ * in the documentation and/or other materials provided with the
+ * distribution.
+ *
+ *     * The names of its contributors may not be used to endorse or
+ * promote products derived from this software without specific prior
+ * written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <yatl/lite.h>
+
+#include <libdrizzle-5.1/libdrizzle.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void _wait(drizzle_reactor_st *reactor)
+{
+  drizzle_st *ready[1];
+  drizzle_return_t ret;
+
+  ASSERT_EQ(1, drizzle_reactor_wait(reactor, ready, 1, 5000, &ret));
+  ASSERT_EQ_(DRIZZLE_RETURN_OK, ret, "drizzle_reactor_wait(): %s", drizzle_strerror(ret));
+}
+
+int main(int argc, char* argv[])
+{
+  (void)argc;
+  (void)argv;
+  drizzle_return_t ret;
+
+  drizzle_options_st *opts= drizzle_options_create();
+  ASSERT_FALSE_(drizzle_options_get_io_uring(opts), "io_uring enabled by default");
+  drizzle_options_set_io_uring(opts, true);
+  ASSERT_TRUE_(drizzle_options_get_io_uring(opts), "io_uring not set");
+
+  drizzle_st *con= drizzle_create(getenv("MYSQL_SERVER"),
+                                  getenv("MYSQL_PORT") ? atoi(getenv("MYSQL_PORT"))
+                                                       : DRIZZLE_DEFAULT_TCP_PORT,
+                                  getenv("MYSQL_USER"),
+                                  getenv("MYSQL_PASSWORD"),
+                                  getenv("MYSQL_SCHEMA"), opts);
+  ASSERT_NOT_NULL_(con, "Drizzle connection object creation error");
+  drizzle_options_destroy(opts);
+
+  /* Works the same whether or not the kernel provides io_uring. */
+  ret= drizzle_connect(con);
+  if (ret == DRIZZLE_RETURN_COULD_NOT_CONNECT)
+  {
+    char error[DRIZZLE_MAX_ERROR_SIZE];
+    strncpy(error, drizzle_error(con), DRIZZLE_MAX_ERROR_SIZE);
+    drizzle_quit(con);
+    SKIP_IF_(ret == DRIZZLE_RETURN_COULD_NOT_CONNECT, "%s(%s)", error,
+             drizzle_strerror(ret));
+  }
+  ASSERT_EQ_(DRIZZLE_RETURN_OK, ret, "drizzle_connect(): %s(%s)",
+             drizzle_error(con), drizzle_strerror(ret));
+
+  drizzle_result_st *result= drizzle_query(con, "SELECT 1", 0, &ret);
+  ASSERT_EQ_(DRIZZLE_RETURN_OK, ret, "SELECT 1 (%s)", drizzle_error(con));
+  ASSERT_EQ(DRIZZLE_RETURN_OK, drizzle_result_buffer(result));
+
+  drizzle_row_t row= drizzle_row_next(result);
+  ASSERT_NOT_NULL_(row, "no row returned");
+  ASSERT_EQ_(strcmp(row[0], "1"), 0, "Retrieved bad row value");
+  drizzle_result_free(result);
+
+  drizzle_quit(con);
+
+  /* Non-blocking connections read through the ring of their reactor. */
+  drizzle_reactor_st *reactor= drizzle_reactor_create();
+  ASSERT_NOT_NULL_(reactor, "Reactor creation error");
+
+  opts= drizzle_options_create();
+  drizzle_options_set_io_uring(opts, true);
+  drizzle_options_set_non_blocking(opts, true);
+  con= drizzle_create(getenv("MYSQL_SERVER"),
+                      getenv("MYSQL_PORT") ? atoi(getenv("MYSQL_PORT"))
+                                           : DRIZZLE_DEFAULT_TCP_PORT,
+                      getenv("MYSQL_USER"),
+                      getenv("MYSQL_PASSWORD"),
+                      getenv("MYSQL_SCHEMA"), opts);
+  ASSERT_NOT_NULL_(con, "Drizzle connection object creation error");
+  drizzle_options_destroy(opts);
+  ASSERT_EQ(DRIZZLE_RETURN_OK, drizzle_reactor_add(reactor, con));
+
+  while ((ret= drizzle_connect(con)) == DRIZZLE_RETURN_IO_WAIT)
+  {
+    _wait(reactor);
+  }
+  ASSERT_EQ_(DRIZZLE_RETURN_OK, ret, "drizzle_connect(): %s(%s)",
+             drizzle_error(con), drizzle_strerror(ret));
+
+  while ((result= drizzle_query(con, "SELECT 2", 0, &ret)),
+         ret == DRIZZLE_RETURN_IO_WAIT)
+  {
+    _wait(reactor);
+  }
+  ASSERT_EQ_(DRIZZLE_RETURN_OK, ret, "SELECT 2 (%s)", drizzle_error(con));
+
+  while ((ret= drizzle_result_buffer(result)) == DRIZZLE_RETURN_IO_WAIT)
+  {
+    _wait(reactor);
+  }
+  ASSERT_EQ(DRIZZLE_RETURN_OK, ret);
+
+  row= drizzle_row_next(result);
+  ASSERT_NOT_NULL_(row, "no row returned");
+  ASSERT_EQ_(strcmp(row[0], "2"), 0, "Retrieved bad row value");
+  drizzle_result_free(result);
+
+  /* A connection freed while its read is queued takes it back. */
+  result= drizzle_query(con, "SELECT SLEEP(1)", 0, &ret);
+  ASSERT_EQ(DRIZZLE_RETURN_IO_WAIT, ret);
+  drizzle_quit(con);
+
+  drizzle_reactor_free(reactor);
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,123 @@
+/* vim:expandtab:shiftwidth=2:tabstop=2:smarttab:
+ *
+ * Drizzle Client & Protocol Library
+ *
+ * Copyright (C) 2013 Drizzle Developer Group
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following disclaimer
+ * in the documentation and/or other materials provided with the
+ * distribution.
+ *
+ *     * The names of its contributors may not be used to endorse or
+ * promote products derived from this software without specific prior
+ * written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <yatl/lite.h>
+
+#include <libdrizzle-5.1/libdrizzle.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+int main(int argc, char* argv[])
+{
+  (void)argc;
+  (void)argv;
+
+  drizzle_st *con= drizzle_create("localhost", 3306, "root", "", "", NULL);
+  ASSERT_NOT_NULL_(con, "Drizzle connection object creation error");
+  ASSERT_TRUE_(drizzle_memory_usage(con) > DRIZZLE_DEFAULT_BUFFER_SIZE,
+               "buffer not accounted for: %zu", drizzle_memory_usage(con));
+  ASSERT_STREQ_("", drizzle_error(con), "unexpected error message");
+  drizzle_quit(con);
+
+  drizzle_options_st *opts= drizzle_options_create();
+  ASSERT_FALSE_(drizzle_options_get_low_footprint(opts), "low footprint enabled by default");
+  drizzle_options_set_low_footprint(opts, true);
+  ASSERT_TRUE_(drizzle_options_get_low_footprint(opts), "low footprint not set");
+
+  /* Nothing but the connection structure until the first connect. */
+  con= drizzle_create("localhost", 3306, "root", "", "", opts);
+  ASSERT_NOT_NULL_(con, "Drizzle connection object creation error");
+  ASSERT_TRUE_(drizzle_memory_usage(con) < DRIZZLE_LOW_FOOTPRINT_BUFFER_SIZE,
+               "low footprint connection uses %zu bytes", drizzle_memory_usage(con));
+  drizzle_quit(con);
+
+  drizzle_options_destroy(opts);
+
+  ASSERT_EQ_(0, drizzle_memory_usage(NULL), "NULL connection has no memory");
+
+  /* A buffer grown for a row larger than it is given back at the end of the
+     result. */
+  opts= drizzle_options_create();
+  drizzle_options_set_low_footprint(opts, true);
+  con= drizzle_create(getenv("MYSQL_SERVER"),
+                      getenv("MYSQL_PORT") ? atoi(getenv("MYSQL_PORT"))
+                                           : DRIZZLE_DEFAULT_TCP_PORT,
+                      getenv("MYSQL_USER"),
+                      getenv("MYSQL_PASSWORD"),
+                      getenv("MYSQL_SCHEMA"), opts);
+  ASSERT_NOT_NULL_(con, "Drizzle connection object creation error");
+
+  drizzle_return_t ret= drizzle_connect(con);
+  if (ret == DRIZZLE_RETURN_COULD_NOT_CONNECT)
+  {
+    char error[DRIZZLE_MAX_ERROR_SIZE];
+    strncpy(error, drizzle_error(con), DRIZZLE_MAX_ERROR_SIZE);
+    drizzle_quit(con);
+    drizzle_options_destroy(opts);
+    SKIP_IF_(ret == DRIZZLE_RETURN_COULD_NOT_CONNECT, "%s(%s)", error,
+             drizzle_strerror(ret));
+  }
+  ASSERT_EQ_(DRIZZLE_RETURN_OK, ret, "drizzle_connect(): %s(%s)",
+             drizzle_error(con), drizzle_strerror(ret));
+
+  size_t resting= drizzle_memory_usage(con);
+  drizzle_result_st *result= drizzle_query(con, "SELECT REPEAT('x', 100000)",
+                                           0, &ret);
+  ASSERT_EQ_(DRIZZLE_RETURN_OK, ret, "SELECT REPEAT(): %s", drizzle_error(con));
+  ASSERT_EQ(DRIZZLE_RETURN_OK, drizzle_column_buffer(result));
+
+  drizzle_row_t row= drizzle_row_buffer(result, &ret);
+  ASSERT_NOT_NULL_(row, "no row returned: %s", drizzle_strerror(ret));
+  ASSERT_TRUE_(drizzle_row_field_sizes(result)[0] == 100000,
+               "field of %zu bytes", drizzle_row_field_sizes(result)[0]);
+  ASSERT_TRUE_(drizzle_memory_usage(con) >
+               resting + 100000 - DRIZZLE_LOW_FOOTPRINT_BUFFER_SIZE,
+               "buffer of %zu bytes did not grow", drizzle_memory_usage(con));
+
+  ASSERT_NULL_(drizzle_row_buffer(result, &ret), "more than one row");
+  ASSERT_EQ_(DRIZZLE_RETURN_OK, ret, "%s", drizzle_strerror(ret));
+  ASSERT_TRUE_(drizzle_memory_usage(con) <= resting,
+               "%zu bytes after the result, %zu before", drizzle_memory_usage(con),
+               resting);
+  drizzle_result_free(result);
+
+  drizzle_quit(con);
+  drizzle_options_destroy(opts);
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,159 @@
+/* vim:expandtab:shiftwidth=2:tabstop=2:smarttab:
+ *
+ * Drizzle Client & Protocol Library
+ *
+ * Copyright (C) 2013 Drizzle Developer Group
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following disclaimer
+ * in the documentation and/or other materials provided with the
+ * distribution.
+ *
+ *     * The names of its contributors may not be used to endorse or
+ * promote products derived from this software without specific prior
+ * written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <yatl/lite.h>
+
+#include <libdrizzle-5.1/libdrizzle.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void check_value(drizzle_result_st *result, const char *value)
+{
+  ASSERT_EQ(DRIZZLE_RETURN_OK, drizzle_result_buffer(result));
+  drizzle_row_t row= drizzle_row_next(result);
+  ASSERT_NOT_NULL_(row, "no row returned");
+  ASSERT_EQ_(strcmp(row[0], value), 0, "Retrieved bad row value");
+}
+
+int main(int argc, char* argv[])
+{
+  (void)argc;
+  (void)argv;
+  drizzle_return_t ret;
+  drizzle_result_st *result;
+  drizzle_result_st *next;
+
+  ASSERT_NULL_(drizzle_result_next(NULL, &ret), "result from a NULL result");
+  ASSERT_EQ(DRIZZLE_RETURN_INVALID_ARGUMENT, ret);
+
+  drizzle_options_st *opts= drizzle_options_create();
+  drizzle_options_set_multi_statements(opts, true);
+  drizzle_st *con= drizzle_create(getenv("MYSQL_SERVER"),
+                                  getenv("MYSQL_PORT") ? atoi(getenv("MYSQL_PORT"))
+                                                       : DRIZZLE_DEFAULT_TCP_PORT,
+                                  getenv("MYSQL_USER"),
+                                  getenv("MYSQL_PASSWORD"),
+                                  getenv("MYSQL_SCHEMA"), opts);
+  ASSERT_NOT_NULL_(con, "Drizzle connection object creation error");
+  drizzle_options_destroy(opts);
+
+  ret= drizzle_connect(con);
+  if (ret == DRIZZLE_RETURN_COULD_NOT_CONNECT)
+  {
+    char error[DRIZZLE_MAX_ERROR_SIZE];
+    strncpy(error, drizzle_error(con), DRIZZLE_MAX_ERROR_SIZE);
+    drizzle_quit(con);
+    SKIP_IF_(ret == DRIZZLE_RETURN_COULD_NOT_CONNECT, "%s(%s)", error,
+             drizzle_strerror(ret));
+  }
+  ASSERT_EQ_(DRIZZLE_RETURN_OK, ret, "drizzle_connect(): %s(%s)",
+             drizzle_error(con), drizzle_strerror(ret));
+
+  /* Result sets and OK packets of one response, in order. */
+  result= drizzle_query(con, "SELECT 1; SELECT 2; SET @a= 3", 0, &ret);
+  ASSERT_EQ_(DRIZZLE_RETURN_OK, ret, "SELECT 1 (%s)", drizzle_error(con));
+
+  next= drizzle_result_next(result, &ret);
+  ASSERT_NULL_(next, "next result returned before the rows were read");
+  ASSERT_EQ(DRIZZLE_RETURN_NOT_READY, ret);
+
+  check_value(result, "1");
+  next= drizzle_result_next(result, &ret);
+  ASSERT_EQ_(DRIZZLE_RETURN_OK, ret, "SELECT 2 (%s)", drizzle_error(con));
+  drizzle_result_free(result);
+  result= next;
+  check_value(result, "2");
+
+  next= drizzle_result_next(result, &ret);
+  ASSERT_EQ_(DRIZZLE_RETURN_OK, ret, "SET (%s)", drizzle_error(con));
+  ASSERT_NOT_NULL_(next, "no result for SET");
+  ASSERT_EQ(0, drizzle_result_column_count(next));
+  drizzle_result_free(result);
+  result= next;
+
+  next= drizzle_result_next(result, &ret);
+  ASSERT_NULL_(next, "result returned past the end of the response");
+  ASSERT_EQ(DRIZZLE_RETURN_OK, ret);
+  drizzle_result_free(result);
+
+  /* An error ends the response. */
+  result= drizzle_query(con, "SELECT 1; SELEC 2; SELECT 3", 0, &ret);
+  ASSERT_EQ_(DRIZZLE_RETURN_OK, ret, "SELECT 1 (%s)", drizzle_error(con));
+  check_value(result, "1");
+  next= drizzle_result_next(result, &ret);
+  ASSERT_EQ_(DRIZZLE_RETURN_ERROR_CODE, ret, "SELEC 2 (%s)", drizzle_error(con));
+  drizzle_result_free(result);
+  result= next;
+  next= drizzle_result_next(result, &ret);
+  ASSERT_NULL_(next, "result returned after an error");
+  ASSERT_EQ(DRIZZLE_RETURN_OK, ret);
+  drizzle_result_free(result);
+
+  result= drizzle_query(con, "SELECT 4", 0, &ret);
+  ASSERT_EQ_(DRIZZLE_RETURN_OK, ret, "SELECT 4 (%s)", drizzle_error(con));
+  check_value(result, "4");
+  drizzle_result_free(result);
+
+  /* Further result sets of a pipelined query come before the next command. */
+  ASSERT_EQ(DRIZZLE_RETURN_OK, drizzle_pipeline_query(con, "SELECT 5; SELECT 6", 0));
+  ASSERT_EQ(DRIZZLE_RETURN_OK, drizzle_pipeline_query(con, "SELECT 7", 0));
+
+  result= drizzle_pipeline_result(con, &ret);
+  ASSERT_EQ_(DRIZZLE_RETURN_OK, ret, "SELECT 5 (%s)", drizzle_error(con));
+  check_value(result, "5");
+
+  ASSERT_NULL_(drizzle_pipeline_result(con, &ret), "pipelined result returned early");
+  ASSERT_EQ(DRIZZLE_RETURN_NOT_READY, ret);
+
+  next= drizzle_result_next(result, &ret);
+  ASSERT_EQ_(DRIZZLE_RETURN_OK, ret, "SELECT 6 (%s)", drizzle_error(con));
+  drizzle_result_free(result);
+  check_value(next, "6");
+  ASSERT_NULL_(drizzle_result_next(next, &ret), "result returned past the end of the response");
+  ASSERT_EQ(DRIZZLE_RETURN_OK, ret);
+  drizzle_result_free(next);
+
+  result= drizzle_pipeline_result(con, &ret);
+  ASSERT_EQ_(DRIZZLE_RETURN_OK, ret, "SELECT 7 (%s)", drizzle_error(con));
+  check_value(result, "7");
+  drizzle_result_free(result);
+
+  drizzle_quit(con);
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,156 @@
+/* vim:expandtab:shiftwidth=2:tabstop=2:smarttab:
+ *
+ * Drizzle Client & Protocol Library
+ *
+ * Copyright (C) 2013 Drizzle Developer Group
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following disclaimer
+ * in the documentation and/or other materials provided with the
+ * distribution.
+ *
+ *     * The names of its contributors may not be used to endorse or
+ * promote products derived from this software without specific prior
+ * written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <yatl/lite.h>
+
+#include <libdrizzle-5.1/libdrizzle.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void check_value(drizzle_result_st *result, const char *value)
+{
+  ASSERT_EQ(DRIZZLE_RETURN_OK, drizzle_result_buffer(result));
+  drizzle_row_t row= drizzle_row_next(result);
+  ASSERT_NOT_NULL_(row, "no row returned");
+  ASSERT_EQ_(strcmp(row[0], value), 0, "Retrieved bad row value");
+  drizzle_result_free(result);
+}
+
+int main(int argc, char* argv[])
+{
+  (void)argc;
+  (void)argv;
+  drizzle_return_t ret;
+  drizzle_result_st *result;
+
+  drizzle_st *con= drizzle_create(getenv("MYSQL_SERVER"),
+                                  getenv("MYSQL_PORT") ? atoi(getenv("MYSQL_PORT"))
+                                                       : DRIZZLE_DEFAULT_TCP_PORT,
+                                  getenv("MYSQL_USER"),
+                                  getenv("MYSQL_PASSWORD"),
+                                  getenv("MYSQL_SCHEMA"), 0);
+  ASSERT_NOT_NULL_(con, "Drizzle connection object creation error");
+  ASSERT_EQ(0, drizzle_pipeline_count(con));
+
+  ret= drizzle_connect(con);
+  if (ret == DRIZZLE_RETURN_COULD_NOT_CONNECT)
+  {
+    char error[DRIZZLE_MAX_ERROR_SIZE];
+    strncpy(error, drizzle_error(con), DRIZZLE_MAX_ERROR_SIZE);
+    drizzle_quit(con);
+    SKIP_IF_(ret == DRIZZLE_RETURN_COULD_NOT_CONNECT, "%s(%s)", error,
+             drizzle_strerror(ret));
+  }
+  ASSERT_EQ_(DRIZZLE_RETURN_OK, ret, "drizzle_connect(): %s(%s)",
+             drizzle_error(con), drizzle_strerror(ret));
+
+  /* Results come back in order, errors included. */
+  ASSERT_EQ(DRIZZLE_RETURN_OK, drizzle_pipeline_query(con, "SELECT 1", 0));
+  ASSERT_EQ(DRIZZLE_RETURN_OK, drizzle_pipeline_query(con, "SELEC 2", 0));
+  ASSERT_EQ(DRIZZLE_RETURN_OK, drizzle_pipeline_query(con, "SELECT 3", 0));
+  ASSERT_EQ(3, drizzle_pipeline_count(con));
+  ASSERT_EQ(DRIZZLE_RETURN_OK, drizzle_pipeline_flush(con));
+
+  drizzle_query(con, "SELECT 4", 0, &ret);
+  ASSERT_EQ_(DRIZZLE_RETURN_NOT_READY, ret, "query accepted while pipelined results are pending");
+
+  result= drizzle_pipeline_result(con, &ret);
+  ASSERT_EQ_(DRIZZLE_RETURN_OK, ret, "SELECT 1 (%s)", drizzle_error(con));
+  check_value(result, "1");
+
+  result= drizzle_pipeline_result(con, &ret);
+  ASSERT_EQ_(DRIZZLE_RETURN_ERROR_CODE, ret, "SELEC 2 (%s)", drizzle_error(con));
+  drizzle_result_free(result);
+
+  /* Queued behind the batch in flight, sent once it has been read. */
+  ASSERT_EQ(DRIZZLE_RETURN_OK, drizzle_pipeline_query(con, "SELECT 5", 0));
+
+  result= drizzle_pipeline_result(con, &ret);
+  ASSERT_EQ_(DRIZZLE_RETURN_OK, ret, "SELECT 3 (%s)", drizzle_error(con));
+  check_value(result, "3");
+
+  result= drizzle_pipeline_result(con, &ret);
+  ASSERT_EQ_(DRIZZLE_RETURN_OK, ret, "SELECT 5 (%s)", drizzle_error(con));
+  check_value(result, "5");
+
+  result= drizzle_pipeline_result(con, &ret);
+  ASSERT_NULL_(result, "result returned from an empty pipeline");
+  ASSERT_EQ(DRIZZLE_RETURN_OK, ret);
+
+  /* Prepared statement executions are pipelined the same way. */
+  drizzle_stmt_st *stmt= drizzle_stmt_prepare(con, "SELECT ? + 1", 12, &ret);
+  ASSERT_EQ_(DRIZZLE_RETURN_OK, ret, "drizzle_stmt_prepare(): %s", drizzle_error(con));
+  for (uint32_t x= 0; x < 3; x++)
+  {
+    ASSERT_EQ(DRIZZLE_RETURN_OK, drizzle_stmt_set_int(stmt, 0, x, false));
+    ASSERT_EQ(DRIZZLE_RETURN_OK, drizzle_pipeline_stmt_execute(stmt));
+  }
+  for (uint32_t x= 0; x < 3; x++)
+  {
+    drizzle_pipeline_result(con, &ret);
+    ASSERT_EQ_(DRIZZLE_RETURN_OK, ret, "execute %u (%s)", x, drizzle_error(con));
+    ASSERT_EQ(DRIZZLE_RETURN_OK, drizzle_stmt_fetch(stmt));
+    ASSERT_EQ(x + 1, drizzle_stmt_get_bigint(stmt, 0, &ret));
+    ASSERT_EQ(DRIZZLE_RETURN_ROW_END, drizzle_stmt_fetch(stmt));
+  }
+  ASSERT_EQ(DRIZZLE_RETURN_OK, drizzle_stmt_close(stmt));
+
+  /* A batch and its results both larger than the socket buffers go out in
+     pieces, as the results are read. */
+  char query[4096];
+  snprintf(query, sizeof(query), "SELECT REPEAT('x', 65536) /* %4000s */", "");
+  for (uint32_t x= 0; x < 500; x++)
+  {
+    ASSERT_EQ(DRIZZLE_RETURN_OK, drizzle_pipeline_query(con, query, 0));
+  }
+  ASSERT_EQ(DRIZZLE_RETURN_OK, drizzle_pipeline_flush(con));
+  for (uint32_t x= 0; x < 500; x++)
+  {
+    result= drizzle_pipeline_result(con, &ret);
+    ASSERT_EQ_(DRIZZLE_RETURN_OK, ret, "query %u (%s)", x, drizzle_error(con));
+    ASSERT_EQ(DRIZZLE_RETURN_OK, drizzle_result_buffer(result));
+    ASSERT_NOT_NULL_(drizzle_row_next(result), "no row returned");
+    ASSERT_EQ(65536, drizzle_row_field_sizes(result)[0]);
+    drizzle_result_free(result);
+  }
+  ASSERT_EQ(0, drizzle_pipeline_count(con));
+
+  drizzle_quit(con);
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,220 @@
+/* vim:expandtab:shiftwidth=2:tabstop=2:smarttab:
+ *
+ * Drizzle Client & Protocol Library
+ *
+ * Copyright (C) 2013 Drizzle Developer Group
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following disclaimer
+ * in the documentation and/or other materials provided with the
+ * distribution.
+ *
+ *     * The names of its contributors may not be used to endorse or
+ * promote products derived from this software without specific prior
+ * written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <yatl/lite.h>
+
+#include <libdrizzle-5.1/libdrizzle.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+static drizzle_st *_create(drizzle_options_st *opts)
+{
+  drizzle_st *con= drizzle_create(getenv("MYSQL_SERVER"),
+                                  getenv("MYSQL_PORT") ? atoi(getenv("MYSQL_PORT"))
+                                                       : DRIZZLE_DEFAULT_TCP_PORT,
+                                  getenv("MYSQL_USER"),
+                                  getenv("MYSQL_PASSWORD"),
+                                  getenv("MYSQL_SCHEMA"), opts);
+  ASSERT_NOT_NULL_(con, "Drizzle connection object creation error");
+  return con;
+}
+
+static size_t _wait(drizzle_reactor_st *reactor, drizzle_st **ready,
+                    size_t ready_size)
+{
+  drizzle_return_t ret;
+
+  size_t count= drizzle_reactor_wait(reactor, ready, ready_size, 5000, &ret);
+  ASSERT_EQ_(DRIZZLE_RETURN_OK, ret, "drizzle_reactor_wait(): %s",
+             drizzle_strerror(ret));
+  ASSERT_TRUE_(count > 0, "drizzle_reactor_wait() returned no connection");
+  return count;
+}
+
+int main(int argc, char* argv[])
+{
+  (void)argc;
+  (void)argv;
+  drizzle_return_t ret;
+  drizzle_st *ready[2];
+
+  drizzle_reactor_st *reactor= drizzle_reactor_create();
+  ASSERT_NOT_NULL_(reactor, "Reactor creation error");
+
+  drizzle_reactor_wait(reactor, ready, 2, 0, &ret);
+  ASSERT_EQ_(DRIZZLE_RETURN_NO_ACTIVE_CONNECTIONS, ret, "empty reactor: %s", drizzle_strerror(ret));
+
+  drizzle_st *con= _create(NULL);
+  drizzle_st *other= _create(NULL);
+
+  ASSERT_EQ(DRIZZLE_RETURN_OK, drizzle_reactor_add(reactor, con));
+  ASSERT_EQ(DRIZZLE_RETURN_INVALID_ARGUMENT, drizzle_reactor_add(reactor, con));
+  ASSERT_EQ(DRIZZLE_RETURN_OK, drizzle_reactor_add(reactor, other));
+
+  /* Nothing is waiting for I/O yet. */
+  size_t count= drizzle_reactor_wait(reactor, ready, 2, 0, &ret);
+  ASSERT_EQ(0, count);
+  ASSERT_EQ_(DRIZZLE_RETURN_TIMEOUT, ret, "idle reactor: %s", drizzle_strerror(ret));
+
+  ASSERT_EQ(DRIZZLE_RETURN_OK, drizzle_reactor_remove(reactor, con));
+  ASSERT_EQ(DRIZZLE_RETURN_INVALID_ARGUMENT, drizzle_reactor_remove(reactor, con));
+
+  /* Freeing a registered connection detaches it. */
+  drizzle_quit(other);
+  drizzle_reactor_wait(reactor, ready, 2, 0, &ret);
+  ASSERT_EQ_(DRIZZLE_RETURN_NO_ACTIVE_CONNECTIONS, ret, "empty reactor: %s", drizzle_strerror(ret));
+
+  drizzle_quit(con);
+
+  /* Two non-blocking queries driven to completion by the reactor. */
+  drizzle_options_st *opts= drizzle_options_create();
+  ASSERT_NOT_NULL_(opts, "Failed to create the options");
+  drizzle_options_set_non_blocking(opts, true);
+  drizzle_st *cons[2]= { _create(opts), _create(opts) };
+  drizzle_options_destroy(opts);
+
+  for (size_t it= 0; it < 2; it++)
+  {
+    ASSERT_EQ(DRIZZLE_RETURN_OK, drizzle_reactor_add(reactor, cons[it]));
+  }
+
+  bool connected[2]= { false, false };
+  while (!connected[0] || !connected[1])
+  {
+    for (size_t it= 0; it < 2; it++)
+    {
+      if (connected[it])
+      {
+        continue;
+      }
+
+      ret= drizzle_connect(cons[it]);
+      if (ret == DRIZZLE_RETURN_COULD_NOT_CONNECT)
+      {
+        char error[DRIZZLE_MAX_ERROR_SIZE];
+        strncpy(error, drizzle_error(cons[it]), DRIZZLE_MAX_ERROR_SIZE);
+        drizzle_quit(cons[0]);
+        drizzle_quit(cons[1]);
+        drizzle_reactor_free(reactor);
+        SKIP_IF_(ret == DRIZZLE_RETURN_COULD_NOT_CONNECT, "%s(%s)", error,
+                 drizzle_strerror(ret));
+      }
+      if (ret != DRIZZLE_RETURN_IO_WAIT)
+      {
+        ASSERT_EQ_(DRIZZLE_RETURN_OK, ret, "drizzle_connect(): %s(%s)",
+                   drizzle_error(cons[it]), drizzle_strerror(ret));
+        connected[it]= true;
+      }
+    }
+
+    if (!connected[0] || !connected[1])
+    {
+      _wait(reactor, ready, 2);
+    }
+  }
+
+  /* A non-blocking query returns before reading its result. */
+  const char *queries[2]= { "SELECT 1", "SELECT 2" };
+  drizzle_result_st *results[2];
+  for (size_t it= 0; it < 2; it++)
+  {
+    results[it]= drizzle_query(cons[it], queries[it], 0, &ret);
+    ASSERT_EQ_(DRIZZLE_RETURN_IO_WAIT, ret, "%s: %s", queries[it],
+               drizzle_strerror(ret));
+  }
+
+  /* Both results are in by now and come back from a single wait. */
+  usleep(200 * 1000);
+  count= _wait(reactor, ready, 2);
+  ASSERT_TRUE_(count == 2, "%zu of 2 connections ready", count);
+  ASSERT_TRUE_(ready[0] != ready[1], "connection returned twice");
+
+  /* Calling drizzle_query() again goes on with the query in progress, up
+     to the column definitions, then the rows are buffered. */
+  bool queried[2]= { false, false };
+  bool done[2]= { false, false };
+  while (!done[0] || !done[1])
+  {
+    for (size_t it= 0; it < 2; it++)
+    {
+      if (!queried[it])
+      {
+        results[it]= drizzle_query(cons[it], queries[it], 0, &ret);
+        if (ret == DRIZZLE_RETURN_IO_WAIT)
+        {
+          continue;
+        }
+        ASSERT_EQ_(DRIZZLE_RETURN_OK, ret, "%s: %s", queries[it],
+                   drizzle_error(cons[it]));
+        queried[it]= true;
+      }
+
+      if (!done[it])
+      {
+        ret= drizzle_result_buffer(results[it]);
+        if (ret == DRIZZLE_RETURN_IO_WAIT)
+        {
+          continue;
+        }
+        ASSERT_EQ_(DRIZZLE_RETURN_OK, ret, "drizzle_result_buffer(): %s",
+                   drizzle_error(cons[it]));
+        done[it]= true;
+      }
+    }
+
+    if (!done[0] || !done[1])
+    {
+      _wait(reactor, ready, 2);
+    }
+  }
+
+  for (size_t it= 0; it < 2; it++)
+  {
+    drizzle_row_t row= drizzle_row_next(results[it]);
+    ASSERT_NOT_NULL_(row, "no row returned for %s", queries[it]);
+    ASSERT_EQ_(strcmp(row[0], queries[it] + strlen("SELECT ")), 0,
+               "Retrieved bad row value for %s", queries[it]);
+    drizzle_result_free(results[it]);
+    drizzle_quit(cons[it]);
+  }
+
+  drizzle_reactor_free(reactor);
+
+  return EXIT_SUCCESS;
+}
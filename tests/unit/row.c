@@ -151,6 +151,17 @@ int main(int argc, char *argv[])
   size_t *sizes = drizzle_row_field_sizes(result);
   ASSERT_EQ(sizes[0], 1);
 
+  drizzle_field_t field= drizzle_row_field_by_name(result, row, "a", &ret);
+  ASSERT_EQ(DRIZZLE_RETURN_OK, ret);
+  if (field == NULL || strcmp(field, "2") != 0)
+  {
+    printf("Retrieved bad field by name\n");
+    return EXIT_FAILURE;
+  }
+  ASSERT_NULL_(drizzle_row_field_by_name(result, row, "b", &ret),
+               "Found a field of a column that does not exist");
+  ASSERT_EQ(DRIZZLE_RETURN_NOT_FOUND, ret);
+
   drizzle_result_free(result);
 
   drizzle_query(con, "DROP TABLE test_row.t1", 0, &ret);
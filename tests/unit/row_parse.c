@@ -0,0 +1,354 @@
+/* vim:expandtab:shiftwidth=2:tabstop=2:smarttab:
+ *
+ * Drizzle Client & Protocol Library
+ *
+ * Copyright (C) 2013 Drizzle Developer Group
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following disclaimer
+ * in the documentation and/or other materials provided with the
+ * distribution.
+ *
+ *     * The names of its contributors may not be used to endorse or
+ * promote products derived from this software without specific prior
+ * written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <yatl/lite.h>
+
+#include <libdrizzle-5.1/libdrizzle.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CHECKED_QUERY(cmd) \
+  result = drizzle_query(con, cmd, 0, &ret); \
+  ASSERT_EQ_(ret, DRIZZLE_RETURN_OK, "Error (%s): %s, from \"%s\"", \
+             drizzle_strerror(ret), drizzle_error(con), cmd);
+
+#define SELECT_ALL "SELECT a, b, c FROM test_row_parse.t1 ORDER BY a"
+#define ROWS 2500
+#define COLUMNS 3
+
+/* Column b of every seventh row is NULL, the others are long enough for the
+   rows to straddle the reads of a low footprint connection and for the
+   result to be larger than the buffer of a normal one. */
+static bool b_is_null(int a)
+{
+  return a % 7 == 3;
+}
+
+static size_t b_length(int a)
+{
+  return (size_t)(a * 97) % 3000 + 1;
+}
+
+typedef struct
+{
+  char *fields[COLUMNS];
+  size_t sizes[COLUMNS];
+} saved_row_st;
+
+static saved_row_st saved[ROWS];
+
+/* Read the rows with drizzle_row_buffer(), which parses the rows that are
+   whole in the receive buffer in place and leaves the others to the state
+   machine. The fields are copied as the next row reuses them. */
+static void save_rows(drizzle_result_st *result)
+{
+  drizzle_return_t ret;
+  drizzle_row_t row;
+  int count= 0;
+
+  while ((row= drizzle_row_buffer(result, &ret)) != NULL)
+  {
+    ASSERT_TRUE_(count < ROWS, "more than %d rows", ROWS);
+    size_t *sizes= drizzle_row_field_sizes(result);
+    for (uint16_t column= 0; column < COLUMNS; column++)
+    {
+      saved[count].sizes[column]= sizes[column];
+      saved[count].fields[column]= NULL;
+      if (row[column] != NULL)
+      {
+        saved[count].fields[column]= (char *)malloc(sizes[column] + 1);
+        ASSERT_NOT_NULL_(saved[count].fields[column], "Failed to allocate");
+        memcpy(saved[count].fields[column], row[column], sizes[column]);
+      }
+    }
+    count++;
+  }
+  ASSERT_EQ_(DRIZZLE_RETURN_OK, ret, "drizzle_row_buffer(): %s",
+             drizzle_strerror(ret));
+  ASSERT_EQ_(ROWS, count, "read %d rows", count);
+}
+
+/* Read the rows field by field, only through the state machine, and compare
+   them with the saved rows. */
+static void compare_rows(drizzle_result_st *result)
+{
+  drizzle_return_t ret;
+  int count= 0;
+
+  while (drizzle_row_read(result, &ret) != 0 && ret == DRIZZLE_RETURN_OK)
+  {
+    ASSERT_TRUE_(count < ROWS, "more than %d rows", ROWS);
+    uint16_t column= 0;
+    while (1)
+    {
+      size_t total;
+      drizzle_field_t field= drizzle_field_buffer(result, &total, &ret);
+      if (ret == DRIZZLE_RETURN_ROW_END)
+      {
+        break;
+      }
+      ASSERT_EQ_(DRIZZLE_RETURN_OK, ret, "drizzle_field_buffer(): %s",
+                 drizzle_strerror(ret));
+      ASSERT_TRUE_(column < COLUMNS, "row %d has too many fields", count);
+
+      if (field == NULL)
+      {
+        ASSERT_NULL_(saved[count].fields[column],
+                     "row %d field %u is only NULL in the state machine",
+                     count, column);
+      }
+      else
+      {
+        ASSERT_NOT_NULL_(saved[count].fields[column],
+                         "row %d field %u is only NULL in the fast path",
+                         count, column);
+        ASSERT_TRUE_(saved[count].sizes[column] == total,
+                     "row %d field %u has %zu bytes, not %zu", count, column,
+                     saved[count].sizes[column], total);
+        ASSERT_EQ_(0, memcmp(saved[count].fields[column], field, total),
+                   "row %d field %u differs", count, column);
+      }
+      column++;
+    }
+
+    /* The NULL columns of a binary row are no fields at all. */
+    for (; column < COLUMNS; column++)
+    {
+      ASSERT_NULL_(saved[count].fields[column],
+                   "row %d field %u is only in the fast path", count, column);
+    }
+    count++;
+  }
+  ASSERT_EQ_(DRIZZLE_RETURN_OK, ret, "drizzle_row_read(): %s",
+             drizzle_strerror(ret));
+  ASSERT_EQ_(ROWS, count, "read %d rows", count);
+}
+
+static void check_int(saved_row_st *row, uint16_t column, int expected,
+                      bool binary)
+{
+  ASSERT_NOT_NULL_(row->fields[column], "field %u of row %d is NULL",
+                   column, expected);
+  if (binary)
+  {
+    const uint8_t *field= (const uint8_t *)row->fields[column];
+    ASSERT_TRUE_(row->sizes[column] == 4, "INT of %zu bytes", row->sizes[column]);
+    ASSERT_EQ(expected, (int)(field[0] | field[1] << 8 | field[2] << 16 |
+                              (uint32_t)field[3] << 24));
+  }
+  else
+  {
+    char text[16];
+    snprintf(text, sizeof(text), "%d", expected);
+    ASSERT_TRUE_(row->sizes[column] == strlen(text), "%d has %zu digits",
+                 expected, row->sizes[column]);
+    ASSERT_EQ(0, memcmp(row->fields[column], text, strlen(text)));
+  }
+}
+
+/* Check the saved rows against the table and free them. A binary row keeps
+   only the fields that are not NULL, so c moves up when b is NULL. */
+static void check_rows(bool binary)
+{
+  for (int it= 0; it < ROWS; it++)
+  {
+    saved_row_st *row= &saved[it];
+    int a= it + 1;
+    uint16_t c_column= 2;
+
+    check_int(row, 0, a, binary);
+    if (b_is_null(a))
+    {
+      if (binary)
+      {
+        c_column= 1;
+        ASSERT_NULL_(row->fields[2], "row %d has a third field", a);
+      }
+      else
+      {
+        ASSERT_NULL_(row->fields[1], "b of row %d is not NULL", a);
+      }
+    }
+    else
+    {
+      ASSERT_NOT_NULL_(row->fields[1], "b of row %d is NULL", a);
+      ASSERT_TRUE_(row->sizes[1] == b_length(a), "b of row %d has %zu bytes",
+                   a, row->sizes[1]);
+      for (size_t pos= 0; pos < b_length(a); pos++)
+      {
+        ASSERT_EQ_('a' + a % 26, row->fields[1][pos], "b of row %d", a);
+      }
+    }
+    check_int(row, c_column, a * 3, binary);
+
+    for (uint16_t column= 0; column < COLUMNS; column++)
+    {
+      free(row->fields[column]);
+    }
+  }
+}
+
+/* Read the table as text and as binary rows, each once with
+   drizzle_row_buffer() and once through the state machine only. */
+static void read_table(drizzle_st *con)
+{
+  drizzle_return_t ret;
+  drizzle_result_st *result;
+
+  /* Text rows */
+  CHECKED_QUERY(SELECT_ALL);
+  ASSERT_EQ(DRIZZLE_RETURN_OK, drizzle_column_buffer(result));
+  save_rows(result);
+  drizzle_result_free(result);
+
+  CHECKED_QUERY(SELECT_ALL);
+  ASSERT_EQ(DRIZZLE_RETURN_OK, drizzle_column_buffer(result));
+  compare_rows(result);
+  drizzle_result_free(result);
+  check_rows(false);
+
+  /* Binary rows, the NULL in the middle is only in the NULL bitmap */
+  drizzle_stmt_st *stmt= drizzle_stmt_prepare(con, SELECT_ALL,
+                                              strlen(SELECT_ALL), &ret);
+  ASSERT_EQ_(DRIZZLE_RETURN_OK, ret, "Error (%s): %s", drizzle_strerror(ret),
+             drizzle_error(con));
+
+  ret= drizzle_stmt_execute(stmt);
+  ASSERT_EQ_(DRIZZLE_RETURN_OK, ret, "Error (%s): %s", drizzle_strerror(ret),
+             drizzle_error(con));
+  save_rows(drizzle_stmt_result(stmt));
+
+  ret= drizzle_stmt_execute(stmt);
+  ASSERT_EQ_(DRIZZLE_RETURN_OK, ret, "Error (%s): %s", drizzle_strerror(ret),
+             drizzle_error(con));
+  compare_rows(drizzle_stmt_result(stmt));
+  check_rows(true);
+
+  ret= drizzle_stmt_close(stmt);
+  ASSERT_EQ_(DRIZZLE_RETURN_OK, ret, "Error (%s): %s", drizzle_strerror(ret),
+             drizzle_error(con));
+}
+
+int main(int argc, char *argv[])
+{
+  (void)argc;
+  (void)argv;
+  drizzle_return_t ret;
+  drizzle_result_st *result;
+
+  /* The buffer of a low footprint connection holds only a few rows, so most
+     reads end in the middle of one. */
+  drizzle_options_st *opts= drizzle_options_create();
+  ASSERT_NOT_NULL_(opts, "Failed to create the options");
+  drizzle_options_set_low_footprint(opts, true);
+
+  drizzle_st *con= drizzle_create(getenv("MYSQL_SERVER"),
+                                  getenv("MYSQL_PORT") ? atoi(getenv("MYSQL_PORT"))
+                                                       : DRIZZLE_DEFAULT_TCP_PORT,
+                                  getenv("MYSQL_USER"),
+                                  getenv("MYSQL_PASSWORD"),
+                                  getenv("MYSQL_SCHEMA"), opts);
+  ASSERT_NOT_NULL_(con, "Drizzle connection object creation error");
+
+  ret= drizzle_connect(con);
+  if (ret == DRIZZLE_RETURN_COULD_NOT_CONNECT)
+  {
+    char error[DRIZZLE_MAX_ERROR_SIZE];
+    strncpy(error, drizzle_error(con), DRIZZLE_MAX_ERROR_SIZE);
+    drizzle_quit(con);
+    drizzle_options_destroy(opts);
+    SKIP_IF_(ret == DRIZZLE_RETURN_COULD_NOT_CONNECT, "%s(%s)", error,
+             drizzle_strerror(ret));
+  }
+  ASSERT_EQ_(DRIZZLE_RETURN_OK, ret, "drizzle_connect(): %s(%s)",
+             drizzle_error(con), drizzle_strerror(ret));
+
+  CHECKED_QUERY("DROP SCHEMA IF EXISTS test_row_parse");
+  drizzle_result_free(result);
+  CHECKED_QUERY("CREATE SCHEMA test_row_parse");
+  drizzle_result_free(result);
+  CHECKED_QUERY("CREATE TABLE test_row_parse.t1 (a INT, b TEXT, c INT)");
+  drizzle_result_free(result);
+
+  char *insert= (char *)malloc(ROWS * 48 + 64);
+  ASSERT_NOT_NULL_(insert, "Failed to allocate");
+  size_t length= (size_t)sprintf(insert, "INSERT INTO test_row_parse.t1 VALUES ");
+  for (int a= 1; a <= ROWS; a++)
+  {
+    if (b_is_null(a))
+    {
+      length+= (size_t)sprintf(insert + length, "(%d,NULL,%d)", a, a * 3);
+    }
+    else
+    {
+      length+= (size_t)sprintf(insert + length, "(%d,REPEAT('%c',%zu),%d)",
+                               a, 'a' + a % 26, b_length(a), a * 3);
+    }
+    insert[length++]= a < ROWS ? ',' : '\0';
+  }
+  CHECKED_QUERY(insert);
+  drizzle_result_free(result);
+  free(insert);
+
+  read_table(con);
+
+  /* A normal connection reads into a mirrored ring buffer, the rows are more
+     than it holds so packets straddle the point where it wraps around. */
+  drizzle_st *mirror= drizzle_create(getenv("MYSQL_SERVER"),
+                                     getenv("MYSQL_PORT") ? atoi(getenv("MYSQL_PORT"))
+                                                          : DRIZZLE_DEFAULT_TCP_PORT,
+                                     getenv("MYSQL_USER"),
+                                     getenv("MYSQL_PASSWORD"),
+                                     getenv("MYSQL_SCHEMA"), NULL);
+  ASSERT_NOT_NULL_(mirror, "Drizzle connection object creation error");
+  ret= drizzle_connect(mirror);
+  ASSERT_EQ_(DRIZZLE_RETURN_OK, ret, "drizzle_connect(): %s(%s)",
+             drizzle_error(mirror), drizzle_strerror(ret));
+  read_table(mirror);
+  ret= drizzle_quit(mirror);
+  ASSERT_EQ_(DRIZZLE_RETURN_OK, ret, "%s", drizzle_strerror(ret));
+
+  CHECKED_QUERY("DROP SCHEMA test_row_parse");
+  drizzle_result_free(result);
+
+  ret= drizzle_quit(con);
+  ASSERT_EQ_(DRIZZLE_RETURN_OK, ret, "%s", drizzle_strerror(ret));
+  drizzle_options_destroy(opts);
+
+  return EXIT_SUCCESS;
+}
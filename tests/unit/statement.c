@@ -148,9 +148,76 @@ int main(int argc, char *argv[])
     printf("Retrieved bad number of rows\n");
     return EXIT_FAILURE;
   }
+
+  /* Executing again reuses the columns of the previous result */
+  ret = drizzle_stmt_set_int(stmt, 0, 2, false);
+  ASSERT_EQ_(DRIZZLE_RETURN_OK, ret, "%s", drizzle_error(con));
+  ret = drizzle_stmt_execute(stmt);
+  ASSERT_EQ_(DRIZZLE_RETURN_OK, ret, "%s", drizzle_error(con));
+  ret = drizzle_stmt_fetch(stmt);
+  ASSERT_EQ_(DRIZZLE_RETURN_OK, ret, "%s", drizzle_error(con));
+  ASSERT_EQ(3, drizzle_stmt_get_int_from_name(stmt, "a", &ret));
+  ASSERT_EQ_(DRIZZLE_RETURN_OK, ret, "drizzle_stmt_get_int_from_name");
+  ASSERT_EQ(DRIZZLE_RETURN_ROW_END, drizzle_stmt_fetch(stmt));
+
+  /* Changing the parameter type sends the types again, a NULL one included */
+  ret = drizzle_stmt_set_null(stmt, 0);
+  ASSERT_EQ_(DRIZZLE_RETURN_OK, ret, "%s", drizzle_error(con));
+  ret = drizzle_stmt_execute(stmt);
+  ASSERT_EQ_(DRIZZLE_RETURN_OK, ret, "%s", drizzle_error(con));
+  ASSERT_EQ(DRIZZLE_RETURN_ROW_END, drizzle_stmt_fetch(stmt));
+
+  ret = drizzle_stmt_set_bigint(stmt, 0, 0, false);
+  ASSERT_EQ_(DRIZZLE_RETURN_OK, ret, "%s", drizzle_error(con));
+  ret = drizzle_stmt_execute(stmt);
+  ASSERT_EQ_(DRIZZLE_RETURN_OK, ret, "%s", drizzle_error(con));
+  ret = drizzle_stmt_buffer(stmt);
+  ASSERT_EQ_(DRIZZLE_RETURN_OK, ret, "%s", drizzle_error(con));
+  ASSERT_EQ(3, drizzle_stmt_row_count(stmt));
+
   ret = drizzle_stmt_close(stmt);
   ASSERT_EQ_(DRIZZLE_RETURN_OK, ret, "%s", drizzle_error(con));
 
+  /* Array execution inserts a row for each element */
+  query = "INSERT INTO test_stmt.t1 VALUES (?)";
+  stmt = drizzle_stmt_prepare(con, query, strlen(query), &ret);
+  ASSERT_EQ_(DRIZZLE_RETURN_OK, ret, "%s", drizzle_error(con));
+
+  int32_t values[3] = {4, 5, 6};
+  bool nulls[3] = {false, true, true};
+  uint64_t affected_rows[3];
+  uint16_t error_codes[3];
+  ret = drizzle_stmt_set_array(stmt, 0, DRIZZLE_COLUMN_TYPE_LONG, values, 0,
+                               NULL, nulls, false);
+  ASSERT_EQ_(DRIZZLE_RETURN_OK, ret, "%s", drizzle_error(con));
+  ret = drizzle_stmt_execute_array(stmt, 3, affected_rows, error_codes);
+  ASSERT_EQ_(DRIZZLE_RETURN_OK, ret, "%s", drizzle_error(con));
+  for (i = 0; i < 3; i++)
+  {
+    ASSERT_EQ(1, affected_rows[i]);
+    ASSERT_EQ(0, error_codes[i]);
+  }
+
+  /* A value set after a NULL row of the array is not NULL */
+  ret = drizzle_stmt_set_int(stmt, 0, 7, false);
+  ASSERT_EQ_(DRIZZLE_RETURN_OK, ret, "%s", drizzle_error(con));
+  ret = drizzle_stmt_execute(stmt);
+  ASSERT_EQ_(DRIZZLE_RETURN_OK, ret, "%s", drizzle_error(con));
+  ret = drizzle_stmt_buffer(stmt);
+  ASSERT_EQ_(DRIZZLE_RETURN_OK, ret, "%s", drizzle_error(con));
+
+  ret = drizzle_stmt_close(stmt);
+  ASSERT_EQ_(DRIZZLE_RETURN_OK, ret, "%s", drizzle_error(con));
+
+  drizzle_result_st *result = drizzle_query(con,
+      "SELECT COUNT(*) FROM test_stmt.t1 WHERE a IS NULL", 0, &ret);
+  ASSERT_EQ_(DRIZZLE_RETURN_OK, ret, "%s", drizzle_error(con));
+  ASSERT_EQ(DRIZZLE_RETURN_OK, drizzle_result_buffer(result));
+  drizzle_row_t row = drizzle_row_next(result);
+  ASSERT_NOT_NULL_(row, "COUNT(*) returned no row");
+  ASSERT_EQ_(0, strcmp(row[0], "2"), "NULL rows: %s", row[0]);
+  drizzle_result_free(result);
+
   drizzle_query(con, "DROP TABLE test_stmt.t1", 0, &ret);
   ASSERT_EQ_(DRIZZLE_RETURN_OK, ret, "DROP TABLE test_stmt.t1");
 
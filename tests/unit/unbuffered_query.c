@@ -42,6 +42,27 @@
 #include <stdlib.h>
 #include <string.h>
 
+static drizzle_return_t count_rows(drizzle_result_st *result,
+                                   drizzle_row_t *rows, size_t **field_sizes,
+                                   uint32_t row_count, void *context)
+{
+  int *count = (int *)context;
+  char buf[10];
+  (void)result;
+
+  ASSERT_TRUE(row_count > 0 && row_count <= 2);
+  for (uint32_t it = 0; it < row_count; it++)
+  {
+    (*count)++;
+    snprintf(buf, 10, "%d", *count);
+    ASSERT_EQ(strlen(buf), field_sizes[it][0]);
+    ASSERT_EQ_(0, memcmp(rows[it][0], buf, field_sizes[it][0]),
+               "Retrieved bad row data");
+  }
+
+  return DRIZZLE_RETURN_OK;
+}
+
 int main(int argc, char *argv[])
 {
   (void)argc;
@@ -148,6 +169,40 @@ int main(int argc, char *argv[])
 
   drizzle_result_free(result);
 
+  /* The same rows as views into the receive buffer. */
+  result = drizzle_query(con, "SELECT * FROM test_unbuff.t1", 0, &ret);
+  ASSERT_EQ_(DRIZZLE_RETURN_OK, ret, "Select failure (%s)", drizzle_error(con));
+  ret = drizzle_column_buffer(result);
+  ASSERT_EQ_(DRIZZLE_RETURN_OK, ret, "Column buffer failure (%s)",
+             drizzle_error(con));
+
+  i = 0;
+  while ((row = drizzle_row_view(result, &ret)) != NULL)
+  {
+    size_t *sizes = drizzle_row_field_sizes(result);
+    i++;
+    snprintf(buf, 10, "%d", i);
+    ASSERT_EQ(strlen(buf), sizes[0]);
+    ASSERT_EQ_(0, memcmp(row[0], buf, sizes[0]), "Retrieved bad row data");
+  }
+  ASSERT_EQ_(DRIZZLE_RETURN_OK, ret, "drizzle_row_view(): %s",
+             drizzle_error(con));
+  ASSERT_EQ_(3, i, "Retrieved bad number of rows");
+
+  drizzle_result_free(result);
+
+  /* The same rows again, handed over two at a time. */
+  result = drizzle_query(con, "SELECT * FROM test_unbuff.t1", 0, &ret);
+  ASSERT_EQ_(DRIZZLE_RETURN_OK, ret, "Select failure (%s)", drizzle_error(con));
+
+  i = 0;
+  ret = drizzle_result_stream(result, 2, count_rows, &i);
+  ASSERT_EQ_(DRIZZLE_RETURN_OK, ret, "drizzle_result_stream(): %s",
+             drizzle_error(con));
+  ASSERT_EQ_(3, i, "Retrieved bad number of rows");
+
+  drizzle_result_free(result);
+
   drizzle_query(con, "DROP TABLE test_unbuff.t1", 0, &ret);
   ASSERT_EQ_(DRIZZLE_RETURN_OK, ret, "DROP TABLE test_unbuff.t1");
 